@@ -3,43 +3,77 @@ TEMPLATE = app
 # Configuration
 CONFIG += warn_on \
     qt
-QT += opengl
+QT += opengl \
+    network
 LIBS += -lfftw3
 
 # Source files
-SOURCES += src/colorbox.cpp \
+SOURCES += src/capturefile.cpp \
+    src/captureoverview.cpp \
+    src/captureplayer.cpp \
+    src/colorbox.cpp \
     src/configdialog.cpp \
     src/configpages.cpp \
+    src/csvwriter.cpp \
     src/dataanalyzer.cpp \
+    src/decoder.cpp \
     src/dockwindows.cpp \
     src/dsocontrol.cpp \
     src/dsowidget.cpp \
     src/exporter.cpp \
+    src/eyediagram.cpp \
+    src/framepublisher.cpp \
     src/glgenerator.cpp \
     src/glscope.cpp \
+    src/graphrenderer.cpp \
+    src/headless.cpp \
     src/helper.cpp \
     src/levelslider.cpp \
+    src/masktest.cpp \
     src/main.cpp \
     src/openhantek.cpp \
+    src/peakfinder.cpp \
+    src/recorder.cpp \
+    src/renderscheduler.cpp \
+    src/samplecodec.cpp \
+    src/scopeserver.cpp \
     src/settings.cpp \
+    src/statistics.cpp \
     src/hantek/control.cpp \
     src/hantek/device.cpp \
     src/hantek/types.cpp \
     src/dso.cpp
-HEADERS += src/colorbox.h \
+HEADERS += src/capturefile.h \
+    src/captureoverview.h \
+    src/captureplayer.h \
+    src/colorbox.h \
     src/configdialog.h \
     src/configpages.h \
+    src/csvwriter.h \
     src/dataanalyzer.h \
+    src/decoder.h \
     src/dockwindows.h \
     src/dsocontrol.h \
     src/dsowidget.h \
     src/exporter.h \
+    src/eyediagram.h \
+    src/framepublisher.h \
+    src/framering.h \
     src/glscope.h \
     src/glgenerator.h \
+    src/graphrenderer.h \
+    src/headless.h \
     src/helper.h \
     src/levelslider.h \
+    src/masktest.h \
     src/openhantek.h \
+    src/peakfinder.h \
+    src/recorder.h \
+    src/renderscheduler.h \
+    src/samplecodec.h \
+    src/scopeserver.h \
     src/settings.h \
+    src/statistics.h \
     src/hantek/control.h \
     src/hantek/device.h \
     src/hantek/types.h \
@@ -106,6 +140,7 @@ unix:!macx {
     target.path = $${PREFIX}/bin
     translations.path = $${PREFIX}/share/apps/openhantek/translations
     INCLUDEPATH += /usr/include/libusb
+    LIBS += -lrt
     DEFINES += QMAKE_TRANSLATIONS_PATH=\\\"$${translations.path}\\\" \
         OS_UNIX VERSION=\\\"$${VERSION}\\\"
 }
@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  ringreader.c
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+// Example reader for the shared memory frame ring of OpenHantek.
+// Prints the minimum, maximum and mean of each voltage channel for every frame
+// without copying the samples. Build it with
+//   cc -std=gnu99 -I../src -o ringreader ringreader.c -lrt
+// and run it with the name of the ring, /openhantek by default.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#include "framering.h"
+
+
+/// \brief Reads a sequence number written by the other process.
+/// \param sequence The sequence field in the shared memory.
+/// \return The current value.
+static uint64_t loadSequence(const volatile uint64_t *sequence) {
+	return __atomic_load_n(sequence, __ATOMIC_ACQUIRE);
+}
+
+/// \brief Waits a millisecond.
+static void waitShortly(void) {
+	struct timespec delay = {0, 1000000};
+	nanosleep(&delay, 0);
+}
+
+/// \brief Prints the statistics of the voltage channels of a frame.
+/// The values are used in place, the caller has to check afterwards if the
+/// slot has been overwritten in the meantime. Every offset is checked against
+/// the record size first, a slot that is rewritten meanwhile may contain
+/// anything.
+/// \param record The record in the slot.
+/// \param recordSize The size of the record that can be read safely.
+/// \param line The buffer the line is written to.
+/// \param size The size of the buffer.
+/// \return 0 if the record is malformed, 1 otherwise.
+static int summarize(const FrameRingRecord *record, uint64_t recordSize, char *line, size_t size) {
+	if(recordSize < sizeof(FrameRingRecord))
+		return 0;
+	uint64_t headerSize = record->headerSize;
+	uint64_t channelSize = record->channelSize;
+	uint64_t channelCount = record->channelCount;
+	if(headerSize < sizeof(FrameRingRecord) || channelSize < sizeof(FrameRingChannel) || headerSize + channelCount * channelSize > recordSize)
+		return 0;
+	
+	size_t length = 0;
+	for(uint64_t index = 0; index < channelCount && length < size; index++) {
+		FrameRingChannel channel;
+		memcpy(&channel, (const char *) record + headerSize + index * channelSize, sizeof(channel));
+		if(channel.mode != 0 || !channel.count)
+			continue;
+		if(channel.dataOffset > recordSize || channel.count > (recordSize - channel.dataOffset) / sizeof(double))
+			return 0;
+		
+		const double *values = (const double *) ((const char *) record + channel.dataOffset);
+		double sum = 0;
+		for(uint64_t position = 0; position < channel.count; position++)
+			sum += values[position];
+		
+		length += snprintf(line + length, size - length, "  %.*s: %g / %g / %g V", (int) sizeof(channel.name), channel.name, channel.minimum, channel.maximum, sum / channel.count);
+	}
+	
+	return 1;
+}
+
+int main(int argc, char *argv[]) {
+	const char *name = argc > 1 ? argv[1] : FRAMERING_NAME;
+	
+	int descriptor = shm_open(name, O_RDONLY, 0);
+	if(descriptor < 0) {
+		perror(name);
+		return 1;
+	}
+	struct stat status;
+	if(fstat(descriptor, &status) < 0 || (size_t) status.st_size < sizeof(FrameRingHeader)) {
+		fprintf(stderr, "%s: The ring isn't ready\n", name);
+		return 1;
+	}
+	const char *map = mmap(0, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+	close(descriptor);
+	if(map == MAP_FAILED) {
+		perror(name);
+		return 1;
+	}
+	
+	const FrameRingHeader *header = (const FrameRingHeader *) map;
+	while(memcmp((const char *) header->magic, FRAMERING_MAGIC, sizeof(header->magic)))
+		waitShortly();
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if(header->version != FRAMERING_VERSION) {
+		fprintf(stderr, "%s: Unsupported version %u\n", name, header->version);
+		return 1;
+	}
+	uint64_t slotCount = header->slotCount;
+	uint64_t slotSize = header->slotSize;
+	if(!slotCount || slotSize < sizeof(FrameRingSlot) || header->headerSize < sizeof(FrameRingHeader) || header->headerSize > (uint64_t) status.st_size || slotSize > ((uint64_t) status.st_size - header->headerSize) / slotCount) {
+		fprintf(stderr, "%s: Invalid ring layout\n", name);
+		return 1;
+	}
+	
+	uint64_t last = loadSequence(&header->sequence);
+	uint64_t lost = 0;
+	while(!__atomic_load_n(&header->closed, __ATOMIC_ACQUIRE)) {
+		uint64_t newest = loadSequence(&header->sequence);
+		if(newest == last) {
+			waitShortly();
+			continue;
+		}
+		
+		// Frames older than the ring are already overwritten
+		if(newest - last > slotCount) {
+			lost += newest - last - slotCount;
+			last = newest - slotCount;
+		}
+		
+		for(uint64_t frame = last + 1; frame <= newest; frame++) {
+			const FrameRingSlot *slot = (const FrameRingSlot *) (map + header->headerSize + (frame % slotCount) * slotSize);
+			if(loadSequence(&slot->sequence) != frame) {
+				lost++;
+				continue;
+			}
+			
+			// The record has to fit into the slot, even if the size is garbage
+			uint64_t recordSize = slot->size;
+			if(recordSize > slotSize - sizeof(FrameRingSlot))
+				recordSize = 0;
+			char line[1024] = "";
+			int valid = summarize((const FrameRingRecord *) (slot + 1), recordSize, line, sizeof(line));
+			
+			// Discard the results if the writer reused the slot meanwhile
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if(loadSequence(&slot->sequence) != frame) {
+				lost++;
+				continue;
+			}
+			if(!valid) {
+				fprintf(stderr, "%s: Frame %llu is malformed\n", name, (unsigned long long) frame);
+				continue;
+			}
+			printf("%llu%s\n", (unsigned long long) frame, line);
+		}
+		last = newest;
+		fflush(stdout);
+	}
+	
+	fprintf(stderr, "%s: Closed, %llu frames lost\n", name, (unsigned long long) lost);
+	munmap((void *) map, status.st_size);
+	
+	return 0;
+}
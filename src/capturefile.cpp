@@ -0,0 +1,484 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  capturefile.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cstring>
+
+#include <QDateTime>
+#include <QFile>
+#include <QMutex>
+
+
+#include "capturefile.h"
+
+#include "dataanalyzer.h"
+#include "dso.h"
+#include "samplecodec.h"
+#include "settings.h"
+
+
+/// \brief Copies a name into a null terminated name field.
+/// \param target The name field with #CAPTURE_NAME_LENGTH bytes.
+/// \param name The name that should be stored, it's truncated if too long.
+static void copyName(char *target, const QString &name) {
+	QByteArray text = name.toUtf8();
+	int length = qMin(text.size(), CAPTURE_NAME_LENGTH - 1);
+	memcpy(target, text.constData(), length);
+	target[length] = 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class CaptureFile
+/// \brief Initializes an empty capture.
+CaptureFile::CaptureFile() {
+	this->file = 0;
+	this->map = 0;
+	this->mapSize = 0;
+	this->convertedRecord = 0;
+}
+
+/// \brief Unmaps the file and cleans up.
+CaptureFile::~CaptureFile() {
+	this->close();
+}
+
+/// \brief Maps a capture file into memory and finds its records.
+/// A truncated record at the end of an interrupted recording is ignored.
+/// \param filename The name of the capture file.
+/// \return true if the file contains at least one valid record.
+bool CaptureFile::open(const QString &filename) {
+	this->close();
+	
+	this->file = new QFile(filename);
+	if(!this->file->open(QIODevice::ReadOnly) || this->file->size() < (qint64) sizeof(CaptureHeader)) {
+		this->close();
+		return false;
+	}
+	this->mapSize = this->file->size();
+	this->map = this->file->map(0, this->mapSize);
+	if(!this->map) {
+		this->close();
+		return false;
+	}
+	
+	// Walk through the records, each header is checked before it's used
+	qint64 position = 0;
+	while(this->checkRecord(position)) {
+		this->records.append(position);
+		position += ((const CaptureHeader *) (this->map + position))->recordSize;
+	}
+	
+	if(this->records.isEmpty()) {
+		this->close();
+		return false;
+	}
+	
+	return true;
+}
+
+/// \brief Unmaps and closes the file.
+void CaptureFile::close() {
+	for(int index = 0; index < this->converted.count(); index++)
+		delete[] this->converted[index];
+	this->converted.clear();
+	this->records.clear();
+	
+	if(this->file) {
+		if(this->map)
+			this->file->unmap((uchar *) this->map);
+		delete this->file;
+		this->file = 0;
+	}
+	this->map = 0;
+	this->mapSize = 0;
+}
+
+/// \brief Get the number of records.
+/// \return The number of frames in the file.
+unsigned int CaptureFile::recordCount() const {
+	return this->records.count();
+}
+
+/// \brief Get the header of a record.
+/// \param record The index of the record.
+/// \return The header, 0 if the record doesn't exist.
+const CaptureHeader *CaptureFile::header(unsigned int record) const {
+	if(record >= (unsigned int) this->records.count())
+		return 0;
+	
+	return (const CaptureHeader *) (this->map + this->records[record]);
+}
+
+/// \brief Get the number of value arrays of a record.
+/// \param record The index of the record.
+/// \return The number of entries in the channel table.
+unsigned int CaptureFile::channelCount(unsigned int record) const {
+	const CaptureHeader *header = this->header(record);
+	if(!header)
+		return 0;
+	
+	return header->channelCount;
+}
+
+/// \brief Get the description of a value array.
+/// \param index The index of the channel table entry.
+/// \param record The index of the record.
+/// \return The channel table entry, 0 if the index is invalid.
+const CaptureChannel *CaptureFile::channel(unsigned int index, unsigned int record) const {
+	if(index >= this->channelCount(record))
+		return 0;
+	
+	const CaptureHeader *header = this->header(record);
+	return (const CaptureChannel *) ((const uchar *) header + header->headerSize + index * header->channelSize);
+}
+
+/// \brief Get the values of a channel as they are stored in the file.
+/// \param index The index of the channel table entry.
+/// \param record The index of the record.
+/// \return The mapped values, 0 if the index is invalid.
+const void *CaptureFile::values(unsigned int index, unsigned int record) const {
+	if(index >= this->channelCount(record))
+		return 0;
+	
+	return this->map + this->records[record] + this->channel(index, record)->dataOffset;
+}
+
+/// \brief Get the values of a channel as used by the data analyzer.
+/// 64 bit values point directly into the mapped file and must not be changed,
+/// all other formats are converted on the first access. Only the converted
+/// values of the last accessed record are kept.
+/// \param index The index of the channel table entry.
+/// \param samples The sample values that are set up.
+/// \param record The index of the record.
+/// \return true if the index is valid and the values could be unpacked.
+bool CaptureFile::samples(unsigned int index, SampleValues *samples, unsigned int record) {
+	if(index >= this->channelCount(record))
+		return false;
+	
+	const CaptureChannel *channel = this->channel(index, record);
+	samples->count = channel->count;
+	samples->interval = channel->interval;
+	
+	if(channel->format == CAPTURE_FORMAT_FLOAT64) {
+		samples->sample = (double *) this->values(index, record);
+		return true;
+	}
+	
+	if(record != this->convertedRecord || this->converted.isEmpty()) {
+		for(int channelIndex = 0; channelIndex < this->converted.count(); channelIndex++)
+			delete[] this->converted[channelIndex];
+		this->converted.clear();
+		for(unsigned int channelIndex = 0; channelIndex < this->channelCount(record); channelIndex++)
+			this->converted.append(0);
+		this->convertedRecord = record;
+	}
+	
+	if(!this->converted[index]) {
+		double *buffer = new double[channel->count];
+		const void *values = this->values(index, record);
+		
+		switch(channel->format) {
+			case CAPTURE_FORMAT_FLOAT32:
+				for(unsigned int position = 0; position < samples->count; position++)
+					buffer[position] = ((const float *) values)[position];
+				break;
+			case CAPTURE_FORMAT_CODE8:
+				for(unsigned int position = 0; position < samples->count; position++)
+					buffer[position] = ((const quint8 *) values)[position] * channel->scale + channel->zero;
+				break;
+			case CAPTURE_FORMAT_CODE16:
+				for(unsigned int position = 0; position < samples->count; position++)
+					buffer[position] = ((const quint16 *) values)[position] * channel->scale + channel->zero;
+				break;
+			case CAPTURE_FORMAT_PACKED:
+				if(!SampleCodec::decode((const uchar *) values, channel->dataSize, buffer, samples->count)) {
+					delete[] buffer;
+					samples->sample = 0;
+					return false;
+				}
+				break;
+			default:
+				break;
+		}
+		
+		this->converted[index] = buffer;
+	}
+	samples->sample = this->converted[index];
+	
+	return true;
+}
+
+/// \brief Writes the current data of the analyzer into a capture file.
+/// The analyzed values are stored as 64 bit values, so they can be used
+/// without conversion when the file is opened again.
+/// \param filename The name of the capture file.
+/// \param settings The settings with the channel names, gains and offsets.
+/// \param dataAnalyzer The data analyzer with the captured values.
+/// \return true if the file was written successfully.
+bool CaptureFile::write(const QString &filename, DsoSettings *settings, DataAnalyzer *dataAnalyzer) {
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly))
+		return false;
+	
+	CaptureRecord record;
+	dataAnalyzer->mutex()->lock();
+	CaptureFile::collect(settings, dataAnalyzer, &record, false);
+	bool success = CaptureFile::writeRecord(&file, &record);
+	dataAnalyzer->mutex()->unlock();
+	
+	file.close();
+	
+	return success;
+}
+
+/// \brief Prepares a record with the used channels of the analyzed data.
+/// The analyzed data has to be locked by the caller.
+/// \param settings The settings with the channel names, gains and offsets.
+/// \param dataAnalyzer The data analyzer with the captured values.
+/// \param record The record that is filled.
+/// \param copy true if the values should be copied into the record.
+void CaptureFile::collect(DsoSettings *settings, DataAnalyzer *dataAnalyzer, CaptureRecord *record, bool copy) {
+	CaptureHeader *header = &(record->header);
+	memset(header, 0, sizeof(CaptureHeader));
+	memcpy(header->magic, CAPTURE_MAGIC, sizeof(header->magic));
+	header->version = CAPTURE_VERSION;
+	header->byteOrder = CAPTURE_BYTEORDER;
+	header->headerSize = sizeof(CaptureHeader);
+	header->channelSize = sizeof(CaptureChannel);
+	QDateTime now = QDateTime::currentDateTime().toUTC();
+	header->timestamp = (qint64) now.toTime_t() * 1000 + now.time().msec();
+	header->samplerate = settings->scope.horizontal.samplerate;
+	header->triggerTime = settings->scope.trigger.position * settings->scope.horizontal.timebase * DIVS_TIME;
+	copyName(header->model, settings->scope.model);
+	
+	// Build the channel table for the used voltage and spectrum channels
+	record->channels.clear();
+	record->values.clear();
+	for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
+		for(int index = 0; index < settings->scope.voltage.count(); index++) {
+			const AnalyzedData *analyzedData = dataAnalyzer->data(index);
+			if(!analyzedData)
+				continue;
+			
+			CaptureChannel channel;
+			memset(&channel, 0, sizeof(channel));
+			const SampleValues *samples;
+			if(mode == Dso::CHANNELMODE_VOLTAGE) {
+				if(!settings->scope.voltage[index].used)
+					continue;
+				copyName(channel.name, settings->scope.voltage[index].name);
+				channel.gain = settings->scope.voltage[index].gain;
+				channel.offset = settings->scope.voltage[index].offset;
+				channel.amplitude = analyzedData->amplitude;
+				channel.frequency = analyzedData->frequency;
+				samples = &(analyzedData->samples.voltage);
+			}
+			else {
+				if(!settings->scope.spectrum[index].used)
+					continue;
+				copyName(channel.name, settings->scope.spectrum[index].name);
+				channel.gain = settings->scope.spectrum[index].magnitude;
+				channel.offset = settings->scope.spectrum[index].offset;
+				samples = &(analyzedData->samples.spectrum);
+			}
+			channel.mode = mode;
+			channel.format = CAPTURE_FORMAT_FLOAT64;
+			channel.index = index;
+			channel.count = samples->sample ? samples->count : 0;
+			channel.dataSize = channel.count * sizeof(double);
+			channel.interval = samples->interval;
+			channel.scale = 1;
+			channel.zero = 0;
+			if(channel.count) {
+				channel.minimum = samples->sample[0];
+				channel.maximum = samples->sample[0];
+				for(unsigned int position = 1; position < channel.count; position++) {
+					if(samples->sample[position] < channel.minimum)
+						channel.minimum = samples->sample[position];
+					else if(samples->sample[position] > channel.maximum)
+						channel.maximum = samples->sample[position];
+				}
+			}
+			
+			record->channels.append(channel);
+			record->values.append(samples->sample);
+		}
+	}
+	header->channelCount = record->channels.count();
+	CaptureFile::layout(record);
+	
+	// Keep a copy if the values are needed after the data is unlocked again
+	if(copy) {
+		quint64 valueCount = 0;
+		for(int index = 0; index < record->channels.count(); index++)
+			valueCount += record->channels[index].count;
+		
+		record->buffer.resize(valueCount);
+		double *buffer = record->buffer.data();
+		for(int index = 0; index < record->channels.count(); index++) {
+			if(record->channels[index].count)
+				memcpy(buffer, record->values[index], record->channels[index].count * sizeof(double));
+			record->values[index] = buffer;
+			buffer += record->channels[index].count;
+		}
+	}
+}
+
+/// \brief Packs the voltage values of a prepared record losslessly.
+/// The samples of the oscilloscope only have a few distinct values, they are
+/// packed by the SampleCodec. Channels that don't get smaller, like spectra,
+/// are kept as 64 bit values.
+/// \param record The record with 64 bit values.
+void CaptureFile::pack(CaptureRecord *record) {
+	if(record->packed.count() < record->channels.count())
+		record->packed.resize(record->channels.count());
+	
+	for(int index = 0; index < record->channels.count(); index++) {
+		CaptureChannel *channel = &(record->channels[index]);
+		if(channel->mode != Dso::CHANNELMODE_VOLTAGE || channel->format != CAPTURE_FORMAT_FLOAT64 || !channel->count)
+			continue;
+		
+		if(SampleCodec::encode((const double *) record->values[index], channel->count, &(record->packed[index]))) {
+			channel->format = CAPTURE_FORMAT_PACKED;
+			channel->dataSize = record->packed[index].size();
+			record->values[index] = record->packed[index].constData();
+		}
+	}
+	
+	CaptureFile::layout(record);
+}
+
+/// \brief Writes a prepared record.
+/// \param device The file the record is appended to.
+/// \param record The record that should be written.
+/// \return true if the record was written completely.
+bool CaptureFile::writeRecord(QIODevice *device, const CaptureRecord *record) {
+	static const char padding[CAPTURE_ALIGNMENT] = {0};
+	
+	bool success = device->write((const char *) &(record->header), sizeof(CaptureHeader)) == sizeof(CaptureHeader);
+	for(int index = 0; success && index < record->channels.count(); index++)
+		success = device->write((const char *) &(record->channels[index]), sizeof(CaptureChannel)) == sizeof(CaptureChannel);
+	
+	quint64 position = sizeof(CaptureHeader) + record->channels.count() * sizeof(CaptureChannel);
+	for(int index = 0; success && index < record->channels.count(); index++) {
+		qint64 paddingSize = record->channels[index].dataOffset - position;
+		qint64 size = record->channels[index].dataSize;
+		success = device->write(padding, paddingSize) == paddingSize
+				&& device->write((const char *) record->values[index], size) == size;
+		position = record->channels[index].dataOffset + size;
+	}
+	
+	// Pad the record, so the next header is aligned too
+	if(success) {
+		qint64 paddingSize = record->header.recordSize - position;
+		success = device->write(padding, paddingSize) == paddingSize;
+	}
+	
+	return success;
+}
+
+/// \brief Copies a prepared record into memory.
+/// \param buffer The memory, at least record->header.recordSize bytes large.
+/// \param record The record that should be copied.
+void CaptureFile::writeRecord(uchar *buffer, const CaptureRecord *record) {
+	memcpy(buffer, &(record->header), sizeof(CaptureHeader));
+	quint64 position = sizeof(CaptureHeader);
+	for(int index = 0; index < record->channels.count(); index++) {
+		memcpy(buffer + position, &(record->channels[index]), sizeof(CaptureChannel));
+		position += sizeof(CaptureChannel);
+	}
+	
+	for(int index = 0; index < record->channels.count(); index++) {
+		memset(buffer + position, 0, record->channels[index].dataOffset - position);
+		memcpy(buffer + record->channels[index].dataOffset, record->values[index], record->channels[index].dataSize);
+		position = record->channels[index].dataOffset + record->channels[index].dataSize;
+	}
+	memset(buffer + position, 0, record->header.recordSize - position);
+}
+
+/// \brief Get the size of a value.
+/// \param format The #CaptureFormat of the value.
+/// \return The size of one value in bytes, the alignment for packed values.
+unsigned int CaptureFile::formatSize(CaptureFormat format) {
+	switch(format) {
+		case CAPTURE_FORMAT_FLOAT64:
+			return sizeof(double);
+		case CAPTURE_FORMAT_FLOAT32:
+			return sizeof(float);
+		case CAPTURE_FORMAT_CODE16:
+			return sizeof(quint16);
+		case CAPTURE_FORMAT_PACKED:
+			return sizeof(quint64);
+		default:
+			return sizeof(quint8);
+	}
+}
+
+/// \brief Checks the header and the channel table of a record.
+/// \param position The position of the record in the file.
+/// \return true if the record is complete and all values are inside it.
+bool CaptureFile::checkRecord(qint64 position) const {
+	if(position % CAPTURE_ALIGNMENT || position + (qint64) sizeof(CaptureHeader) > this->mapSize)
+		return false;
+	
+	const CaptureHeader *header = (const CaptureHeader *) (this->map + position);
+	quint64 available = this->mapSize - position;
+	if(memcmp(header->magic, CAPTURE_MAGIC, sizeof(header->magic))
+			|| header->version < 1 || header->version > CAPTURE_VERSION
+			|| header->byteOrder != CAPTURE_BYTEORDER
+			|| header->headerSize < sizeof(CaptureHeader) || header->headerSize % 8
+			|| header->channelSize < sizeof(CaptureChannel) || header->channelSize % 8
+			|| header->recordSize > available || header->recordSize % CAPTURE_ALIGNMENT
+			|| header->headerSize + (quint64) header->channelCount * header->channelSize > header->recordSize)
+		return false;
+	
+	for(unsigned int index = 0; index < header->channelCount; index++) {
+		const CaptureChannel *channel = (const CaptureChannel *) ((const uchar *) header + header->headerSize + index * header->channelSize);
+		if(channel->format >= CAPTURE_FORMAT_COUNT || channel->count > 0xffffffff)
+			return false;
+		
+		// The values have to be aligned and completely inside the record
+		quint64 size = CaptureFile::formatSize((CaptureFormat) channel->format);
+		if(channel->dataOffset % size || channel->dataOffset > header->recordSize
+				|| channel->dataSize > header->recordSize - channel->dataOffset)
+			return false;
+		if(channel->format != CAPTURE_FORMAT_PACKED && channel->dataSize != channel->count * size)
+			return false;
+	}
+	
+	return true;
+}
+
+/// \brief Places the value arrays behind the channel table.
+/// Sets the data offsets of the channels and the size of the record.
+/// \param record The record with the final channel table.
+void CaptureFile::layout(CaptureRecord *record) {
+	quint64 position = sizeof(CaptureHeader) + record->channels.count() * sizeof(CaptureChannel);
+	for(int index = 0; index < record->channels.count(); index++) {
+		position = (position + CAPTURE_ALIGNMENT - 1) / CAPTURE_ALIGNMENT * CAPTURE_ALIGNMENT;
+		record->channels[index].dataOffset = position;
+		position += record->channels[index].dataSize;
+	}
+	record->header.recordSize = (position + CAPTURE_ALIGNMENT - 1) / CAPTURE_ALIGNMENT * CAPTURE_ALIGNMENT;
+}
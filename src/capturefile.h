@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file capturefile.h
+/// \brief Declares the CaptureFile class and the capture file layout.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+#include <QtGlobal>
+
+
+#define CAPTURE_MAGIC        "OHCAPTUR" ///< Identifies capture files, without the terminating null
+#define CAPTURE_VERSION               1 ///< Version of the file layout written by this program
+#define CAPTURE_BYTEORDER    0x01020304 ///< Written in the byte order of the file
+#define CAPTURE_ALIGNMENT            64 ///< Alignment of the value arrays in bytes
+#define CAPTURE_NAME_LENGTH          32 ///< Size of the name fields including the terminating null
+
+
+class QFile;
+class QIODevice;
+class QString;
+
+class DataAnalyzer;
+class DsoSettings;
+struct SampleValues;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \enum CaptureFormat                                            capturefile.h
+/// \brief The data types of the value arrays.
+enum CaptureFormat {
+	CAPTURE_FORMAT_FLOAT64,                 ///< 64 bit floating point values
+	CAPTURE_FORMAT_FLOAT32,                 ///< 32 bit floating point values
+	CAPTURE_FORMAT_CODE8,                   ///< Unsigned 8 bit ADC codes
+	CAPTURE_FORMAT_CODE16,                  ///< Unsigned 16 bit ADC codes
+	CAPTURE_FORMAT_PACKED,                  ///< 64 bit values packed by the SampleCodec
+	CAPTURE_FORMAT_COUNT                    ///< Total number of formats
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct CaptureHeader                                          capturefile.h
+/// \brief The header at the start of each record of a capture file.
+/// All fields are naturally aligned, so the layout is the same for all
+/// compilers. The header is followed by the channel table. Recordings append
+/// one record per frame, the next header follows directly after the record.
+struct CaptureHeader {
+	char magic[8]; ///< Always #CAPTURE_MAGIC
+	quint32 version; ///< The #CAPTURE_VERSION of the writer
+	quint32 byteOrder; ///< Always #CAPTURE_BYTEORDER
+	quint32 headerSize; ///< Size of the header in bytes, the channel table starts there
+	quint32 channelSize; ///< Size of one channel table entry in bytes
+	quint32 channelCount; ///< Number of entries in the channel table
+	quint32 reserved; ///< Always 0
+	qint64 timestamp; ///< Time of the capture in ms since 1970-01-01 00:00 UTC
+	quint64 recordSize; ///< Size of the record in bytes, a multiple of #CAPTURE_ALIGNMENT
+	double samplerate; ///< The samplerate in S/s
+	double triggerTime; ///< Time of the trigger point in s after the first sample
+	char model[CAPTURE_NAME_LENGTH]; ///< Name of the oscilloscope model
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct CaptureChannel                                         capturefile.h
+/// \brief An entry of the channel table describing one value array.
+/// Raw codes are converted into values with value = code * scale + zero.
+struct CaptureChannel {
+	char name[CAPTURE_NAME_LENGTH]; ///< Name of the channel
+	quint32 mode; ///< The Dso::ChannelMode of the values
+	quint32 format; ///< The #CaptureFormat of the values
+	quint32 index; ///< Number of the channel, the math channel follows the physical ones
+	quint32 reserved; ///< Always 0
+	quint64 dataOffset; ///< Position of the values in bytes from the record start
+	quint64 dataSize; ///< Size of the stored values in bytes
+	quint64 count; ///< Number of values
+	double interval; ///< Time or frequency between two values
+	double gain; ///< The vertical resolution in V/div or dB/div
+	double offset; ///< The vertical offset in divs
+	double scale; ///< Value of one code step, 1 for floating point values
+	double zero; ///< Value of the code 0, 0 for floating point values
+	double amplitude; ///< The measured amplitude in V, 0 for spectrum channels
+	double frequency; ///< The measured frequency in Hz, 0 for spectrum channels
+	double minimum; ///< The smallest value, summarizes the record without reading it
+	double maximum; ///< The largest value, summarizes the record without reading it
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct CaptureRecord                                          capturefile.h
+/// \brief A frame that is prepared for writing.
+struct CaptureRecord {
+	CaptureHeader header; ///< The header of the record
+	QVector<CaptureChannel> channels; ///< The channel table
+	QVector<const void *> values; ///< The stored values of each channel
+	QVector<double> buffer; ///< Copy of the values if the record owns them
+	QVector<QByteArray> packed; ///< The packed values of each channel
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class CaptureFile                                             capturefile.h
+/// \brief Writes capture files and maps them back into memory.
+/// The value arrays of an opened file aren't read or parsed, 64 bit values are
+/// used directly from the mapped file, other formats are converted on access.
+class CaptureFile {
+	public:
+		CaptureFile();
+		~CaptureFile();
+		
+		bool open(const QString &filename);
+		void close();
+		
+		unsigned int recordCount() const;
+		const CaptureHeader *header(unsigned int record = 0) const;
+		unsigned int channelCount(unsigned int record = 0) const;
+		const CaptureChannel *channel(unsigned int index, unsigned int record = 0) const;
+		const void *values(unsigned int index, unsigned int record = 0) const;
+		bool samples(unsigned int index, SampleValues *samples, unsigned int record = 0);
+		
+		static bool write(const QString &filename, DsoSettings *settings, DataAnalyzer *dataAnalyzer);
+		static void collect(DsoSettings *settings, DataAnalyzer *dataAnalyzer, CaptureRecord *record, bool copy);
+		static void pack(CaptureRecord *record);
+		static bool writeRecord(QIODevice *device, const CaptureRecord *record);
+		static void writeRecord(uchar *buffer, const CaptureRecord *record);
+		static unsigned int formatSize(CaptureFormat format);
+	
+	protected:
+		bool checkRecord(qint64 position) const;
+		
+		static void layout(CaptureRecord *record);
+		
+		QFile *file; ///< The opened capture file, 0 if there is none
+		const uchar *map; ///< The mapped file contents
+		qint64 mapSize; ///< The size of the mapped file
+		QVector<qint64> records; ///< The position of each record in the file
+		QList<double *> converted; ///< Converted values for each channel of one record
+		unsigned int convertedRecord; ///< The record the converted values belong to
+};
+
+
+#endif
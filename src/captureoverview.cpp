@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  captureoverview.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cfloat>
+
+#include <QMouseEvent>
+#include <QPainter>
+
+
+#include "captureoverview.h"
+
+#include "capturefile.h"
+#include "dso.h"
+#include "glgenerator.h"
+#include "settings.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class CaptureOverview
+/// \brief Initializes the overview.
+/// \param settings The settings with the channel colors and scales.
+/// \param parent The parent widget.
+CaptureOverview::CaptureOverview(DsoSettings *settings, QWidget *parent) : QWidget(parent) {
+	this->settings = settings;
+	this->captureFile = 0;
+	this->frame = 0;
+	
+	this->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+/// \brief Cleans up the widget.
+CaptureOverview::~CaptureOverview() {
+}
+
+/// \brief Return the size of the overview.
+/// \return The recommended size of the widget.
+QSize CaptureOverview::sizeHint() const {
+	return QSize(200, 64);
+}
+
+/// \brief Set the capture that is shown.
+/// \param captureFile The opened capture, 0 if there is none.
+void CaptureOverview::setCapture(const CaptureFile *captureFile) {
+	this->captureFile = captureFile;
+	this->frame = 0;
+	
+	this->updateEnvelopes();
+	this->update();
+}
+
+/// \brief Summarizes the frames of each pixel column.
+void CaptureOverview::updateEnvelopes() {
+	this->minimum.clear();
+	this->maximum.clear();
+	if(!this->captureFile || !this->captureFile->recordCount())
+		return;
+	
+	int columns = this->width();
+	unsigned int records = this->captureFile->recordCount();
+	for(unsigned int channel = 0; channel < this->settings->scope.physicalChannels; channel++) {
+		this->minimum.append(QVector<double>(columns, DBL_MAX));
+		this->maximum.append(QVector<double>(columns, -DBL_MAX));
+	}
+	
+	for(int column = 0; column < columns; column++) {
+		// Each record belongs to one column, columns between records repeat the previous one
+		unsigned int first = (qint64) column * records / columns;
+		unsigned int last = qMax((unsigned int) ((qint64) (column + 1) * records / columns), first + 1);
+		
+		for(unsigned int record = first; record < last; record++) {
+			for(unsigned int index = 0; index < this->captureFile->channelCount(record); index++) {
+				const CaptureChannel *channel = this->captureFile->channel(index, record);
+				if(channel->mode != Dso::CHANNELMODE_VOLTAGE || channel->index >= this->settings->scope.physicalChannels || !channel->count)
+					continue;
+				
+				if(channel->minimum < this->minimum[channel->index][column])
+					this->minimum[channel->index][column] = channel->minimum;
+				if(channel->maximum > this->maximum[channel->index][column])
+					this->maximum[channel->index][column] = channel->maximum;
+			}
+		}
+	}
+}
+
+/// \brief Get the frame shown at a horizontal position.
+/// \param x The position in pixels.
+/// \return The index of the frame.
+unsigned int CaptureOverview::frameAt(int x) const {
+	int columns = qMax(this->width(), 1);
+	
+	return (qint64) qBound(0, x, columns - 1) * this->captureFile->recordCount() / columns;
+}
+
+/// \brief Selects the frame below the mouse while dragging.
+/// \param event The mouse event that should be handled.
+void CaptureOverview::mouseMoveEvent(QMouseEvent *event) {
+	if(!(event->buttons() & Qt::LeftButton) || !this->captureFile || !this->captureFile->recordCount()) {
+		event->ignore();
+		return;
+	}
+	
+	emit frameSelected(this->frameAt(event->x()));
+	event->accept();
+}
+
+/// \brief Selects the clicked frame.
+/// \param event The mouse event that should be handled.
+void CaptureOverview::mousePressEvent(QMouseEvent *event) {
+	if(!(event->button() & Qt::LeftButton) || !this->captureFile || !this->captureFile->recordCount()) {
+		event->ignore();
+		return;
+	}
+	
+	emit frameSelected(this->frameAt(event->x()));
+	event->accept();
+}
+
+/// \brief Paints the envelopes and the frame cursor.
+/// \param event The paint event that should be handled.
+void CaptureOverview::paintEvent(QPaintEvent *event) {
+	Q_UNUSED(event);
+	
+	QPainter painter(this);
+	const DsoSettingsColorValues *colorValues = &(this->settings->view.color.screen);
+	
+	painter.fillRect(this->rect(), colorValues->background);
+	painter.setPen(colorValues->grid);
+	painter.drawRect(this->rect().adjusted(0, 0, -1, -1));
+	if(this->minimum.isEmpty())
+		return;
+	
+	// The values are scaled like on the screen
+	double scale = this->height() / DIVS_VOLTAGE;
+	double center = this->height() / 2.0;
+	for(int channel = 0; channel < this->minimum.count(); channel++) {
+		if(!this->settings->scope.voltage[channel].used)
+			continue;
+		
+		double gain = this->settings->scope.voltage[channel].gain;
+		double offset = this->settings->scope.voltage[channel].offset;
+		painter.setPen(colorValues->voltage[channel]);
+		for(int column = 0; column < this->minimum[channel].count(); column++) {
+			if(this->minimum[channel][column] > this->maximum[channel][column])
+				continue;
+			
+			int top = qBound(0, (int) (center - (this->maximum[channel][column] / gain + offset) * scale), this->height() - 1);
+			int bottom = qBound(0, (int) (center - (this->minimum[channel][column] / gain + offset) * scale), this->height() - 1);
+			painter.drawLine(column, top, column, bottom);
+		}
+	}
+	
+	int cursor = (int) (((double) this->frame + 0.5) * this->width() / this->captureFile->recordCount());
+	painter.setPen(colorValues->markers);
+	painter.drawLine(cursor, 0, cursor, this->height() - 1);
+}
+
+/// \brief Rebuilds the envelopes for the new width.
+/// \param event The resize event that should be handled.
+void CaptureOverview::resizeEvent(QResizeEvent *event) {
+	Q_UNUSED(event);
+	
+	this->updateEnvelopes();
+}
+
+/// \brief Moves the cursor to another frame.
+/// \param frame The index of the frame.
+void CaptureOverview::setFrame(unsigned int frame) {
+	this->frame = frame;
+	this->update();
+}
@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file captureoverview.h
+/// \brief Declares the CaptureOverview class.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CAPTUREOVERVIEW_H
+#define CAPTUREOVERVIEW_H
+
+
+#include <QList>
+#include <QVector>
+#include <QWidget>
+
+
+class CaptureFile;
+class DsoSettings;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class CaptureOverview                                     captureoverview.h
+/// \brief Shows the envelope of all frames of a capture.
+/// Every pixel column summarizes the frames that fall into it with the minimum
+/// and maximum values from the channel table, so the samples aren't read.
+/// Clicking or dragging selects the frame below the mouse.
+class CaptureOverview : public QWidget {
+	Q_OBJECT
+	
+	public:
+		CaptureOverview(DsoSettings *settings, QWidget *parent = 0);
+		~CaptureOverview();
+		
+		QSize sizeHint() const;
+		
+		void setCapture(const CaptureFile *captureFile);
+	
+	protected:
+		void updateEnvelopes();
+		unsigned int frameAt(int x) const;
+		
+		void mouseMoveEvent(QMouseEvent *event);
+		void mousePressEvent(QMouseEvent *event);
+		void paintEvent(QPaintEvent *event);
+		void resizeEvent(QResizeEvent *event);
+		
+		DsoSettings *settings; ///< The settings provided by the parent class
+		const CaptureFile *captureFile; ///< The shown capture, 0 if there is none
+		unsigned int frame; ///< The frame marked by the cursor
+		
+		QList<QVector<double> > minimum; ///< Smallest value of each channel per pixel column
+		QList<QVector<double> > maximum; ///< Largest value of each channel per pixel column
+	
+	public slots:
+		void setFrame(unsigned int frame);
+	
+	signals:
+		void frameSelected(unsigned int frame); ///< A frame was clicked
+};
+
+
+#endif
@@ -0,0 +1,248 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  captureplayer.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <QMutex>
+#include <QTimer>
+
+
+#include "captureplayer.h"
+
+#include "capturefile.h"
+#include "dataanalyzer.h"
+#include "dso.h"
+#include "settings.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class CapturePlayer
+/// \brief Initializes the player.
+/// \param settings The settings with the channel count.
+/// \param dataAnalyzer The analyzer the frames are sent to.
+/// \param parent The parent widget.
+CapturePlayer::CapturePlayer(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QObject *parent) : QObject(parent) {
+	this->settings = settings;
+	this->dataAnalyzer = dataAnalyzer;
+	this->captureFile = new CaptureFile();
+	
+	this->frame = 0;
+	this->pending = false;
+	this->playing = false;
+	this->playTimer = new QTimer(this);
+	this->playTimer->setSingleShot(true);
+	
+	this->samplesMutex = new QMutex();
+	
+	connect(this->playTimer, SIGNAL(timeout()), this, SLOT(nextFrame()));
+	connect(this->dataAnalyzer, SIGNAL(finished()), this, SLOT(analyzerFinished()));
+}
+
+/// \brief Closes the capture and cleans up.
+CapturePlayer::~CapturePlayer() {
+	this->close();
+	
+	delete this->captureFile;
+	delete this->samplesMutex;
+}
+
+/// \brief Opens a capture file and shows its first frame.
+/// \param filename The name of the capture file.
+/// \return true if the file contains at least one frame.
+bool CapturePlayer::open(const QString &filename) {
+	this->close();
+	
+	this->samplesMutex->lock();
+	bool success = this->captureFile->open(filename);
+	this->samplesMutex->unlock();
+	if(!success)
+		return false;
+	
+	this->frame = 0;
+	emit opened(this->getFrameCount());
+	this->sendFrame();
+	emit frameChanged(this->frame);
+	
+	return true;
+}
+
+/// \brief Checks if a capture is opened.
+/// \return true if there are frames that can be shown.
+bool CapturePlayer::isOpen() const {
+	return this->captureFile->recordCount() > 0;
+}
+
+/// \brief Get the opened capture.
+/// \return The capture file, has no records if nothing is opened.
+const CaptureFile *CapturePlayer::getCaptureFile() const {
+	return this->captureFile;
+}
+
+/// \brief Get the number of frames.
+/// \return The number of frames of the opened capture.
+unsigned int CapturePlayer::getFrameCount() const {
+	return this->captureFile->recordCount();
+}
+
+/// \brief Get the current frame.
+/// \return The index of the shown frame.
+unsigned int CapturePlayer::getFrame() const {
+	return this->frame;
+}
+
+/// \brief Checks if the frames are advanced automatically.
+/// \return true while playing.
+bool CapturePlayer::isPlaying() const {
+	return this->playing;
+}
+
+/// \brief Passes the current frame to the data analyzer.
+/// The recorded values are used directly from the mapped file, channels that
+/// weren't recorded are replaced by zeros.
+void CapturePlayer::sendFrame() {
+	if(!this->isOpen())
+		return;
+	
+	// The analyzer drops data while it's busy, so send the frame when it's done
+	if(this->dataAnalyzer->isRunning()) {
+		this->pending = true;
+		return;
+	}
+	this->pending = false;
+	
+	this->samplesMutex->lock();
+	
+	this->samples.clear();
+	this->samplesSize.clear();
+	for(unsigned int channel = 0; channel < this->settings->scope.physicalChannels; channel++) {
+		this->samples.append(0);
+		this->samplesSize.append(0);
+	}
+	
+	double samplerate = this->captureFile->header(this->frame)->samplerate;
+	unsigned int count = 0;
+	for(unsigned int index = 0; index < this->captureFile->channelCount(this->frame); index++) {
+		const CaptureChannel *channel = this->captureFile->channel(index, this->frame);
+		if(channel->mode != Dso::CHANNELMODE_VOLTAGE || channel->index >= this->settings->scope.physicalChannels)
+			continue;
+		
+		// Damaged channels are replaced by zeros too
+		SampleValues values;
+		if(!this->captureFile->samples(index, &values, this->frame))
+			continue;
+		this->samples[channel->index] = values.sample;
+		this->samplesSize[channel->index] = values.count;
+		if(values.interval > 0)
+			samplerate = 1.0 / values.interval;
+		if(values.count > count)
+			count = values.count;
+	}
+	
+	if((unsigned int) this->silence.count() < count)
+		this->silence.fill(0, count);
+	for(int channel = 0; channel < this->samples.count(); channel++) {
+		if(!this->samples[channel]) {
+			this->samples[channel] = this->silence.data();
+			this->samplesSize[channel] = count;
+		}
+	}
+	
+	this->samplesMutex->unlock();
+	
+	emit samplesAvailable(&(this->samples), &(this->samplesSize), samplerate, this->samplesMutex);
+}
+
+/// \brief Starts the timer for the next frame.
+/// The frames are played with the recorded pace, pauses are limited to 1 s.
+void CapturePlayer::schedule() {
+	if(this->frame + 1 >= this->getFrameCount()) {
+		this->setPlaying(false);
+		return;
+	}
+	
+	qint64 interval = this->captureFile->header(this->frame + 1)->timestamp - this->captureFile->header(this->frame)->timestamp;
+	this->playTimer->start(qBound((qint64) 0, interval, (qint64) 1000));
+}
+
+/// \brief Closes the capture.
+void CapturePlayer::close() {
+	if(!this->isOpen())
+		return;
+	
+	this->setPlaying(false);
+	
+	// The analyzer may still be copying the mapped samples
+	this->samplesMutex->lock();
+	this->captureFile->close();
+	this->samples.clear();
+	this->samplesSize.clear();
+	this->samplesMutex->unlock();
+	this->pending = false;
+	
+	emit closed();
+}
+
+/// \brief Shows another frame.
+/// \param frame The index of the frame.
+void CapturePlayer::setFrame(unsigned int frame) {
+	if(frame == this->frame || frame >= this->getFrameCount())
+		return;
+	
+	this->frame = frame;
+	this->sendFrame();
+	emit frameChanged(this->frame);
+}
+
+/// \brief Starts or stops the playback.
+/// \param playing true if the frames should be advanced automatically.
+void CapturePlayer::setPlaying(bool playing) {
+	playing = playing && this->isOpen();
+	if(playing == this->playing)
+		return;
+	
+	this->playing = playing;
+	if(this->playing) {
+		// Start again from the beginning after the last frame
+		if(this->frame + 1 >= this->getFrameCount())
+			this->setFrame(0);
+		this->schedule();
+	}
+	else
+		this->playTimer->stop();
+	
+	emit playingChanged(this->playing);
+}
+
+/// \brief Sends the frame that was requested while the analyzer was busy.
+void CapturePlayer::analyzerFinished() {
+	if(this->pending)
+		this->sendFrame();
+}
+
+/// \brief Advances to the next frame while playing.
+void CapturePlayer::nextFrame() {
+	if(!this->playing)
+		return;
+	
+	this->setFrame(this->frame + 1);
+	this->schedule();
+}
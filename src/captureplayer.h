@@ -0,0 +1,99 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file captureplayer.h
+/// \brief Declares the CapturePlayer class.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CAPTUREPLAYER_H
+#define CAPTUREPLAYER_H
+
+
+#include <QList>
+#include <QObject>
+#include <QVector>
+
+
+class QMutex;
+class QTimer;
+
+class CaptureFile;
+class DataAnalyzer;
+class DsoSettings;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class CapturePlayer                                         captureplayer.h
+/// \brief Feeds recorded frames into the data analyzer instead of the device.
+/// The capture file is mapped into memory, so only the pages of the shown
+/// frames are read from the disk. The frames are passed through the same
+/// signal as the samples of the oscilloscope.
+class CapturePlayer : public QObject {
+	Q_OBJECT
+	
+	public:
+		CapturePlayer(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QObject *parent = 0);
+		~CapturePlayer();
+		
+		bool open(const QString &filename);
+		bool isOpen() const;
+		const CaptureFile *getCaptureFile() const;
+		unsigned int getFrameCount() const;
+		unsigned int getFrame() const;
+		bool isPlaying() const;
+	
+	protected:
+		void sendFrame();
+		void schedule();
+		
+		DsoSettings *settings; ///< The settings provided by the parent class
+		DataAnalyzer *dataAnalyzer; ///< The analyzer the frames are sent to
+		CaptureFile *captureFile; ///< The opened capture
+		
+		unsigned int frame; ///< The index of the current frame
+		bool pending; ///< true if the current frame waits for the analyzer
+		bool playing; ///< true while the frames are advanced automatically
+		QTimer *playTimer; ///< Advances the frames while playing
+		
+		QList<double *> samples; ///< The sample arrays of the physical channels
+		QList<unsigned int> samplesSize; ///< The number of samples of each channel
+		QMutex *samplesMutex; ///< Locked by the analyzer while it copies the samples
+		QVector<double> silence; ///< Zero samples for channels that weren't recorded
+	
+	public slots:
+		void close();
+		void setFrame(unsigned int frame);
+		void setPlaying(bool playing);
+	
+	protected slots:
+		void analyzerFinished();
+		void nextFrame();
+	
+	signals:
+		void opened(unsigned int frames); ///< A capture with that much frames was opened
+		void closed(); ///< The capture was closed
+		void frameChanged(unsigned int frame); ///< Another frame is shown
+		void playingChanged(bool playing); ///< The playback was started or stopped
+		void samplesAvailable(const QList<double *> *data, const QList<unsigned int> *size, double samplerate, QMutex *mutex); ///< The samples of a frame
+};
+
+
+#endif
@@ -23,11 +23,14 @@
 
 
 #include <QCheckBox>
+#include <QComboBox>
 #include <QDoubleSpinBox>
+#include <QFileDialog>
 #include <QHBoxLayout>
 #include <QGridLayout>
 #include <QGroupBox>
 #include <QLabel>
+#include <QLineEdit>
 #include <QSpinBox>
 #include <QVBoxLayout>
 
@@ -93,6 +96,19 @@ DsoConfigAnalysisPage::DsoConfigAnalysisPage(DsoSettings *settings, QWidget *par
 	this->minimumMagnitudeLayout->addWidget(this->minimumMagnitudeSpinBox);
 	this->minimumMagnitudeLayout->addWidget(this->minimumMagnitudeUnitLabel);
 	
+	this->markersCheckBox = new QCheckBox(tr("Only analyze the samples between the markers"));
+	this->markersCheckBox->setChecked(this->settings->scope.spectrumMarkers);
+	
+	this->paddingLabel = new QLabel(tr("Zero-padding"));
+	this->paddingComboBox = new QComboBox();
+	this->paddingComboBox->addItem(tr("Off"));
+	for(unsigned int padding = 2; padding <= 8; padding *= 2)
+		this->paddingComboBox->addItem(tr("x%1").arg(padding));
+	for(int index = 0; index < this->paddingComboBox->count(); index++) {
+		if((1u << index) == this->settings->scope.spectrumPadding)
+			this->paddingComboBox->setCurrentIndex(index);
+	}
+	
 	this->spectrumLayout = new QGridLayout();
 	this->spectrumLayout->addWidget(this->windowFunctionLabel, 0, 0);
 	this->spectrumLayout->addWidget(this->windowFunctionComboBox, 0, 1);
@@ -100,12 +116,35 @@ DsoConfigAnalysisPage::DsoConfigAnalysisPage(DsoSettings *settings, QWidget *par
 	this->spectrumLayout->addLayout(this->referenceLevelLayout, 1, 1);
 	this->spectrumLayout->addWidget(this->minimumMagnitudeLabel, 2, 0);
 	this->spectrumLayout->addLayout(this->minimumMagnitudeLayout, 2, 1);
+	this->spectrumLayout->addWidget(this->markersCheckBox, 3, 0, 1, 2);
+	this->spectrumLayout->addWidget(this->paddingLabel, 4, 0);
+	this->spectrumLayout->addWidget(this->paddingComboBox, 4, 1);
 	
 	this->spectrumGroup = new QGroupBox(tr("Spectrum"));
 	this->spectrumGroup->setLayout(this->spectrumLayout);
 	
+	this->eyePeriodLabel = new QLabel(tr("Symbol period"));
+	this->eyePeriodSpinBox = new QDoubleSpinBox();
+	this->eyePeriodSpinBox->setDecimals(3);
+	this->eyePeriodSpinBox->setMinimum(0.0);
+	this->eyePeriodSpinBox->setMaximum(1e6);
+	this->eyePeriodSpinBox->setSpecialValueText(tr("Recover"));
+	this->eyePeriodSpinBox->setValue(this->settings->scope.eyePeriod * 1e6);
+	this->eyePeriodUnitLabel = new QLabel(tr("\265s"));
+	this->eyePeriodLayout = new QHBoxLayout();
+	this->eyePeriodLayout->addWidget(this->eyePeriodSpinBox);
+	this->eyePeriodLayout->addWidget(this->eyePeriodUnitLabel);
+	
+	this->eyeLayout = new QGridLayout();
+	this->eyeLayout->addWidget(this->eyePeriodLabel, 0, 0);
+	this->eyeLayout->addLayout(this->eyePeriodLayout, 0, 1);
+	
+	this->eyeGroup = new QGroupBox(tr("Eye diagram"));
+	this->eyeGroup->setLayout(this->eyeLayout);
+	
 	this->mainLayout = new QVBoxLayout();
 	this->mainLayout->addWidget(this->spectrumGroup);
+	this->mainLayout->addWidget(this->eyeGroup);
 	this->mainLayout->addStretch(1);
 	
 	this->setLayout(this->mainLayout);
@@ -120,6 +159,9 @@ void DsoConfigAnalysisPage::saveSettings() {
 	this->settings->scope.spectrumWindow = (Dso::WindowFunction) this->windowFunctionComboBox->currentIndex();
 	this->settings->scope.spectrumReference = this->referenceLevelSpinBox->value();
 	this->settings->scope.spectrumLimit = this->minimumMagnitudeSpinBox->value();
+	this->settings->scope.spectrumMarkers = this->markersCheckBox->isChecked();
+	this->settings->scope.spectrumPadding = 1 << this->paddingComboBox->currentIndex();
+	this->settings->scope.eyePeriod = this->eyePeriodSpinBox->value() / 1e6;
 }
 
 
@@ -252,24 +294,134 @@ DsoConfigFilesPage::DsoConfigFilesPage(DsoSettings *settings, QWidget *parent) :
 	this->imageHeightSpinBox->setMinimum(100);
 	this->imageHeightSpinBox->setMaximum(9999);
 	this->imageHeightSpinBox->setValue(this->settings->options.imageSize.height());
+	this->csvLayoutLabel = new QLabel(tr("CSV layout"));
+	this->csvLayoutComboBox = new QComboBox();
+	for(int layout = 0; layout < Dso::CSV_COUNT; layout++)
+		this->csvLayoutComboBox->addItem(Dso::csvLayoutString((Dso::CsvLayout) layout));
+	this->csvLayoutComboBox->setCurrentIndex(this->settings->options.csvLayout);
 	
 	this->exportLayout = new QGridLayout();
 	this->exportLayout->addWidget(this->imageWidthLabel, 0, 0);
 	this->exportLayout->addWidget(this->imageWidthSpinBox, 0, 1);
 	this->exportLayout->addWidget(this->imageHeightLabel, 1, 0);
 	this->exportLayout->addWidget(this->imageHeightSpinBox, 1, 1);
+	this->exportLayout->addWidget(this->csvLayoutLabel, 2, 0);
+	this->exportLayout->addWidget(this->csvLayoutComboBox, 2, 1);
 	
 	this->exportGroup = new QGroupBox(tr("Export"));
 	this->exportGroup->setLayout(this->exportLayout);
 	
+	this->recorderPath = this->settings->options.recorder.path;
+	this->recorderPathLabel = new QLabel(tr("Folder"));
+	this->recorderPathButton = new QPushButton(tr("Folder..."));
+	this->recorderPathButton->setToolTip(this->recorderPath);
+	this->recorderDecimationLabel = new QLabel(tr("Record every"));
+	this->recorderDecimationSpinBox = new QSpinBox();
+	this->recorderDecimationSpinBox->setMinimum(1);
+	this->recorderDecimationSpinBox->setMaximum(10000);
+	this->recorderDecimationSpinBox->setSuffix(tr(" frame(s)"));
+	this->recorderDecimationSpinBox->setValue(this->settings->options.recorder.decimation);
+	this->recorderQueueLabel = new QLabel(tr("Queue length"));
+	this->recorderQueueSpinBox = new QSpinBox();
+	this->recorderQueueSpinBox->setMinimum(1);
+	this->recorderQueueSpinBox->setMaximum(4096);
+	this->recorderQueueSpinBox->setSuffix(tr(" frames"));
+	this->recorderQueueSpinBox->setValue(this->settings->options.recorder.queueLength);
+	this->recorderSizeLabel = new QLabel(tr("New file after"));
+	this->recorderSizeSpinBox = new QSpinBox();
+	this->recorderSizeSpinBox->setMinimum(0);
+	this->recorderSizeSpinBox->setMaximum(1048576);
+	this->recorderSizeSpinBox->setSuffix(tr(" MiB"));
+	this->recorderSizeSpinBox->setSpecialValueText(tr("Unlimited"));
+	this->recorderSizeSpinBox->setValue(this->settings->options.recorder.rotateSize);
+	this->recorderTimeLabel = new QLabel(tr("New file after"));
+	this->recorderTimeSpinBox = new QSpinBox();
+	this->recorderTimeSpinBox->setMinimum(0);
+	this->recorderTimeSpinBox->setMaximum(10080);
+	this->recorderTimeSpinBox->setSuffix(tr(" min"));
+	this->recorderTimeSpinBox->setSpecialValueText(tr("Unlimited"));
+	this->recorderTimeSpinBox->setValue(this->settings->options.recorder.rotateTime);
+	this->recorderCompressCheckBox = new QCheckBox(tr("Compress the voltage samples"));
+	this->recorderCompressCheckBox->setChecked(this->settings->options.recorder.compress);
+	
+	this->recorderLayout = new QGridLayout();
+	this->recorderLayout->addWidget(this->recorderPathLabel, 0, 0);
+	this->recorderLayout->addWidget(this->recorderPathButton, 0, 1);
+	this->recorderLayout->addWidget(this->recorderDecimationLabel, 1, 0);
+	this->recorderLayout->addWidget(this->recorderDecimationSpinBox, 1, 1);
+	this->recorderLayout->addWidget(this->recorderQueueLabel, 2, 0);
+	this->recorderLayout->addWidget(this->recorderQueueSpinBox, 2, 1);
+	this->recorderLayout->addWidget(this->recorderSizeLabel, 3, 0);
+	this->recorderLayout->addWidget(this->recorderSizeSpinBox, 3, 1);
+	this->recorderLayout->addWidget(this->recorderTimeLabel, 4, 0);
+	this->recorderLayout->addWidget(this->recorderTimeSpinBox, 4, 1);
+	this->recorderLayout->addWidget(this->recorderCompressCheckBox, 5, 0, 1, 2);
+	
+	this->recorderGroup = new QGroupBox(tr("Recording"));
+	this->recorderGroup->setLayout(this->recorderLayout);
+	
+	this->serverEnabledCheckBox = new QCheckBox(tr("Accept connections from local programs"));
+	this->serverEnabledCheckBox->setChecked(this->settings->options.server.enabled);
+	this->serverNameLabel = new QLabel(tr("Socket name"));
+	this->serverNameLineEdit = new QLineEdit(this->settings->options.server.name);
+	this->serverPortLabel = new QLabel(tr("TCP port"));
+	this->serverPortSpinBox = new QSpinBox();
+	this->serverPortSpinBox->setMinimum(0);
+	this->serverPortSpinBox->setMaximum(65535);
+	this->serverPortSpinBox->setSpecialValueText(tr("Disabled"));
+	this->serverPortSpinBox->setValue(this->settings->options.server.port);
+	
+	this->serverLayout = new QGridLayout();
+	this->serverLayout->addWidget(this->serverEnabledCheckBox, 0, 0, 1, 2);
+	this->serverLayout->addWidget(this->serverNameLabel, 1, 0);
+	this->serverLayout->addWidget(this->serverNameLineEdit, 1, 1);
+	this->serverLayout->addWidget(this->serverPortLabel, 2, 0);
+	this->serverLayout->addWidget(this->serverPortSpinBox, 2, 1);
+	
+	this->serverGroup = new QGroupBox(tr("Server"));
+	this->serverGroup->setLayout(this->serverLayout);
+	
+	this->ringEnabledCheckBox = new QCheckBox(tr("Publish the frames in shared memory"));
+	this->ringEnabledCheckBox->setChecked(this->settings->options.ring.enabled);
+	this->ringNameLabel = new QLabel(tr("Name"));
+	this->ringNameLineEdit = new QLineEdit(this->settings->options.ring.name);
+	this->ringSlotsLabel = new QLabel(tr("Keep the last"));
+	this->ringSlotsSpinBox = new QSpinBox();
+	this->ringSlotsSpinBox->setMinimum(2);
+	this->ringSlotsSpinBox->setMaximum(1024);
+	this->ringSlotsSpinBox->setSuffix(tr(" frames"));
+	this->ringSlotsSpinBox->setValue(this->settings->options.ring.slotCount);
+	this->ringSlotSizeLabel = new QLabel(tr("Maximum frame size"));
+	this->ringSlotSizeSpinBox = new QSpinBox();
+	this->ringSlotSizeSpinBox->setMinimum(1);
+	this->ringSlotSizeSpinBox->setMaximum(1024);
+	this->ringSlotSizeSpinBox->setSuffix(tr(" MiB"));
+	this->ringSlotSizeSpinBox->setValue(this->settings->options.ring.slotSize);
+	
+	this->ringLayout = new QGridLayout();
+	this->ringLayout->addWidget(this->ringEnabledCheckBox, 0, 0, 1, 2);
+	this->ringLayout->addWidget(this->ringNameLabel, 1, 0);
+	this->ringLayout->addWidget(this->ringNameLineEdit, 1, 1);
+	this->ringLayout->addWidget(this->ringSlotsLabel, 2, 0);
+	this->ringLayout->addWidget(this->ringSlotsSpinBox, 2, 1);
+	this->ringLayout->addWidget(this->ringSlotSizeLabel, 3, 0);
+	this->ringLayout->addWidget(this->ringSlotSizeSpinBox, 3, 1);
+	
+	this->ringGroup = new QGroupBox(tr("Shared memory"));
+	this->ringGroup->setLayout(this->ringLayout);
+	
 	this->mainLayout = new QVBoxLayout();
 	this->mainLayout->addWidget(this->configurationGroup);
 	this->mainLayout->addWidget(this->exportGroup);
+	this->mainLayout->addWidget(this->recorderGroup);
+	this->mainLayout->addWidget(this->serverGroup);
+	this->mainLayout->addWidget(this->ringGroup);
 	this->mainLayout->addStretch(1);
 	
 	this->setLayout(this->mainLayout);
 	
 	connect(this->saveNowButton, SIGNAL(clicked()), this->settings, SLOT(save()));
+	connect(this->recorderPathButton, SIGNAL(clicked()), this, SLOT(selectRecorderPath()));
 }
 
 /// \brief Cleans up the widget.
@@ -281,6 +433,30 @@ void DsoConfigFilesPage::saveSettings() {
 	this->settings->options.alwaysSave = this->saveOnExitCheckBox->isChecked();
 	this->settings->options.imageSize.setWidth(this->imageWidthSpinBox->value());
 	this->settings->options.imageSize.setHeight(this->imageHeightSpinBox->value());
+	this->settings->options.csvLayout = (Dso::CsvLayout) this->csvLayoutComboBox->currentIndex();
+	this->settings->options.recorder.path = this->recorderPath;
+	this->settings->options.recorder.decimation = this->recorderDecimationSpinBox->value();
+	this->settings->options.recorder.queueLength = this->recorderQueueSpinBox->value();
+	this->settings->options.recorder.rotateSize = this->recorderSizeSpinBox->value();
+	this->settings->options.recorder.rotateTime = this->recorderTimeSpinBox->value();
+	this->settings->options.recorder.compress = this->recorderCompressCheckBox->isChecked();
+	this->settings->options.server.enabled = this->serverEnabledCheckBox->isChecked();
+	this->settings->options.server.name = this->serverNameLineEdit->text();
+	this->settings->options.server.port = this->serverPortSpinBox->value();
+	this->settings->options.ring.enabled = this->ringEnabledCheckBox->isChecked();
+	this->settings->options.ring.name = this->ringNameLineEdit->text();
+	this->settings->options.ring.slotCount = this->ringSlotsSpinBox->value();
+	this->settings->options.ring.slotSize = this->ringSlotSizeSpinBox->value();
+}
+
+/// \brief Asks for the folder the recordings are written to.
+void DsoConfigFilesPage::selectRecorderPath() {
+	QString path = QFileDialog::getExistingDirectory(this, tr("Write recordings to"), this->recorderPath);
+	if(path.isEmpty())
+		return;
+	
+	this->recorderPath = path;
+	this->recorderPathButton->setToolTip(path);
 }
 
 
@@ -311,6 +487,15 @@ DsoConfigScopePage::DsoConfigScopePage(DsoSettings *settings, QWidget *parent) :
 	this->digitalPhosphorDepthSpinBox->setMinimum(2);
 	this->digitalPhosphorDepthSpinBox->setMaximum(99);
 	this->digitalPhosphorDepthSpinBox->setValue(this->settings->view.digitalPhosphorDepth);
+	this->frameRateLabel = new QLabel(tr("Maximum frame rate"));
+	this->frameRateSpinBox = new QSpinBox();
+	this->frameRateSpinBox->setMinimum(0);
+	this->frameRateSpinBox->setMaximum(200);
+	this->frameRateSpinBox->setSuffix(tr(" fps"));
+	this->frameRateSpinBox->setSpecialValueText(tr("Unlimited"));
+	this->frameRateSpinBox->setValue(this->settings->view.frameRate);
+	this->vsyncCheckBox = new QCheckBox(tr("Synchronize to display refresh (after restart)"));
+	this->vsyncCheckBox->setChecked(this->settings->view.vsync);
 	
 	this->graphLayout = new QGridLayout();
 	this->graphLayout->addWidget(this->antialiasingCheckBox, 0, 0, 1, 2);
@@ -318,6 +503,9 @@ DsoConfigScopePage::DsoConfigScopePage(DsoSettings *settings, QWidget *parent) :
 	this->graphLayout->addWidget(this->interpolationComboBox, 1, 1);
 	this->graphLayout->addWidget(this->digitalPhosphorDepthLabel, 2, 0);
 	this->graphLayout->addWidget(this->digitalPhosphorDepthSpinBox, 2, 1);
+	this->graphLayout->addWidget(this->frameRateLabel, 3, 0);
+	this->graphLayout->addWidget(this->frameRateSpinBox, 3, 1);
+	this->graphLayout->addWidget(this->vsyncCheckBox, 4, 0, 1, 2);
 	
 	this->graphGroup = new QGroupBox(tr("Graph"));
 	this->graphGroup->setLayout(this->graphLayout);
@@ -338,4 +526,6 @@ void DsoConfigScopePage::saveSettings() {
 	this->settings->view.antialiasing = this->antialiasingCheckBox->isChecked();
 	this->settings->view.interpolation = (Dso::InterpolationMode) this->interpolationComboBox->currentIndex();
 	this->settings->view.digitalPhosphorDepth = this->digitalPhosphorDepthSpinBox->value();
+	this->settings->view.frameRate = this->frameRateSpinBox->value();
+	this->settings->view.vsync = this->vsyncCheckBox->isChecked();
 }
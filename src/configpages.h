@@ -41,6 +41,7 @@ class QComboBox;
 class QSpinBox;
 class QStringList;
 class QLabel;
+class QLineEdit;
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -75,6 +76,17 @@ class DsoConfigAnalysisPage : public QWidget {
 		QDoubleSpinBox *minimumMagnitudeSpinBox;
 		QLabel *minimumMagnitudeUnitLabel;
 		QHBoxLayout *minimumMagnitudeLayout;
+		
+		QCheckBox *markersCheckBox;
+		QLabel *paddingLabel;
+		QComboBox *paddingComboBox;
+		
+		QGroupBox *eyeGroup;
+		QGridLayout *eyeLayout;
+		QLabel *eyePeriodLabel;
+		QDoubleSpinBox *eyePeriodSpinBox;
+		QLabel *eyePeriodUnitLabel;
+		QHBoxLayout *eyePeriodLayout;
 	
 	private slots:
 };
@@ -143,8 +155,44 @@ class DsoConfigFilesPage : public QWidget {
 		QSpinBox *imageWidthSpinBox;
 		QLabel *imageHeightLabel;
 		QSpinBox *imageHeightSpinBox;
+		QLabel *csvLayoutLabel;
+		QComboBox *csvLayoutComboBox;
+		
+		QGroupBox *recorderGroup;
+		QGridLayout *recorderLayout;
+		QString recorderPath;
+		QLabel *recorderPathLabel;
+		QPushButton *recorderPathButton;
+		QLabel *recorderDecimationLabel;
+		QSpinBox *recorderDecimationSpinBox;
+		QLabel *recorderQueueLabel;
+		QSpinBox *recorderQueueSpinBox;
+		QLabel *recorderSizeLabel;
+		QSpinBox *recorderSizeSpinBox;
+		QLabel *recorderTimeLabel;
+		QSpinBox *recorderTimeSpinBox;
+		QCheckBox *recorderCompressCheckBox;
+		
+		QGroupBox *serverGroup;
+		QGridLayout *serverLayout;
+		QCheckBox *serverEnabledCheckBox;
+		QLabel *serverNameLabel;
+		QLineEdit *serverNameLineEdit;
+		QLabel *serverPortLabel;
+		QSpinBox *serverPortSpinBox;
+		
+		QGroupBox *ringGroup;
+		QGridLayout *ringLayout;
+		QCheckBox *ringEnabledCheckBox;
+		QLabel *ringNameLabel;
+		QLineEdit *ringNameLineEdit;
+		QLabel *ringSlotsLabel;
+		QSpinBox *ringSlotsSpinBox;
+		QLabel *ringSlotSizeLabel;
+		QSpinBox *ringSlotSizeSpinBox;
 	
 	private slots:
+		void selectRecorderPath();
 };
 
 
@@ -173,6 +221,9 @@ class DsoConfigScopePage : public QWidget {
 		QSpinBox *digitalPhosphorDepthSpinBox;
 		QLabel *interpolationLabel;
 		QComboBox *interpolationComboBox;
+		QLabel *frameRateLabel;
+		QSpinBox *frameRateSpinBox;
+		QCheckBox *vsyncCheckBox;
 	
 	private slots:
 };
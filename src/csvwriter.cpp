@@ -0,0 +1,421 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  csvwriter.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <QFile>
+#include <QFuture>
+#include <QMutex>
+#include <QStringList>
+#include <QThread>
+#include <QtConcurrentRun>
+
+
+#include "csvwriter.h"
+
+#include "dataanalyzer.h"
+#include "dso.h"
+#include "peakfinder.h"
+#include "settings.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct CsvBlock                                               csvwriter.cpp
+/// \brief A range of values that is formatted by one thread.
+struct CsvBlock {
+	const QVector<CsvColumn> *columns; ///< The columns of the table
+	unsigned int first; ///< Index of the first value of the block
+	unsigned int count; ///< Number of values or rows in the block
+	bool table; ///< true for one line per index, false for a list of the first column
+	char decimalPoint; ///< The decimal point used by the C library
+	QByteArray text; ///< The formatted block
+};
+
+/// \brief Formats the values of a block into its text.
+/// The text is allocated once for the worst case and shrunk afterwards, so
+/// there are no reallocations inside the loop.
+/// \param block The block that should be formatted.
+static void formatBlock(CsvBlock *block) {
+	int columnCount = block->table ? block->columns->count() : 1;
+	block->text.resize(block->count * columnCount * CSV_NUMBER_LENGTH + 1);
+	char *start = block->text.data();
+	char *position = start;
+	
+	for(unsigned int index = block->first; index < block->first + block->count; index++) {
+		if(block->table) {
+			// One line with a cell for each column, empty if the column is shorter
+			for(int column = 0; column < columnCount; column++) {
+				const CsvColumn &values = (*block->columns)[column];
+				if(column > 0)
+					*(position++) = ',';
+				if(index < values.count)
+					position += CsvWriter::formatNumber(values.sample ? values.sample[index] : index * values.interval, position, block->decimalPoint);
+			}
+			*(position++) = '\n';
+		}
+		else {
+			// The values of the first column continue the current line
+			*(position++) = ',';
+			position += CsvWriter::formatNumber(block->columns->first().sample[index], position, block->decimalPoint);
+		}
+	}
+	
+	block->text.resize(position - start);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class CsvWriter
+/// \brief Initializes the writer.
+/// \param settings The settings with the channel names and the layout.
+/// \param dataAnalyzer The data analyzer whose frames are written.
+CsvWriter::CsvWriter(DsoSettings *settings, DataAnalyzer *dataAnalyzer) {
+	this->settings = settings;
+	this->dataAnalyzer = dataAnalyzer;
+	
+	this->file = 0;
+	this->buffer = new char[CSV_BUFFER_SIZE];
+	this->bufferFill = 0;
+	this->headerWritten = false;
+	this->failed = false;
+	this->decimalPoint = '.';
+}
+
+/// \brief Closes the file and cleans up.
+CsvWriter::~CsvWriter() {
+	this->close();
+	
+	delete[] this->buffer;
+}
+
+/// \brief Creates the output file.
+/// \param filename The name of the file, "-" for the standard output.
+/// \return true if the file was opened for writing.
+bool CsvWriter::open(const QString &filename) {
+	this->close();
+	
+	this->file = new QFile(filename);
+	bool opened;
+	if(filename == "-")
+		opened = this->file->open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+	else
+		opened = this->file->open(QIODevice::WriteOnly | QIODevice::Text);
+	if(!opened) {
+		delete this->file;
+		this->file = 0;
+		return false;
+	}
+	
+	this->bufferFill = 0;
+	this->headerWritten = false;
+	this->failed = false;
+	// The application uses the locale of the user, so printf may write commas
+	this->decimalPoint = localeconv()->decimal_point[0];
+	
+	return true;
+}
+
+/// \brief Appends the current data of the analyzer to the file.
+/// The data analyzer is locked while the frame is written.
+/// \param lock false if the caller already holds the lock of the analyzer.
+/// \return false if writing failed.
+bool CsvWriter::writeFrame(bool lock) {
+	if(!this->file)
+		return false;
+	
+	if(lock)
+		this->dataAnalyzer->mutex()->lock();
+	if(this->settings->options.csvLayout == Dso::CSV_COLUMNS)
+		this->writeColumns();
+	else
+		this->writeRows();
+	if(lock)
+		this->dataAnalyzer->mutex()->unlock();
+	
+	return !this->failed;
+}
+
+/// \brief Writes the buffered data and closes the file.
+/// \return false if writing failed.
+bool CsvWriter::close() {
+	if(!this->file)
+		return !this->failed;
+	
+	this->flush();
+	this->file->close();
+	delete this->file;
+	this->file = 0;
+	
+	return !this->failed;
+}
+
+/// \brief Formats a value as shortest string that is read back unchanged.
+/// Most values need less than 17 digits, so the shorter precisions are tried
+/// first and checked by parsing them again.
+/// \param value The value that should be formatted.
+/// \param buffer The target buffer, needs #CSV_NUMBER_LENGTH bytes.
+/// \param decimalPoint The decimal point of the current C library locale.
+/// \return The number of characters written, without the terminating null.
+int CsvWriter::formatNumber(double value, char *buffer, char decimalPoint) {
+	int length = 0;
+	
+	for(int precision = 15; precision <= 17; precision++) {
+		length = snprintf(buffer, CSV_NUMBER_LENGTH, "%.*g", precision, value);
+		// NaN never compares equal, it isn't improved by more digits either
+		if(precision == 17 || value != value || strtod(buffer, 0) == value)
+			break;
+	}
+	
+	// CSV files always use a point, independent of the locale
+	if(decimalPoint != '.') {
+		for(int position = 0; position < length; position++) {
+			if(buffer[position] == decimalPoint) {
+				buffer[position] = '.';
+				break;
+			}
+		}
+	}
+	
+	return length;
+}
+
+/// \brief Writes one line per channel with name, sample interval and values.
+/// The spectrum lines are followed by the distortion and the highest peaks.
+void CsvWriter::writeRows() {
+	QVector<CsvColumn> columns(1);
+	
+	for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
+		const AnalyzedData *analyzedData = this->dataAnalyzer->data(channel);
+		if(!analyzedData)
+			continue;
+		
+		if(this->settings->scope.voltage[channel].used) {
+			// Start with channel name and the sample interval
+			this->writeName(this->settings->scope.voltage[channel].name);
+			this->writeText(",", 1);
+			this->writeNumber(analyzedData->samples.voltage.interval);
+			
+			// And now all sample values in volts
+			columns[0].sample = analyzedData->samples.voltage.sample;
+			columns[0].count = analyzedData->samples.voltage.count;
+			this->writeBlocks(columns, columns[0].count, false);
+			
+			// Finally a newline
+			this->writeText("\n", 1);
+		}
+		
+		if(this->settings->scope.spectrum[channel].used) {
+			// Start with channel name and the sample interval
+			this->writeName(this->settings->scope.spectrum[channel].name);
+			this->writeText(",", 1);
+			this->writeNumber(analyzedData->samples.spectrum.interval);
+			
+			// And now all magnitudes in dB
+			columns[0].sample = analyzedData->samples.spectrum.sample;
+			columns[0].count = analyzedData->samples.spectrum.count;
+			this->writeBlocks(columns, columns[0].count, false);
+			
+			// Finally a newline
+			this->writeText("\n", 1);
+			
+			// The distortion in dB followed by frequency and level of the highest peaks
+			const PeakFinder *peakFinder = this->dataAnalyzer->peaks(channel);
+			if(peakFinder && !peakFinder->getPeaks().isEmpty()) {
+				this->writeName(this->settings->scope.spectrum[channel].name + " peaks");
+				this->writeText(",", 1);
+				this->writeNumber(peakFinder->getThd());
+				this->writeText(",", 1);
+				this->writeNumber(peakFinder->getSinad());
+				this->writeText(",", 1);
+				this->writeNumber(peakFinder->getSfdr());
+				for(int peak = 0; peak < peakFinder->getPeaks().count(); peak++) {
+					this->writeText(",", 1);
+					this->writeNumber(peakFinder->getPeaks()[peak].frequency);
+					this->writeText(",", 1);
+					this->writeNumber(peakFinder->getPeaks()[peak].level);
+				}
+				this->writeText("\n", 1);
+			}
+		}
+	}
+}
+
+/// \brief Writes one line per sample with a time and a frequency column.
+/// The header with the channel names is only written for the first frame, the
+/// lines of the following frames are appended to the table.
+void CsvWriter::writeColumns() {
+	QVector<CsvColumn> columns;
+	QStringList names;
+	unsigned int count = 0;
+	
+	for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
+		int axisColumn = columns.count();
+		
+		for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
+			const AnalyzedData *analyzedData = this->dataAnalyzer->data(channel);
+			if(!analyzedData)
+				continue;
+			
+			const SampleValues *samples;
+			if(mode == Dso::CHANNELMODE_VOLTAGE) {
+				if(!this->settings->scope.voltage[channel].used)
+					continue;
+				samples = &(analyzedData->samples.voltage);
+				names.append(this->settings->scope.voltage[channel].name);
+			}
+			else {
+				if(!this->settings->scope.spectrum[channel].used)
+					continue;
+				samples = &(analyzedData->samples.spectrum);
+				names.append(this->settings->scope.spectrum[channel].name);
+			}
+			
+			// The axis column is added in front of the first channel of the mode
+			if(columns.count() == axisColumn) {
+				CsvColumn axis;
+				axis.sample = 0;
+				axis.count = 0;
+				axis.interval = samples->interval;
+				columns.append(axis);
+				names.insert(names.count() - 1, (mode == Dso::CHANNELMODE_VOLTAGE) ? "t / s" : "f / Hz");
+			}
+			
+			CsvColumn values;
+			values.sample = samples->sample;
+			values.count = samples->count;
+			values.interval = samples->interval;
+			columns.append(values);
+			
+			if(samples->count > columns[axisColumn].count)
+				columns[axisColumn].count = samples->count;
+			if(samples->count > count)
+				count = samples->count;
+		}
+	}
+	
+	if(columns.isEmpty())
+		return;
+	
+	if(!this->headerWritten) {
+		for(int column = 0; column < names.count(); column++) {
+			if(column > 0)
+				this->writeText(",", 1);
+			this->writeName(names[column]);
+		}
+		this->writeText("\n", 1);
+		this->headerWritten = true;
+	}
+	
+	this->writeBlocks(columns, count, true);
+}
+
+/// \brief Formats the values in blocks and writes them in order.
+/// Up to one block per processor core is formatted at once.
+/// \param columns The columns that should be written.
+/// \param count The number of rows or values.
+/// \param table true for one line per row, false to continue the current line.
+void CsvWriter::writeBlocks(const QVector<CsvColumn> &columns, unsigned int count, bool table) {
+	if(columns.isEmpty())
+		return;
+	
+	unsigned int blockSize = CSV_BLOCK_VALUES;
+	if(table)
+		blockSize = qMax(CSV_BLOCK_VALUES / columns.count(), 1);
+	int threadCount = QThread::idealThreadCount();
+	if(threadCount < 1)
+		threadCount = 1;
+	
+	QVector<CsvBlock> blocks(threadCount);
+	for(unsigned int first = 0; first < count;) {
+		int blockCount = 0;
+		for(; blockCount < threadCount && first < count; blockCount++) {
+			blocks[blockCount].columns = &columns;
+			blocks[blockCount].first = first;
+			blocks[blockCount].count = qMin(blockSize, count - first);
+			blocks[blockCount].table = table;
+			blocks[blockCount].decimalPoint = this->decimalPoint;
+			first += blocks[blockCount].count;
+		}
+		
+		if(blockCount == 1)
+			formatBlock(&blocks[0]);
+		else {
+			QList<QFuture<void> > futures;
+			for(int block = 1; block < blockCount; block++)
+				futures.append(QtConcurrent::run(formatBlock, &blocks[block]));
+			formatBlock(&blocks[0]);
+			for(int index = 0; index < futures.count(); index++)
+				futures[index].waitForFinished();
+		}
+		
+		for(int block = 0; block < blockCount; block++)
+			this->writeText(blocks[block].text.constData(), blocks[block].text.size());
+	}
+}
+
+/// \brief Writes a single value.
+/// \param value The value that should be written.
+void CsvWriter::writeNumber(double value) {
+	char number[CSV_NUMBER_LENGTH];
+	this->writeText(number, CsvWriter::formatNumber(value, number, this->decimalPoint));
+}
+
+/// \brief Writes a quoted name, quotes inside the name are doubled.
+/// \param name The name that should be written.
+void CsvWriter::writeName(const QString &name) {
+	QByteArray text = '"' + QString(name).replace('"', "\"\"").toUtf8() + '"';
+	this->writeText(text.constData(), text.size());
+}
+
+/// \brief Appends text to the buffer, large blocks are written directly.
+/// \param text The text that should be written.
+/// \param length The length of the text in bytes.
+void CsvWriter::writeText(const char *text, int length) {
+	if(this->bufferFill + length > CSV_BUFFER_SIZE)
+		this->flush();
+	
+	if(length >= CSV_BUFFER_SIZE) {
+		if(this->file->write(text, length) != length)
+			this->failed = true;
+	}
+	else {
+		memcpy(this->buffer + this->bufferFill, text, length);
+		this->bufferFill += length;
+	}
+}
+
+/// \brief Writes the buffered text to the file.
+/// Called automatically when the buffer is full, streams can call it after
+/// each frame.
+void CsvWriter::flush() {
+	if(!this->file || !this->bufferFill)
+		return;
+	
+	if(this->file->write(this->buffer, this->bufferFill) != this->bufferFill || !this->file->flush())
+		this->failed = true;
+	this->bufferFill = 0;
+}
@@ -0,0 +1,92 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file csvwriter.h
+/// \brief Declares the CsvWriter class.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef CSVWRITER_H
+#define CSVWRITER_H
+
+
+#include <QString>
+#include <QVector>
+
+
+#define CSV_BUFFER_SIZE         1048576 ///< Bytes collected before they are written to the file
+#define CSV_BLOCK_VALUES          65536 ///< Values that are formatted by one thread at once
+#define CSV_NUMBER_LENGTH            32 ///< Space reserved for one value and its separator
+
+
+class QFile;
+
+class DataAnalyzer;
+class DsoSettings;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct CsvColumn                                                csvwriter.h
+/// \brief One column of the table that is written in the column layout.
+struct CsvColumn {
+	const double *sample; ///< The values, 0 if the column is a time or frequency axis
+	unsigned int count; ///< Number of values in the column
+	double interval; ///< Step between two rows of an axis column
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class CsvWriter                                                 csvwriter.h
+/// \brief Writes the analyzed data into a CSV file.
+/// The values are formatted without the locale of the user as the shortest
+/// string that is read back to the same double. Large frames are split into
+/// blocks that are formatted by several threads and written in big chunks.
+class CsvWriter {
+	public:
+		CsvWriter(DsoSettings *settings, DataAnalyzer *dataAnalyzer);
+		~CsvWriter();
+		
+		bool open(const QString &filename);
+		bool writeFrame(bool lock = true);
+		bool close();
+		void flush();
+		
+		static int formatNumber(double value, char *buffer, char decimalPoint = '.');
+	
+	protected:
+		void writeRows();
+		void writeColumns();
+		void writeBlocks(const QVector<CsvColumn> &columns, unsigned int count, bool table);
+		void writeNumber(double value);
+		void writeName(const QString &name);
+		void writeText(const char *text, int length);
+		
+		DsoSettings *settings; ///< The settings with the channel names and the layout
+		DataAnalyzer *dataAnalyzer; ///< The source of the written frames
+		
+		QFile *file; ///< The output file, 0 if it isn't open
+		char *buffer; ///< Collects small writes until #CSV_BUFFER_SIZE is reached
+		int bufferFill; ///< Number of bytes in the buffer
+		bool headerWritten; ///< true if the header of the column layout was written
+		bool failed; ///< true if writing to the file failed
+		char decimalPoint; ///< The decimal point used by the C library
+};
+
+
+#endif
@@ -22,19 +22,27 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 
+#include <cfloat>
 #include <cmath>
+#include <cstring>
 
 #include <QColor>
 #include <QMutex>
+#include <QVector>
 
 #include <fftw3.h>
 
 
 #include "dataanalyzer.h"
 
-#include "glscope.h"
+#include "decoder.h"
+#include "dso.h"
+#include "eyediagram.h"
 #include "helper.h"
+#include "masktest.h"
+#include "peakfinder.h"
 #include "settings.h"
+#include "statistics.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -48,8 +56,14 @@ DataAnalyzer::DataAnalyzer(DsoSettings *settings, QObject *parent) : QThread(par
 	this->lastBufferSize = 0;
 	this->lastWindow = (Dso::WindowFunction) -1;
 	this->window = 0;
+	this->dftSize = 0;
+	this->dftInput = 0;
+	this->dftOutput = 0;
 	
 	this->analyzedDataMutex = new QMutex();
+	this->protocolDecoder = new ProtocolDecoder();
+	this->maskTest = new MaskTest();
+	this->maskTest->setMask(this->settings->scope.mask.polygon);
 }
 
 /// \brief Deallocates the buffers.
@@ -60,6 +74,22 @@ DataAnalyzer::~DataAnalyzer() {
 		if(this->analyzedData[channel]->samples.spectrum.sample)
 			delete[] this->analyzedData[channel]->samples.spectrum.sample;
 	}
+	for(int channel = 0; channel < this->eyeDiagrams.count(); channel++)
+		delete this->eyeDiagrams[channel];
+	for(int channel = 0; channel < this->peakFinders.count(); channel++)
+		delete this->peakFinders[channel];
+	delete this->protocolDecoder;
+	delete this->maskTest;
+	if(this->dftSize) {
+		fftw_destroy_plan(this->forwardPlan);
+		fftw_destroy_plan(this->inversePlan);
+		fftw_free(this->dftInput);
+		fftw_free(this->dftOutput);
+	}
+	for(int measurement = 0; measurement < Dso::MEASUREMENT_COUNT; measurement++) {
+		for(int channel = 0; channel < this->measurementStatistics[measurement].count(); channel++)
+			delete this->measurementStatistics[measurement][channel];
+	}
 }
 
 /// \brief Returns the analyzed data.
@@ -72,6 +102,49 @@ const AnalyzedData *DataAnalyzer::data(int channel) const {
 	return this->analyzedData[channel];
 }
 
+/// \brief Returns the eye diagram histogram.
+/// \param channel Channel, whose histogram should be returned.
+/// \return The EyeDiagram of the channel, 0 if there is no such channel.
+const EyeDiagram *DataAnalyzer::eyeDiagram(int channel) const {
+	if(channel < 0 || channel >= this->eyeDiagrams.count())
+		return 0;
+	
+	return this->eyeDiagrams[channel];
+}
+
+/// \brief Returns the peaks and distortion of the spectrum.
+/// \param channel Channel, whose peaks should be returned.
+/// \return The PeakFinder of the channel, 0 if there is no such channel.
+const PeakFinder *DataAnalyzer::peaks(int channel) const {
+	if(channel < 0 || channel >= this->peakFinders.count())
+		return 0;
+	
+	return this->peakFinders[channel];
+}
+
+/// \brief Returns the protocol decoder.
+/// \return The ProtocolDecoder holding the annotations of the last frame.
+const ProtocolDecoder *DataAnalyzer::decoder() const {
+	return this->protocolDecoder;
+}
+
+/// \brief Returns the statistics of a measurement.
+/// \param channel Channel, whose statistics should be returned.
+/// \param measurement The measurement, whose statistics should be returned.
+/// \return The RunningStatistics, 0 if there is no such channel.
+const RunningStatistics *DataAnalyzer::statistics(int channel, Dso::Measurement measurement) const {
+	if(measurement < 0 || measurement >= Dso::MEASUREMENT_COUNT || channel < 0 || channel >= this->measurementStatistics[measurement].count())
+		return 0;
+	
+	return this->measurementStatistics[measurement][channel];
+}
+
+/// \brief Returns the mask test.
+/// \return The MaskTest with the counters and the last failed frame.
+const MaskTest *DataAnalyzer::mask() const {
+	return this->maskTest;
+}
+
 /// \brief Returns the sample count of the analyzed data.
 /// \return The maximum sample count of the last analyzed data.
 unsigned long int DataAnalyzer::sampleCount() {
@@ -101,6 +174,8 @@ void DataAnalyzer::run() {
 		this->analyzedData[channel]->samples.spectrum.sample = 0;
 		this->analyzedData[channel]->amplitude = 0;
 		this->analyzedData[channel]->frequency = 0;
+		this->analyzedData[channel]->delay = 0;
+		this->analyzedData[channel]->phase = 0;
 	}
 	for(int channel = this->settings->scope.voltage.count(); channel < this->analyzedData.count(); channel++) {
 		if(this->analyzedData.last()->samples.voltage.sample)
@@ -109,6 +184,26 @@ void DataAnalyzer::run() {
 			delete[] this->analyzedData.last()->samples.spectrum.sample;
 		this->analyzedData.removeLast();
 	}
+	for(int channel = this->eyeDiagrams.count(); channel < this->analyzedData.count(); channel++)
+		this->eyeDiagrams.append(new EyeDiagram());
+	while(this->eyeDiagrams.count() > this->analyzedData.count()) {
+		delete this->eyeDiagrams.last();
+		this->eyeDiagrams.removeLast();
+	}
+	for(int channel = this->peakFinders.count(); channel < this->analyzedData.count(); channel++)
+		this->peakFinders.append(new PeakFinder());
+	while(this->peakFinders.count() > this->analyzedData.count()) {
+		delete this->peakFinders.last();
+		this->peakFinders.removeLast();
+	}
+	for(int measurement = 0; measurement < Dso::MEASUREMENT_COUNT; measurement++) {
+		for(int channel = this->measurementStatistics[measurement].count(); channel < this->analyzedData.count(); channel++)
+			this->measurementStatistics[measurement].append(new RunningStatistics());
+		while(this->measurementStatistics[measurement].count() > this->analyzedData.count()) {
+			delete this->measurementStatistics[measurement].last();
+			this->measurementStatistics[measurement].removeLast();
+		}
+	}
 	
 	for(unsigned int channel = 0; channel < (unsigned int) this->analyzedData.count(); channel++) {
 		// Check if we got data for this channel or if it's a math channel that can be calculated
@@ -186,12 +281,45 @@ void DataAnalyzer::run() {
 	
 	
 	// Calculate frequencies, peak-to-peak voltages and spectrums
+	QVector<unsigned int> spanLengths(this->analyzedData.count(), 0);
 	for(int channel = 0; channel < this->analyzedData.count(); channel++) {
 		if(this->analyzedData[channel]->samples.voltage.sample) {
+			// Get the part of the samples that should be analyzed
+			unsigned int spanStart = 0;
+			unsigned int spanLength = this->analyzedData[channel]->samples.voltage.count;
+			if(this->settings->scope.spectrumMarkers) {
+				double samplesPerDiv = this->settings->scope.horizontal.timebase / this->analyzedData[channel]->samples.voltage.interval;
+				double spanBegin = (qMin(this->settings->scope.horizontal.marker[0], this->settings->scope.horizontal.marker[1]) + DIVS_TIME / 2) * samplesPerDiv;
+				double spanEnd = (qMax(this->settings->scope.horizontal.marker[0], this->settings->scope.horizontal.marker[1]) + DIVS_TIME / 2) * samplesPerDiv;
+				if(spanBegin < 0)
+					spanBegin = 0;
+				if(spanEnd > spanLength)
+					spanEnd = spanLength;
+				// Use the whole buffer if there are too few samples between the markers
+				if(spanEnd - spanBegin >= 4) {
+					spanStart = (unsigned int) spanBegin;
+					spanLength = (unsigned int) spanEnd - spanStart;
+				}
+			}
+			// The half-complex spectrum needs an even number of samples
+			if(spanLength > 1)
+				spanLength -= spanLength % 2;
+			const double *spanSamples = this->analyzedData[channel]->samples.voltage.sample + spanStart;
+			spanLengths[channel] = spanLength;
+			
+			// Pad with zeros to a power of two for a finer frequency grid
+			unsigned int dftSize = spanLength;
+			if(this->settings->scope.spectrumPadding > 1) {
+				dftSize = 2;
+				while(dftSize < spanLength * this->settings->scope.spectrumPadding)
+					dftSize *= 2;
+			}
+			this->updateDftPlans(dftSize);
+			
 			// Calculate new window
-			if(this->lastWindow != this->settings->scope.spectrumWindow || this->lastBufferSize != this->analyzedData[channel]->samples.voltage.count) {
-				if(this->lastBufferSize != this->analyzedData[channel]->samples.voltage.count) {
-					this->lastBufferSize = this->analyzedData[channel]->samples.voltage.count;
+			if(this->lastWindow != this->settings->scope.spectrumWindow || this->lastBufferSize != spanLength) {
+				if(this->lastBufferSize != spanLength) {
+					this->lastBufferSize = spanLength;
 					
 					if(this->window)
 						fftw_free(this->window);
@@ -278,61 +406,56 @@ void DataAnalyzer::run() {
 			}
 			
 			// Set sampling interval
-			this->analyzedData[channel]->samples.spectrum.interval = 1.0 / this->analyzedData[channel]->samples.voltage.interval / this->analyzedData[channel]->samples.voltage.count;
+			this->analyzedData[channel]->samples.spectrum.interval = 1.0 / this->analyzedData[channel]->samples.voltage.interval / dftSize;
 			
 			// Number of real/complex samples
-			unsigned int dftLength = this->analyzedData[channel]->samples.voltage.count / 2;
+			unsigned int dftLength = dftSize / 2;
 			
 			// Reallocate memory for samples if the sample count has changed
 			if(this->analyzedData[channel]->samples.spectrum.count != dftLength) {
 				this->analyzedData[channel]->samples.spectrum.count = dftLength;
 				if(this->analyzedData[channel]->samples.spectrum.sample)
 					delete[] this->analyzedData[channel]->samples.spectrum.sample;
-				this->analyzedData[channel]->samples.spectrum.sample = new double[this->analyzedData[channel]->samples.voltage.count];
+				this->analyzedData[channel]->samples.spectrum.sample = new double[dftSize];
 			}
 			
-			// Create sample buffer and apply window
-			double *windowedValues = new double[this->analyzedData[channel]->samples.voltage.count];
-			for(unsigned int position = 0; position < this->analyzedData[channel]->samples.voltage.count; position++)
-				windowedValues[position] = this->window[position] * this->analyzedData[channel]->samples.voltage.sample[position];
+			// Fill the transformation buffer, apply window and pad with zeros
+			for(unsigned int position = 0; position < spanLength; position++)
+				this->dftInput[position] = this->window[position] * spanSamples[position];
+			for(unsigned int position = spanLength; position < dftSize; position++)
+				this->dftInput[position] = 0;
 			
 			// Do discrete real to half-complex transformation
-			/// \todo Check if buffer size is multiple of 2
-			/// \todo Reuse plan and use FFTW_MEASURE to get fastest algorithm
-			fftw_plan fftPlan = fftw_plan_r2r_1d(this->analyzedData[channel]->samples.voltage.count, windowedValues, this->analyzedData[channel]->samples.spectrum.sample, FFTW_R2HC, FFTW_ESTIMATE);
-			fftw_execute(fftPlan);
-			fftw_destroy_plan(fftPlan);
+			fftw_execute(this->forwardPlan);
+			memcpy(this->analyzedData[channel]->samples.spectrum.sample, this->dftOutput, sizeof(double) * dftSize);
 			
 			// Do an autocorrelation to get the frequency of the signal
-			double *conjugateComplex = windowedValues; // Reuse the windowedValues buffer
+			double *conjugateComplex = this->dftInput; // Reuse the input buffer
 			
 			// Real values
 			unsigned int position;
 			double correctionFactor = 1.0 / dftLength / dftLength;
 			conjugateComplex[0] = (this->analyzedData[channel]->samples.spectrum.sample[0] * this->analyzedData[channel]->samples.spectrum.sample[0]) * correctionFactor;
 			for(position = 1; position < dftLength; position++)
-				conjugateComplex[position] = (this->analyzedData[channel]->samples.spectrum.sample[position] * this->analyzedData[channel]->samples.spectrum.sample[position] + this->analyzedData[channel]->samples.spectrum.sample[this->analyzedData[channel]->samples.voltage.count - position] * this->analyzedData[channel]->samples.spectrum.sample[this->analyzedData[channel]->samples.voltage.count - position]) * correctionFactor;
+				conjugateComplex[position] = (this->analyzedData[channel]->samples.spectrum.sample[position] * this->analyzedData[channel]->samples.spectrum.sample[position] + this->analyzedData[channel]->samples.spectrum.sample[dftSize - position] * this->analyzedData[channel]->samples.spectrum.sample[dftSize - position]) * correctionFactor;
 			// Complex values, all zero for autocorrelation
 			conjugateComplex[dftLength] = (this->analyzedData[channel]->samples.spectrum.sample[dftLength] * this->analyzedData[channel]->samples.spectrum.sample[dftLength]) * correctionFactor;
-			for(position++; position < this->analyzedData[channel]->samples.voltage.count; position++)
+			for(position++; position < dftSize; position++)
 				conjugateComplex[position] = 0;
 			
 			// Do half-complex to real inverse transformation
-			double *correlation = new double[this->analyzedData[channel]->samples.voltage.count];
-			fftPlan = fftw_plan_r2r_1d(this->analyzedData[channel]->samples.voltage.count, conjugateComplex, correlation, FFTW_HC2R, FFTW_ESTIMATE);
-			fftw_execute(fftPlan);
-			fftw_destroy_plan(fftPlan);
-			delete[] conjugateComplex;
+			fftw_execute(this->inversePlan);
+			const double *correlation = this->dftOutput;
 			
 			// Calculate peak-to-peak voltage
 			double minimalVoltage, maximalVoltage;
-			minimalVoltage = maximalVoltage = this->analyzedData[channel]->samples.voltage.sample[0];
+			minimalVoltage = maximalVoltage = spanSamples[0];
 			
-			for(unsigned int position = 1; position < this->analyzedData[channel]->samples.voltage.count; position++) {
-				if(this->analyzedData[channel]->samples.voltage.sample[position] < minimalVoltage)
-					minimalVoltage = this->analyzedData[channel]->samples.voltage.sample[position];
-				else if(this->analyzedData[channel]->samples.voltage.sample[position] > maximalVoltage)
-					maximalVoltage = this->analyzedData[channel]->samples.voltage.sample[position];
+			for(unsigned int position = 1; position < spanLength; position++) {
+				if(spanSamples[position] < minimalVoltage)
+					minimalVoltage = spanSamples[position];
+				else if(spanSamples[position] > maximalVoltage)
+					maximalVoltage = spanSamples[position];
 			}
 			
 			this->analyzedData[channel]->amplitude = maximalVoltage - minimalVoltage;
@@ -342,7 +465,7 @@ void DataAnalyzer::run() {
 			double peakCorrelation = 0;
 			unsigned int peakPosition = 0;
 			
-			for(unsigned int position = 1; position < this->analyzedData[channel]->samples.voltage.count / 2; position++) {
+			for(unsigned int position = 1; position < spanLength / 2; position++) {
 				if(correlation[position] > peakCorrelation && correlation[position] > minimumCorrelation * 2) {
 					peakCorrelation = correlation[position];
 					peakPosition = position;
@@ -350,7 +473,6 @@ void DataAnalyzer::run() {
 				else if(correlation[position] < minimumCorrelation)
 					minimumCorrelation = correlation[position];
 			}
-			delete[] correlation;
 			
 			// Calculate the frequency in Hz
 			if(peakPosition)
@@ -358,18 +480,11 @@ void DataAnalyzer::run() {
 			else
 				this->analyzedData[channel]->frequency = 0;
 			
-			// Finally calculate the real spectrum if we want it
-			if(this->settings->scope.spectrum[channel].used) {
-				// Convert values into dB (Relative to the reference level)
-				double offset = 60 - this->settings->scope.spectrumReference - 20 * log10(dftLength);
-				double offsetLimit = this->settings->scope.spectrumLimit - this->settings->scope.spectrumReference;
-				for(unsigned int position = 0; position < this->analyzedData[channel]->samples.spectrum.count; position++) {
-					this->analyzedData[channel]->samples.spectrum.sample[position] = 20 * log10(fabs(this->analyzedData[channel]->samples.spectrum.sample[position])) + offset;
-					
-					// Check if this value has to be limited
-					if(offsetLimit > this->analyzedData[channel]->samples.spectrum.sample[position])
-						this->analyzedData[channel]->samples.spectrum.sample[position] = offsetLimit;
-				}
+			// Update the statistics of the measurements
+			if(this->settings->scope.voltage[channel].used) {
+				this->measurementStatistics[Dso::MEASUREMENT_AMPLITUDE][channel]->add(this->analyzedData[channel]->amplitude);
+				if(peakPosition)
+					this->measurementStatistics[Dso::MEASUREMENT_FREQUENCY][channel]->add(this->analyzedData[channel]->frequency);
 			}
 		}
 		else if(this->analyzedData[channel]->samples.spectrum.sample) {
@@ -381,9 +496,196 @@ void DataAnalyzer::run() {
 		}
 	}
 	
+	// Cross-correlate the channels with the first one to get delay and phase
+	for(int channel = 0; channel < this->analyzedData.count(); channel++) {
+		this->analyzedData[channel]->delay = 0;
+		this->analyzedData[channel]->phase = 0;
+		
+		// The spectra are still half-complex, so this only costs a multiplication and an inverse transformation
+		if(channel == 0 || !this->settings->scope.voltage[channel].used || !this->analyzedData[0]->samples.spectrum.sample || !this->analyzedData[channel]->samples.spectrum.sample || this->analyzedData[channel]->samples.spectrum.count != this->analyzedData[0]->samples.spectrum.count)
+			continue;
+		
+		this->analyzedData[channel]->delay = this->crossCorrelate(&(this->analyzedData[0]->samples), &(this->analyzedData[channel]->samples));
+		
+		// Phase in the period of the first channel, wrapped into -180 to 180 degrees
+		if(this->analyzedData[0]->frequency > 0) {
+			double phase = fmod(this->analyzedData[channel]->delay * this->analyzedData[0]->frequency * 360.0, 360.0);
+			if(phase > 180.0)
+				phase -= 360.0;
+			else if(phase <= -180.0)
+				phase += 360.0;
+			this->analyzedData[channel]->phase = phase;
+		}
+	}
+	// Finally calculate the real spectrum if we want it
+	for(int channel = 0; channel < this->analyzedData.count(); channel++) {
+		if(this->analyzedData[channel]->samples.spectrum.sample && this->settings->scope.spectrum[channel].used) {
+			// Convert values into dB (Relative to the reference level)
+			double *spectrum = this->analyzedData[channel]->samples.spectrum.sample;
+			unsigned int dftSize = this->analyzedData[channel]->samples.spectrum.count * 2;
+			// Normalize by the analyzed samples, the zero padding doesn't add signal energy
+			double offset = 60 - this->settings->scope.spectrumReference - 20 * log10(qMax(spanLengths[channel], 2u) / 2.0);
+			double offsetLimit = this->settings->scope.spectrumLimit - this->settings->scope.spectrumReference;
+			for(unsigned int position = 0; position < this->analyzedData[channel]->samples.spectrum.count; position++) {
+				// Use the magnitude of the half-complex value, the real part alone depends on the phase
+				double magnitude = fabs(spectrum[position]);
+				if(position)
+					magnitude = sqrt(spectrum[position] * spectrum[position] + spectrum[dftSize - position] * spectrum[dftSize - position]);
+				// Keep empty bins finite for the peak interpolation
+				if(magnitude < DBL_MIN)
+					magnitude = DBL_MIN;
+				spectrum[position] = 20 * log10(magnitude) + offset;
+			}
+			
+			// Find the highest peaks and the harmonic distortion before the limit hides the noise floor
+			this->peakFinders[channel]->analyze(&(this->analyzedData[channel]->samples.spectrum), this->settings->scope.spectrumPeaks);
+			
+			// Check if the values have to be limited
+			for(unsigned int position = 0; position < this->analyzedData[channel]->samples.spectrum.count; position++) {
+				if(offsetLimit > spectrum[position])
+					spectrum[position] = offsetLimit;
+			}
+		}
+		else
+			this->peakFinders[channel]->clear();
+	}
+	
+	// Fold the voltage graphs into the eye diagrams
+	for(int channel = 0; channel < this->analyzedData.count(); channel++) {
+		if(this->settings->scope.horizontal.format == Dso::GRAPHFORMAT_EYE && this->settings->scope.voltage[channel].used && this->analyzedData[channel]->samples.voltage.sample)
+			this->eyeDiagrams[channel]->accumulate(&(this->analyzedData[channel]->samples.voltage), this->settings->scope.eyePeriod, this->settings->scope.voltage[channel].gain, this->settings->scope.voltage[channel].offset);
+		else if(this->eyeDiagrams[channel]->getFrames())
+			this->eyeDiagrams[channel]->clear();
+	}
+	
+	// Decode serial protocols
+	if(this->settings->scope.decoder.enabled) {
+		QList<const SampleValues *> lines;
+		for(int line = 0; line < DECODER_LINES; line++) {
+			unsigned int channel = this->settings->scope.decoder.line[line];
+			if(channel < (unsigned int) this->analyzedData.count())
+				lines.append(&(this->analyzedData[channel]->samples.voltage));
+			else
+				lines.append(0);
+		}
+		this->protocolDecoder->decode(lines, &(this->settings->scope.decoder));
+	}
+	else
+		this->protocolDecoder->clear();
+	
+	// Test the frame against the mask
+	bool maskPassed = true;
+	unsigned int maskChannel = this->settings->scope.mask.channel;
+	if(this->settings->scope.mask.enabled && maskChannel < (unsigned int) this->analyzedData.count() && this->settings->scope.voltage[maskChannel].used)
+		maskPassed = this->maskTest->test(&(this->analyzedData[maskChannel]->samples.voltage), this->settings->scope.horizontal.timebase, this->settings->scope.voltage[maskChannel].gain, this->settings->scope.voltage[maskChannel].offset);
+	
 	this->maxSamples = maxSamples;
 	emit(analyzed(maxSamples));
+	if(!maskPassed)
+		emit(maskFailed());
+	
+	this->analyzedDataMutex->unlock();
+}
+
+/// \brief Prepares the cached transformations for the given length.
+/// Planning is only done when the length changes, e.g. when the markers move.
+/// \param size The number of samples of the transformations.
+void DataAnalyzer::updateDftPlans(unsigned int size) {
+	if(size == this->dftSize)
+		return;
+	
+	if(this->dftSize) {
+		fftw_destroy_plan(this->forwardPlan);
+		fftw_destroy_plan(this->inversePlan);
+		fftw_free(this->dftInput);
+		fftw_free(this->dftOutput);
+	}
+	
+	this->dftSize = size;
+	this->dftInput = (double *) fftw_malloc(sizeof(double) * size);
+	this->dftOutput = (double *) fftw_malloc(sizeof(double) * size);
+	this->forwardPlan = fftw_plan_r2r_1d(size, this->dftInput, this->dftOutput, FFTW_R2HC, FFTW_ESTIMATE);
+	this->inversePlan = fftw_plan_r2r_1d(size, this->dftInput, this->dftOutput, FFTW_HC2R, FFTW_ESTIMATE);
+}
+
+/// \brief Calculates the delay between two channels by cross-correlation.
+/// The half-complex spectra are multiplied with the conjugated reference
+/// spectrum, the peak of the inverse transformation is the delay. It is refined
+/// by fitting a parabola through the peak and its neighbours.
+/// \param reference The samples of the reference channel.
+/// \param samples The samples of the delayed channel, same spectrum size as reference.
+/// \return The delay of samples relative to reference in s.
+double DataAnalyzer::crossCorrelate(const SampleData *reference, const SampleData *samples) {
+	unsigned int sampleCount = reference->spectrum.count * 2;
+	if(sampleCount < 4)
+		return 0;
+	
+	this->updateDftPlans(sampleCount);
+	double *crossSpectrum = this->dftInput;
 	
+	// Multiply the conjugated reference spectrum with the other spectrum
+	const double *referenceSpectrum = reference->spectrum.sample;
+	const double *samplesSpectrum = samples->spectrum.sample;
+	crossSpectrum[0] = referenceSpectrum[0] * samplesSpectrum[0];
+	for(unsigned int position = 1; position < (sampleCount + 1) / 2; position++) {
+		double referenceReal = referenceSpectrum[position];
+		double referenceImaginary = referenceSpectrum[sampleCount - position];
+		double samplesReal = samplesSpectrum[position];
+		double samplesImaginary = samplesSpectrum[sampleCount - position];
+		crossSpectrum[position] = referenceReal * samplesReal + referenceImaginary * samplesImaginary;
+		crossSpectrum[sampleCount - position] = referenceReal * samplesImaginary - referenceImaginary * samplesReal;
+	}
+	if(sampleCount % 2 == 0)
+		crossSpectrum[sampleCount / 2] = referenceSpectrum[sampleCount / 2] * samplesSpectrum[sampleCount / 2];
+	
+	// Do half-complex to real inverse transformation
+	fftw_execute(this->inversePlan);
+	const double *correlation = this->dftOutput;
+	
+	// Find the peak, the correlation is circular
+	unsigned int peakPosition = 0;
+	for(unsigned int position = 1; position < sampleCount; position++) {
+		if(correlation[position] > correlation[peakPosition])
+			peakPosition = position;
+	}
+	
+	// Parabolic interpolation between the neighbours of the peak
+	double previous = correlation[(peakPosition + sampleCount - 1) % sampleCount];
+	double next = correlation[(peakPosition + 1) % sampleCount];
+	double curvature = previous - 2 * correlation[peakPosition] + next;
+	double lag = peakPosition;
+	if(curvature < 0)
+		lag += 0.5 * (previous - next) / curvature;
+	
+	// Lags in the second half are negative
+	if(lag >= sampleCount / 2.0)
+		lag -= sampleCount;
+	
+	return lag * reference->voltage.interval;
+}
+
+/// \brief Resets the statistics of all measurements.
+void DataAnalyzer::resetStatistics() {
+	this->analyzedDataMutex->lock();
+	for(int measurement = 0; measurement < Dso::MEASUREMENT_COUNT; measurement++) {
+		for(int channel = 0; channel < this->measurementStatistics[measurement].count(); channel++)
+			this->measurementStatistics[measurement][channel]->reset();
+	}
+	this->analyzedDataMutex->unlock();
+}
+
+/// \brief Sets the mask the frames are tested against.
+/// \param polygon The allowed area in divs.
+void DataAnalyzer::setMask(const QPolygonF &polygon) {
+	this->analyzedDataMutex->lock();
+	this->maskTest->setMask(polygon);
+	this->analyzedDataMutex->unlock();
+}
+
+/// \brief Resets the pass/fail counters of the mask test.
+void DataAnalyzer::resetMaskCounters() {
+	this->analyzedDataMutex->lock();
+	this->maskTest->resetCounters();
 	this->analyzedDataMutex->unlock();
 }
 
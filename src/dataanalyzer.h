@@ -29,14 +29,22 @@
 
 #include <QThread>
 
+#include <fftw3.h>
+
 
 #include "dso.h"
 #include "helper.h"
 
 
 class DsoSettings;
+class EyeDiagram;
 class HantekDSOAThread;
+class MaskTest;
+class PeakFinder;
+class ProtocolDecoder;
+class RunningStatistics;
 class QMutex;
+class QPolygonF;
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -63,6 +71,8 @@ struct AnalyzedData {
 	SampleData samples; ///< Voltage and spectrum values
 	double frequency; ///< The frequency of the signal
 	double amplitude; ///< The amplitude of the signal
+	double delay; ///< Delay relative to the first channel in s
+	double phase; ///< Phase relative to the first channel in degrees
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -78,21 +88,38 @@ class DataAnalyzer : public QThread {
 		~DataAnalyzer();
 		
 		const AnalyzedData *data(int channel) const;
+		const EyeDiagram *eyeDiagram(int channel) const;
+		const PeakFinder *peaks(int channel) const;
+		const ProtocolDecoder *decoder() const;
+		const RunningStatistics *statistics(int channel, Dso::Measurement measurement) const;
+		const MaskTest *mask() const;
 		unsigned long int sampleCount();
 		QMutex *mutex() const;
 	
 	protected:
 		void run();
+		void updateDftPlans(unsigned int size);
+		double crossCorrelate(const SampleData *reference, const SampleData *samples);
 		
 		DsoSettings *settings; ///< The settings provided by the parent class
 		
 		QList<AnalyzedData *> analyzedData; ///< The analyzed data for each channel
 		QMutex *analyzedDataMutex; ///< A mutex for the analyzed data of all channels
+		QList<EyeDiagram *> eyeDiagrams; ///< The eye diagram histogram for each channel
+		QList<PeakFinder *> peakFinders; ///< The spectrum peaks for each channel
+		ProtocolDecoder *protocolDecoder; ///< Decodes serial protocols from the voltage graphs
+		QList<RunningStatistics *> measurementStatistics[Dso::MEASUREMENT_COUNT]; ///< Statistics of the measurements for each channel
+		MaskTest *maskTest; ///< Tests the frames against the pass/fail mask
 		
 		unsigned long int lastBufferSize; ///< The buffer size of the previously analyzed data
 		unsigned long int maxSamples; ///< The maximum buffer size of the analyzed data
 		Dso::WindowFunction lastWindow; ///< The previously used dft window function
 		double *window; ///< The array for the dft window factors
+		unsigned int dftSize; ///< The length of the cached transformations
+		double *dftInput; ///< The input buffer of the cached transformations
+		double *dftOutput; ///< The output buffer of the cached transformations
+		fftw_plan forwardPlan; ///< Cached real to half-complex transformation
+		fftw_plan inversePlan; ///< Cached half-complex to real transformation
 		
 		QList<double *> waitingData; ///< Pointer to input data from device
 		QList<unsigned int> waitingDataSize; ///< Number of input data samples
@@ -100,10 +127,14 @@ class DataAnalyzer : public QThread {
 		QMutex *waitingDataMutex; ///< A mutex for the input data
 	
 	public slots:
+		void resetStatistics();
+		void setMask(const QPolygonF &polygon);
+		void resetMaskCounters();
 		void analyze(const QList<double *> *data, const QList<unsigned int> *size, double samplerate, QMutex *mutex);
 	
 	signals:
 		void analyzed(unsigned int samples); ///< The data with that much samples has been analyzed
+		void maskFailed(); ///< The analyzed frame violated the mask
 };
 
 #endif
@@ -0,0 +1,414 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  decoder.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <QApplication>
+
+
+#include "decoder.h"
+
+#include "dataanalyzer.h"
+#include "settings.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class Decoder
+/// \brief Cleans up.
+Decoder::~Decoder() {
+}
+
+/// \brief Called after the last edge of a frame.
+/// \param time The end of the frame in s.
+/// \param annotations The list the results are appended to.
+void Decoder::finish(double time, QList<DecoderAnnotation> *annotations) {
+	Q_UNUSED(time);
+	Q_UNUSED(annotations);
+}
+
+/// \brief Appends an annotation to the results.
+/// \param annotations The list the annotation is appended to.
+/// \param start Begin of the annotated period in s.
+/// \param end End of the annotated period in s.
+/// \param text The decoded value or event.
+/// \param error true if the word was malformed.
+void Decoder::annotate(QList<DecoderAnnotation> *annotations, double start, double end, const QString &text, bool error) {
+	DecoderAnnotation annotation;
+	annotation.start = start;
+	annotation.end = end;
+	annotation.text = text;
+	annotation.error = error;
+	annotations->append(annotation);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class UartDecoder
+/// \brief Initializes the decoder.
+/// \param baudrate The bitrate in bit/s.
+UartDecoder::UartDecoder(double baudrate) {
+	this->bitTime = 1.0 / baudrate;
+	
+	bool idle = true;
+	this->reset(&idle);
+}
+
+/// \brief Prepares the decoder for a new frame.
+/// \param levels The levels of the lines at the frame start.
+void UartDecoder::reset(const bool *levels) {
+	this->level = levels[0];
+	this->receiving = false;
+	this->bit = 0;
+	this->value = 0;
+	this->frameStart = 0;
+	this->nextSample = 0;
+}
+
+/// \brief Handles an edge on the RX line.
+/// \param edge The level change.
+/// \param annotations The list the results are appended to.
+void UartDecoder::process(const DecoderEdge &edge, QList<DecoderAnnotation> *annotations) {
+	if(edge.line != 0)
+		return;
+	
+	// Sample all bit centers before this edge with the old level
+	this->advance(edge.time, annotations);
+	this->level = edge.rising;
+	
+	// A falling edge on the idle line is a start bit
+	if(!this->receiving && !this->level) {
+		this->receiving = true;
+		this->bit = 0;
+		this->value = 0;
+		this->frameStart = edge.time;
+		this->nextSample = edge.time + this->bitTime / 2;
+	}
+}
+
+/// \brief Samples the remaining bits of the frame, incomplete words are dropped.
+/// \param time The end of the frame in s.
+/// \param annotations The list the results are appended to.
+void UartDecoder::finish(double time, QList<DecoderAnnotation> *annotations) {
+	this->advance(time, annotations);
+}
+
+/// \brief Samples all bit centers up to the given time.
+/// \param time The time up to that the line had the current level.
+/// \param annotations The list the results are appended to.
+void UartDecoder::advance(double time, QList<DecoderAnnotation> *annotations) {
+	while(this->receiving && this->nextSample < time) {
+		if(this->bit == 0) {
+			// Glitch if the start bit isn't low anymore
+			if(this->level) {
+				this->receiving = false;
+				break;
+			}
+		}
+		else if(this->bit <= 8) {
+			if(this->level)
+				this->value |= 1 << (this->bit - 1);
+		}
+		else {
+			// Stop bit, the line has to be high
+			QString text = QString("0x%1").arg(this->value, 2, 16, QChar('0'));
+			if(this->value >= 0x20 && this->value < 0x7f)
+				text += QString(" '%1'").arg(QChar(this->value));
+			this->annotate(annotations, this->frameStart, this->nextSample + this->bitTime / 2, text, !this->level);
+			this->receiving = false;
+			break;
+		}
+		
+		this->bit++;
+		this->nextSample += this->bitTime;
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class SpiDecoder
+/// \brief Initializes the decoder.
+/// \param clockSlope The clock edge that samples the data line.
+SpiDecoder::SpiDecoder(Dso::Slope clockSlope) {
+	this->sampleRising = clockSlope == Dso::SLOPE_POSITIVE;
+	
+	bool levels[DECODER_LINES] = {false, false};
+	this->reset(levels);
+}
+
+/// \brief Prepares the decoder for a new frame.
+/// \param levels The levels of the lines at the frame start.
+void SpiDecoder::reset(const bool *levels) {
+	this->data = levels[1];
+	this->bits = 0;
+	this->value = 0;
+	this->byteStart = 0;
+	this->lastClock = -1;
+	this->clockPeriod = 0;
+}
+
+/// \brief Handles an edge on the clock or data line.
+/// \param edge The level change.
+/// \param annotations The list the results are appended to.
+void SpiDecoder::process(const DecoderEdge &edge, QList<DecoderAnnotation> *annotations) {
+	if(edge.line == 1) {
+		this->data = edge.rising;
+		return;
+	}
+	if(edge.line != 0 || edge.rising != this->sampleRising)
+		return;
+	
+	// Resynchronize if the clock paused within a byte
+	if(this->bits && this->clockPeriod > 0 && edge.time - this->lastClock > 8 * this->clockPeriod) {
+		this->bits = 0;
+		this->value = 0;
+	}
+	if(this->bits)
+		this->clockPeriod = edge.time - this->lastClock;
+	this->lastClock = edge.time;
+	
+	if(this->bits == 0)
+		this->byteStart = edge.time;
+	this->value = (this->value << 1) | (this->data ? 1 : 0);
+	this->bits++;
+	
+	if(this->bits == 8) {
+		this->annotate(annotations, this->byteStart, edge.time, QString("0x%1").arg(this->value, 2, 16, QChar('0')));
+		this->bits = 0;
+		this->value = 0;
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class I2cDecoder
+/// \brief Initializes the decoder.
+I2cDecoder::I2cDecoder() {
+	bool levels[DECODER_LINES] = {true, true};
+	this->reset(levels);
+}
+
+/// \brief Prepares the decoder for a new frame.
+/// \param levels The levels of the lines at the frame start.
+void I2cDecoder::reset(const bool *levels) {
+	this->scl = levels[0];
+	this->sda = levels[1];
+	this->active = false;
+	this->address = false;
+	this->bits = 0;
+	this->value = 0;
+	this->byteStart = 0;
+}
+
+/// \brief Handles an edge on SCL or SDA.
+/// \param edge The level change.
+/// \param annotations The list the results are appended to.
+void I2cDecoder::process(const DecoderEdge &edge, QList<DecoderAnnotation> *annotations) {
+	if(edge.line == 1) {
+		this->sda = edge.rising;
+		
+		// SDA changes while SCL is high are start and stop conditions
+		if(this->scl) {
+			if(!this->sda) {
+				this->annotate(annotations, edge.time, edge.time, QApplication::tr("Start"));
+				this->active = true;
+				this->address = true;
+			}
+			else {
+				this->annotate(annotations, edge.time, edge.time, QApplication::tr("Stop"));
+				this->active = false;
+			}
+			this->bits = 0;
+			this->value = 0;
+		}
+		return;
+	}
+	if(edge.line != 0)
+		return;
+	
+	this->scl = edge.rising;
+	if(!this->scl || !this->active)
+		return;
+	
+	// Data is valid on the rising SCL edge
+	if(this->bits < 8) {
+		if(this->bits == 0)
+			this->byteStart = edge.time;
+		this->value = (this->value << 1) | (this->sda ? 1 : 0);
+		this->bits++;
+		return;
+	}
+	
+	// Ninth bit is the acknowledge, low means ACK
+	QString text;
+	if(this->address)
+		text = QApplication::tr("Address 0x%1 %2").arg(this->value >> 1, 2, 16, QChar('0')).arg((this->value & 1) ? QApplication::tr("R") : QApplication::tr("W"));
+	else
+		text = QString("0x%1").arg(this->value, 2, 16, QChar('0'));
+	text += ' ';
+	text += this->sda ? QApplication::tr("NACK") : QApplication::tr("ACK");
+	this->annotate(annotations, this->byteStart, edge.time, text);
+	
+	this->address = false;
+	this->bits = 0;
+	this->value = 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class ProtocolDecoder
+/// \brief Initializes the decoder.
+ProtocolDecoder::ProtocolDecoder() {
+	this->decoder = 0;
+	this->protocol = Dso::DECODER_COUNT;
+	this->baudrate = 0;
+	this->clockSlope = Dso::SLOPE_COUNT;
+}
+
+/// \brief Deletes the state machine.
+ProtocolDecoder::~ProtocolDecoder() {
+	if(this->decoder)
+		delete this->decoder;
+}
+
+/// \brief Decodes a frame.
+/// \param lines The voltage samples of the decoded channels.
+/// \param settings The decoder settings.
+void ProtocolDecoder::decode(const QList<const SampleValues *> &lines, const DsoSettingsScopeDecoder *settings) {
+	this->annotations.clear();
+	
+	unsigned int lineCount = (settings->protocol == Dso::DECODER_UART) ? 1 : 2;
+	if((unsigned int) lines.count() < lineCount)
+		return;
+	for(unsigned int line = 0; line < lineCount; line++) {
+		if(!lines[line] || !lines[line]->sample || !lines[line]->count)
+			return;
+	}
+	
+	// Create a new state machine if the protocol parameters have changed
+	if(!this->decoder || settings->protocol != this->protocol || settings->baudrate != this->baudrate || settings->clockSlope != this->clockSlope) {
+		if(this->decoder)
+			delete this->decoder;
+		
+		switch(settings->protocol) {
+			case Dso::DECODER_UART:
+				if(settings->baudrate <= 0) {
+					this->decoder = 0;
+					return;
+				}
+				this->decoder = new UartDecoder(settings->baudrate);
+				break;
+			case Dso::DECODER_SPI:
+				this->decoder = new SpiDecoder(settings->clockSlope);
+				break;
+			case Dso::DECODER_I2C:
+				this->decoder = new I2cDecoder();
+				break;
+			default:
+				this->decoder = 0;
+				return;
+		}
+		
+		this->protocol = settings->protocol;
+		this->baudrate = settings->baudrate;
+		this->clockSlope = settings->clockSlope;
+	}
+	
+	// Get the edges of each line
+	bool levels[DECODER_LINES];
+	for(unsigned int line = 0; line < lineCount; line++)
+		levels[line] = ProtocolDecoder::extractEdges(lines[line], line, settings->threshold, settings->hysteresis, &(this->lineEdges[line]));
+	
+	// Merge the edges of the lines in time order
+	this->edges.resize(0);
+	if(lineCount == 1)
+		this->edges = this->lineEdges[0];
+	else {
+		const QVector<DecoderEdge> &first = this->lineEdges[0];
+		const QVector<DecoderEdge> &second = this->lineEdges[1];
+		int firstIndex = 0, secondIndex = 0;
+		this->edges.reserve(first.count() + second.count());
+		while(firstIndex < first.count() && secondIndex < second.count()) {
+			if(second[secondIndex].time < first[firstIndex].time)
+				this->edges.append(second[secondIndex++]);
+			else
+				this->edges.append(first[firstIndex++]);
+		}
+		while(firstIndex < first.count())
+			this->edges.append(first[firstIndex++]);
+		while(secondIndex < second.count())
+			this->edges.append(second[secondIndex++]);
+	}
+	
+	// Run the state machine
+	this->decoder->reset(levels);
+	for(int index = 0; index < this->edges.count(); index++)
+		this->decoder->process(this->edges[index], &(this->annotations));
+	this->decoder->finish(lines[0]->count * lines[0]->interval, &(this->annotations));
+}
+
+/// \brief Removes the results of the last frame.
+void ProtocolDecoder::clear() {
+	this->annotations.clear();
+}
+
+/// \brief Returns the results of the last frame.
+/// \return The annotations in time order.
+const QList<DecoderAnnotation> &ProtocolDecoder::getAnnotations() const {
+	return this->annotations;
+}
+
+/// \brief Converts the samples of a channel into logic level changes.
+/// A level change is detected when the signal leaves the hysteresis band, its
+/// time is interpolated at the threshold crossing.
+/// \param samples The voltage samples of the channel.
+/// \param line The line number stored in the edges.
+/// \param threshold The logic threshold in V.
+/// \param hysteresis The width of the hysteresis band in V.
+/// \param edges The vector the edges are written to.
+/// \return The level of the line at the start of the frame.
+bool ProtocolDecoder::extractEdges(const SampleValues *samples, unsigned int line, double threshold, double hysteresis, QVector<DecoderEdge> *edges) {
+	edges->resize(0);
+	
+	double high = threshold + hysteresis / 2;
+	double low = threshold - hysteresis / 2;
+	bool level = samples->sample[0] > threshold;
+	bool initialLevel = level;
+	double crossing = 0;
+	
+	DecoderEdge edge;
+	edge.line = line;
+	for(unsigned int position = 1; position < samples->count; position++) {
+		double previous = samples->sample[position - 1];
+		double current = samples->sample[position];
+		if((previous > threshold) != (current > threshold))
+			crossing = position - 1 + (previous - threshold) / (previous - current);
+		
+		if(level ? (current < low) : (current > high)) {
+			level = !level;
+			edge.time = crossing * samples->interval;
+			edge.rising = level;
+			edges->append(edge);
+		}
+	}
+	
+	return initialLevel;
+}
@@ -0,0 +1,169 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file decoder.h
+/// \brief Declares the serial protocol decoder classes.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef DECODER_H
+#define DECODER_H
+
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+
+#include "dso.h"
+
+
+struct DsoSettingsScopeDecoder;
+struct SampleValues;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct DecoderEdge                                                decoder.h
+/// \brief A level change on one of the decoded lines.
+struct DecoderEdge {
+	double time; ///< Time of the threshold crossing in s since the frame start
+	unsigned int line; ///< The line that changed its level
+	bool rising; ///< true if the line is high after the edge
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct DecoderAnnotation                                          decoder.h
+/// \brief A decoded word or protocol event.
+struct DecoderAnnotation {
+	double start; ///< Begin of the annotated period in s since the frame start
+	double end; ///< End of the annotated period in s since the frame start
+	QString text; ///< The decoded value or event
+	bool error; ///< true if the word was malformed
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class Decoder                                                     decoder.h
+/// \brief Base class for the protocol state machines.
+/// The decoders never see samples, they are fed with the time ordered edges
+/// of all lines and keep their state between two edges.
+class Decoder {
+	public:
+		virtual ~Decoder();
+		
+		virtual void reset(const bool *levels) = 0;
+		virtual void process(const DecoderEdge &edge, QList<DecoderAnnotation> *annotations) = 0;
+		virtual void finish(double time, QList<DecoderAnnotation> *annotations);
+	
+	protected:
+		void annotate(QList<DecoderAnnotation> *annotations, double start, double end, const QString &text, bool error = false);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class UartDecoder                                                 decoder.h
+/// \brief Decodes 8N1 asynchronous serial data, LSB first.
+class UartDecoder : public Decoder {
+	public:
+		UartDecoder(double baudrate);
+		
+		void reset(const bool *levels);
+		void process(const DecoderEdge &edge, QList<DecoderAnnotation> *annotations);
+		void finish(double time, QList<DecoderAnnotation> *annotations);
+	
+	protected:
+		void advance(double time, QList<DecoderAnnotation> *annotations);
+		
+		double bitTime; ///< Duration of one bit in s
+		bool level; ///< The current level of the line
+		bool receiving; ///< true between start and stop bit
+		unsigned int bit; ///< Bit that is sampled next, 0 is the start bit
+		unsigned int value; ///< The data bits received so far
+		double frameStart; ///< Time of the start bit edge
+		double nextSample; ///< Time of the next bit center
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class SpiDecoder                                                  decoder.h
+/// \brief Decodes SPI data, MSB first, with clock on line 0 and data on line 1.
+/// Without chip select the bytes are aligned to the first clock edge and
+/// resynchronized after the clock paused for more than 8 clock periods.
+class SpiDecoder : public Decoder {
+	public:
+		SpiDecoder(Dso::Slope clockSlope);
+		
+		void reset(const bool *levels);
+		void process(const DecoderEdge &edge, QList<DecoderAnnotation> *annotations);
+	
+	protected:
+		bool sampleRising; ///< true if the data is sampled on rising clock edges
+		bool data; ///< The current level of the data line
+		unsigned int bits; ///< Number of bits received for the current byte
+		unsigned int value; ///< The bits received so far
+		double byteStart; ///< Time of the first clock edge of the byte
+		double lastClock; ///< Time of the previous sampling clock edge
+		double clockPeriod; ///< Time between the last two sampling clock edges
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class I2cDecoder                                                  decoder.h
+/// \brief Decodes I2C with SCL on line 0 and SDA on line 1.
+class I2cDecoder : public Decoder {
+	public:
+		I2cDecoder();
+		
+		void reset(const bool *levels);
+		void process(const DecoderEdge &edge, QList<DecoderAnnotation> *annotations);
+	
+	protected:
+		bool scl; ///< The current level of the clock line
+		bool sda; ///< The current level of the data line
+		bool active; ///< true between start and stop condition
+		bool address; ///< true if the next byte is the address byte
+		unsigned int bits; ///< Number of bits received for the current byte
+		unsigned int value; ///< The bits received so far
+		double byteStart; ///< Time of the first clock edge of the byte
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class ProtocolDecoder                                             decoder.h
+/// \brief Extracts the edges of the decoded channels and feeds the decoder.
+class ProtocolDecoder {
+	public:
+		ProtocolDecoder();
+		~ProtocolDecoder();
+		
+		void decode(const QList<const SampleValues *> &lines, const DsoSettingsScopeDecoder *settings);
+		void clear();
+		const QList<DecoderAnnotation> &getAnnotations() const;
+		
+		static bool extractEdges(const SampleValues *samples, unsigned int line, double threshold, double hysteresis, QVector<DecoderEdge> *edges);
+	
+	protected:
+		Decoder *decoder; ///< The state machine for the selected protocol
+		Dso::DecoderProtocol protocol; ///< The protocol of the decoder
+		double baudrate; ///< The baudrate the decoder was created with
+		Dso::Slope clockSlope; ///< The clock slope the decoder was created with
+		
+		QVector<DecoderEdge> lineEdges[DECODER_LINES]; ///< The edges of each line
+		QVector<DecoderEdge> edges; ///< The edges of all lines in time order
+		QList<DecoderAnnotation> annotations; ///< The results for the last frame
+};
+
+
+#endif
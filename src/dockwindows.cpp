@@ -22,17 +22,42 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 
+#include <cmath>
+
 #include <QCheckBox>
 #include <QCloseEvent>
 #include <QComboBox>
+#include <QDateTime>
+#include <QDir>
 #include <QDockWidget>
+#include <QDoubleSpinBox>
+#include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHeaderView>
 #include <QLabel>
+#include <QListWidget>
+#include <QMutex>
+#include <QPushButton>
+#include <QSlider>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QTextStream>
 
 
 #include "dockwindows.h"
 
+#include "capturefile.h"
+#include "captureoverview.h"
+#include "captureplayer.h"
+#include "dataanalyzer.h"
+#include "decoder.h"
+#include "glgenerator.h"
 #include "settings.h"
 #include "helper.h"
+#include "masktest.h"
+#include "peakfinder.h"
+#include "statistics.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -140,7 +165,7 @@ int HorizontalDock::setTimebase(double timebase) {
 /// \param format The format for the horizontal axis.
 /// \return Index of format-value, -1 on error.
 int HorizontalDock::setFormat(Dso::GraphFormat format) {
-	if(format >= Dso::GRAPHFORMAT_TY && format <= Dso::GRAPHFORMAT_XY) {
+	if(format >= Dso::GRAPHFORMAT_TY && format < Dso::GRAPHFORMAT_COUNT) {
 		this->formatComboBox->setCurrentIndex(format);
 		return format;
 	}
@@ -624,3 +649,941 @@ void VoltageDock::usedSwitched(bool checked) {
 		emit usedChanged(channel, checked);
 	}
 }
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class DecoderDock
+/// \brief Initializes the protocol decoder docking window.
+/// \param settings The target settings object.
+/// \param parent The parent widget.
+/// \param flags Flags for the window manager.
+DecoderDock::DecoderDock(DsoSettings *settings, QWidget *parent, Qt::WindowFlags flags) : QDockWidget(tr("Decoder"), parent, flags) {
+	this->settings = settings;
+	this->dataAnalyzer = 0;
+	
+	// Initialize elements
+	this->enabledCheckBox = new QCheckBox(tr("Decode"));
+	
+	this->protocolLabel = new QLabel(tr("Protocol"));
+	this->protocolComboBox = new QComboBox();
+	for(int protocol = Dso::DECODER_UART; protocol < Dso::DECODER_COUNT; protocol++)
+		this->protocolComboBox->addItem(Dso::decoderProtocolString((Dso::DecoderProtocol) protocol));
+	
+	for(int line = 0; line < DECODER_LINES; line++) {
+		this->lineLabel[line] = new QLabel();
+		this->lineComboBox[line] = new QComboBox();
+		for(unsigned int channel = 0; channel < this->settings->scope.physicalChannels; channel++)
+			this->lineComboBox[line]->addItem(this->settings->scope.voltage[channel].name);
+	}
+	
+	this->thresholdLabel = new QLabel(tr("Threshold"));
+	this->thresholdSpinBox = new QDoubleSpinBox();
+	this->thresholdSpinBox->setDecimals(2);
+	this->thresholdSpinBox->setRange(-100.0, 100.0);
+	this->thresholdSpinBox->setSingleStep(0.1);
+	this->thresholdSpinBox->setSuffix(tr(" V"));
+	
+	this->hysteresisLabel = new QLabel(tr("Hysteresis"));
+	this->hysteresisSpinBox = new QDoubleSpinBox();
+	this->hysteresisSpinBox->setDecimals(2);
+	this->hysteresisSpinBox->setRange(0.0, 100.0);
+	this->hysteresisSpinBox->setSingleStep(0.1);
+	this->hysteresisSpinBox->setSuffix(tr(" V"));
+	
+	this->baudrateLabel = new QLabel(tr("Baudrate"));
+	this->baudrateSpinBox = new QSpinBox();
+	this->baudrateSpinBox->setRange(1, 100000000);
+	this->baudrateSpinBox->setSuffix(tr(" bit/s"));
+	
+	this->clockSlopeLabel = new QLabel(tr("Clock slope"));
+	this->clockSlopeComboBox = new QComboBox();
+	for(int slope = Dso::SLOPE_POSITIVE; slope < Dso::SLOPE_COUNT; slope++)
+		this->clockSlopeComboBox->addItem(Dso::slopeString((Dso::Slope) slope));
+	
+	this->annotationList = new QListWidget();
+	
+	this->dockLayout = new QGridLayout();
+	this->dockLayout->setColumnMinimumWidth(0, 64);
+	this->dockLayout->setColumnStretch(1, 1);
+	this->dockLayout->addWidget(this->enabledCheckBox, 0, 0, 1, 2);
+	this->dockLayout->addWidget(this->protocolLabel, 1, 0);
+	this->dockLayout->addWidget(this->protocolComboBox, 1, 1);
+	this->dockLayout->addWidget(this->lineLabel[0], 2, 0);
+	this->dockLayout->addWidget(this->lineComboBox[0], 2, 1);
+	this->dockLayout->addWidget(this->lineLabel[1], 3, 0);
+	this->dockLayout->addWidget(this->lineComboBox[1], 3, 1);
+	this->dockLayout->addWidget(this->thresholdLabel, 4, 0);
+	this->dockLayout->addWidget(this->thresholdSpinBox, 4, 1);
+	this->dockLayout->addWidget(this->hysteresisLabel, 5, 0);
+	this->dockLayout->addWidget(this->hysteresisSpinBox, 5, 1);
+	this->dockLayout->addWidget(this->baudrateLabel, 6, 0);
+	this->dockLayout->addWidget(this->baudrateSpinBox, 6, 1);
+	this->dockLayout->addWidget(this->clockSlopeLabel, 7, 0);
+	this->dockLayout->addWidget(this->clockSlopeComboBox, 7, 1);
+	this->dockLayout->addWidget(this->annotationList, 8, 0, 1, 2);
+	
+	this->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+	
+	this->dockWidget = new QWidget();
+	this->dockWidget->setLayout(this->dockLayout);
+	this->setWidget(this->dockWidget);
+	
+	// Set values
+	this->enabledCheckBox->setChecked(this->settings->scope.decoder.enabled);
+	this->protocolComboBox->setCurrentIndex(this->settings->scope.decoder.protocol);
+	for(int line = 0; line < DECODER_LINES; line++) {
+		if(this->settings->scope.decoder.line[line] < this->settings->scope.physicalChannels)
+			this->lineComboBox[line]->setCurrentIndex(this->settings->scope.decoder.line[line]);
+	}
+	this->thresholdSpinBox->setValue(this->settings->scope.decoder.threshold);
+	this->hysteresisSpinBox->setValue(this->settings->scope.decoder.hysteresis);
+	this->baudrateSpinBox->setValue(this->settings->scope.decoder.baudrate);
+	this->clockSlopeComboBox->setCurrentIndex(this->settings->scope.decoder.clockSlope);
+	this->updateLineLabels();
+	
+	// Connect signals and slots
+	connect(this->enabledCheckBox, SIGNAL(toggled(bool)), this, SLOT(enabledSwitched(bool)));
+	connect(this->protocolComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(protocolSelected(int)));
+	for(int line = 0; line < DECODER_LINES; line++)
+		connect(this->lineComboBox[line], SIGNAL(currentIndexChanged(int)), this, SLOT(lineSelected(int)));
+	connect(this->thresholdSpinBox, SIGNAL(valueChanged(double)), this, SLOT(thresholdChanged(double)));
+	connect(this->hysteresisSpinBox, SIGNAL(valueChanged(double)), this, SLOT(hysteresisChanged(double)));
+	connect(this->baudrateSpinBox, SIGNAL(valueChanged(int)), this, SLOT(baudrateChanged(int)));
+	connect(this->clockSlopeComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(clockSlopeSelected(int)));
+}
+
+/// \brief Cleans up everything.
+DecoderDock::~DecoderDock() {
+}
+
+/// \brief Set the data analyzer whose decoded words will be listed.
+/// \param dataAnalyzer Pointer to the DataAnalyzer class.
+void DecoderDock::setDataAnalyzer(DataAnalyzer *dataAnalyzer) {
+	if(this->dataAnalyzer)
+		disconnect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this, SLOT(updateAnnotations()));
+	this->dataAnalyzer = dataAnalyzer;
+	connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this, SLOT(updateAnnotations()));
+}
+
+/// \brief Don't close the dock, just hide it.
+/// \param event The close event that should be handled.
+void DecoderDock::closeEvent(QCloseEvent *event) {
+	this->hide();
+	
+	event->accept();
+}
+
+/// \brief Names the lines and shows the settings used by the protocol.
+void DecoderDock::updateLineLabels() {
+	switch(this->settings->scope.decoder.protocol) {
+		case Dso::DECODER_SPI:
+			this->lineLabel[0]->setText(tr("Clock"));
+			this->lineLabel[1]->setText(tr("Data"));
+			break;
+		case Dso::DECODER_I2C:
+			this->lineLabel[0]->setText(tr("SCL"));
+			this->lineLabel[1]->setText(tr("SDA"));
+			break;
+		default:
+			this->lineLabel[0]->setText(tr("RX"));
+			this->lineLabel[1]->setText(QString());
+			break;
+	}
+	
+	bool uart = this->settings->scope.decoder.protocol == Dso::DECODER_UART;
+	this->lineLabel[1]->setVisible(!uart);
+	this->lineComboBox[1]->setVisible(!uart);
+	this->baudrateLabel->setVisible(uart);
+	this->baudrateSpinBox->setVisible(uart);
+	this->clockSlopeLabel->setVisible(this->settings->scope.decoder.protocol == Dso::DECODER_SPI);
+	this->clockSlopeComboBox->setVisible(this->settings->scope.decoder.protocol == Dso::DECODER_SPI);
+}
+
+/// \brief Lists the words decoded from the last frame.
+void DecoderDock::updateAnnotations() {
+	if(!this->dataAnalyzer || !this->isVisible())
+		return;
+	
+	// Get a shared copy, so the analyzer isn't blocked while filling the list
+	this->dataAnalyzer->mutex()->lock();
+	QList<DecoderAnnotation> annotations = this->dataAnalyzer->decoder()->getAnnotations();
+	this->dataAnalyzer->mutex()->unlock();
+	
+	this->annotationList->clear();
+	for(int index = 0; index < annotations.count(); index++) {
+		QListWidgetItem *item = new QListWidgetItem(QString("%1: %2").arg(Helper::valueToString(annotations[index].start, Helper::UNIT_SECONDS, 4)).arg(annotations[index].text));
+		if(annotations[index].error)
+			item->setForeground(Qt::red);
+		this->annotationList->addItem(item);
+	}
+}
+
+/// \brief Called when the decode checkbox is switched.
+/// \param checked The check-state of the checkbox.
+void DecoderDock::enabledSwitched(bool checked) {
+	this->settings->scope.decoder.enabled = checked;
+	if(!checked)
+		this->annotationList->clear();
+}
+
+/// \brief Called when the protocol combo box changes it's value.
+/// \param index The index of the combo box item.
+void DecoderDock::protocolSelected(int index) {
+	this->settings->scope.decoder.protocol = (Dso::DecoderProtocol) index;
+	this->updateLineLabels();
+}
+
+/// \brief Called when one of the line combo boxes changes it's value.
+/// \param index The index of the combo box item.
+void DecoderDock::lineSelected(int index) {
+	for(int line = 0; line < DECODER_LINES; line++) {
+		if(this->sender() == this->lineComboBox[line])
+			this->settings->scope.decoder.line[line] = index;
+	}
+}
+
+/// \brief Called when the threshold spin box changes it's value.
+/// \param value The new threshold in V.
+void DecoderDock::thresholdChanged(double value) {
+	this->settings->scope.decoder.threshold = value;
+}
+
+/// \brief Called when the hysteresis spin box changes it's value.
+/// \param value The new hysteresis in V.
+void DecoderDock::hysteresisChanged(double value) {
+	this->settings->scope.decoder.hysteresis = value;
+}
+
+/// \brief Called when the baudrate spin box changes it's value.
+/// \param value The new baudrate in bit/s.
+void DecoderDock::baudrateChanged(int value) {
+	this->settings->scope.decoder.baudrate = value;
+}
+
+/// \brief Called when the clock slope combo box changes it's value.
+/// \param index The index of the combo box item.
+void DecoderDock::clockSlopeSelected(int index) {
+	this->settings->scope.decoder.clockSlope = (Dso::Slope) index;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class StatisticsDock
+/// \brief Initializes the measurement statistics docking window.
+/// \param settings The target settings object.
+/// \param parent The parent widget.
+/// \param flags Flags for the window manager.
+StatisticsDock::StatisticsDock(DsoSettings *settings, QWidget *parent, Qt::WindowFlags flags) : QDockWidget(tr("Statistics"), parent, flags) {
+	this->settings = settings;
+	this->dataAnalyzer = 0;
+	
+	// Initialize elements
+	QStringList headerLabels;
+	headerLabels << tr("Channel") << tr("Measurement") << tr("Count") << tr("Mean") << tr("Std. dev.") << tr("Minimum") << tr("Maximum");
+	this->statisticsTable = new QTableWidget(0, headerLabels.count());
+	this->statisticsTable->setHorizontalHeaderLabels(headerLabels);
+	this->statisticsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	this->statisticsTable->setSelectionMode(QAbstractItemView::NoSelection);
+	this->statisticsTable->verticalHeader()->hide();
+	
+	this->resetButton = new QPushButton(tr("Reset"));
+	this->exportButton = new QPushButton(tr("Export..."));
+	
+	this->dockLayout = new QGridLayout();
+	this->dockLayout->addWidget(this->statisticsTable, 0, 0, 1, 2);
+	this->dockLayout->addWidget(this->resetButton, 1, 0);
+	this->dockLayout->addWidget(this->exportButton, 1, 1);
+	
+	this->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+	
+	this->dockWidget = new QWidget();
+	this->dockWidget->setLayout(this->dockLayout);
+	this->setWidget(this->dockWidget);
+	
+	// Connect signals and slots
+	connect(this->resetButton, SIGNAL(clicked()), this, SLOT(resetStatistics()));
+	connect(this->exportButton, SIGNAL(clicked()), this, SLOT(exportStatistics()));
+}
+
+/// \brief Cleans up everything.
+StatisticsDock::~StatisticsDock() {
+}
+
+/// \brief Set the data analyzer whose statistics will be shown.
+/// \param dataAnalyzer Pointer to the DataAnalyzer class.
+void StatisticsDock::setDataAnalyzer(DataAnalyzer *dataAnalyzer) {
+	if(this->dataAnalyzer)
+		disconnect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this, SLOT(updateStatistics()));
+	this->dataAnalyzer = dataAnalyzer;
+	connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this, SLOT(updateStatistics()));
+}
+
+/// \brief Don't close the dock, just hide it.
+/// \param event The close event that should be handled.
+void StatisticsDock::closeEvent(QCloseEvent *event) {
+	this->hide();
+	
+	event->accept();
+}
+
+/// \brief Shows the statistics of all used channels.
+void StatisticsDock::updateStatistics() {
+	if(!this->dataAnalyzer || !this->isVisible())
+		return;
+	
+	// Copy the values, the table is filled after the analyzer was released
+	QList<unsigned int> channels;
+	QList<Dso::Measurement> measurements;
+	QList<RunningStatistics> statistics;
+	this->dataAnalyzer->mutex()->lock();
+	for(unsigned int channel = 0; channel < (unsigned int) this->settings->scope.voltage.count(); channel++) {
+		if(!this->settings->scope.voltage[channel].used)
+			continue;
+		
+		for(int measurement = 0; measurement < Dso::MEASUREMENT_COUNT; measurement++) {
+			const RunningStatistics *measurementStatistics = this->dataAnalyzer->statistics(channel, (Dso::Measurement) measurement);
+			if(!measurementStatistics)
+				continue;
+			
+			channels.append(channel);
+			measurements.append((Dso::Measurement) measurement);
+			statistics.append(*measurementStatistics);
+		}
+	}
+	this->dataAnalyzer->mutex()->unlock();
+	
+	this->statisticsTable->setRowCount(statistics.count());
+	for(int row = 0; row < statistics.count(); row++) {
+		Helper::Unit unit = (measurements[row] == Dso::MEASUREMENT_FREQUENCY) ? Helper::UNIT_HERTZ : Helper::UNIT_VOLTS;
+		
+		QStringList values;
+		values << this->settings->scope.voltage[channels[row]].name << Dso::measurementString(measurements[row]) << QString::number(statistics[row].getCount());
+		if(statistics[row].getCount()) {
+			values << Helper::valueToString(statistics[row].getMean(), unit, 4);
+			values << Helper::valueToString(statistics[row].getStandardDeviation(), unit, 4);
+			values << Helper::valueToString(statistics[row].getMinimum(), unit, 4);
+			values << Helper::valueToString(statistics[row].getMaximum(), unit, 4);
+		}
+		else
+			values << QString() << QString() << QString() << QString();
+		
+		for(int column = 0; column < values.count(); column++) {
+			QTableWidgetItem *item = this->statisticsTable->item(row, column);
+			if(!item) {
+				item = new QTableWidgetItem();
+				this->statisticsTable->setItem(row, column, item);
+			}
+			item->setText(values[column]);
+		}
+	}
+}
+
+/// \brief Called when the reset button is clicked.
+void StatisticsDock::resetStatistics() {
+	if(!this->dataAnalyzer)
+		return;
+	
+	this->dataAnalyzer->resetStatistics();
+	this->updateStatistics();
+}
+
+/// \brief Saves the statistics and the histograms of all channels as CSV file.
+void StatisticsDock::exportStatistics() {
+	if(!this->dataAnalyzer)
+		return;
+	
+	QString fileName = QFileDialog::getSaveFileName(this, tr("Export statistics"), QString(), tr("Comma-Separated Values (*.csv)"));
+	if(fileName.isEmpty())
+		return;
+	
+	QFile csvFile(fileName);
+	if(!csvFile.open(QIODevice::WriteOnly | QIODevice::Text))
+		return;
+	
+	QTextStream csvStream(&csvFile);
+	csvStream << "Channel,Measurement,Count,Mean,Standard deviation,Minimum,Maximum,Histogram start,Bin width";
+	for(int bin = 0; bin < STATISTICS_BINS; bin++)
+		csvStream << ",Bin " << bin;
+	csvStream << "\n";
+	
+	this->dataAnalyzer->mutex()->lock();
+	for(unsigned int channel = 0; channel < (unsigned int) this->settings->scope.voltage.count(); channel++) {
+		for(int measurement = 0; measurement < Dso::MEASUREMENT_COUNT; measurement++) {
+			const RunningStatistics *statistics = this->dataAnalyzer->statistics(channel, (Dso::Measurement) measurement);
+			if(!statistics || !statistics->getCount())
+				continue;
+			
+			csvStream << "\"" << this->settings->scope.voltage[channel].name << "\"," << Dso::measurementString((Dso::Measurement) measurement) << ",";
+			csvStream << statistics->getCount() << "," << statistics->getMean() << "," << statistics->getStandardDeviation() << ",";
+			csvStream << statistics->getMinimum() << "," << statistics->getMaximum() << ",";
+			csvStream << statistics->getHistogramStart() << "," << statistics->getBinWidth();
+			const unsigned long int *histogram = statistics->getHistogram();
+			for(int bin = 0; bin < STATISTICS_BINS; bin++)
+				csvStream << "," << (qulonglong) histogram[bin];
+			csvStream << "\n";
+		}
+	}
+	this->dataAnalyzer->mutex()->unlock();
+	
+	csvFile.close();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class MaskDock
+/// \brief Initializes the mask test docking window.
+/// \param settings The target settings object.
+/// \param parent The parent widget.
+/// \param flags Flags for the window manager.
+MaskDock::MaskDock(DsoSettings *settings, QWidget *parent, Qt::WindowFlags flags) : QDockWidget(tr("Mask test"), parent, flags) {
+	this->settings = settings;
+	this->dataAnalyzer = 0;
+	
+	// Initialize elements
+	this->enabledCheckBox = new QCheckBox(tr("Test"));
+	
+	this->channelLabel = new QLabel(tr("Channel"));
+	this->channelComboBox = new QComboBox();
+	for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++)
+		this->channelComboBox->addItem(this->settings->scope.voltage[channel].name);
+	
+	QStringList headerLabels;
+	headerLabels << tr("X (div)") << tr("Y (div)");
+	this->pointTable = new QTableWidget(0, headerLabels.count());
+	this->pointTable->setHorizontalHeaderLabels(headerLabels);
+	this->pointTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+	this->pointTable->setSelectionMode(QAbstractItemView::SingleSelection);
+	
+	this->addPointButton = new QPushButton(tr("Add"));
+	this->removePointButton = new QPushButton(tr("Remove"));
+	
+	this->toleranceLabel = new QLabel(tr("Tolerance"));
+	this->toleranceSpinBox = new QDoubleSpinBox();
+	this->toleranceSpinBox->setDecimals(2);
+	this->toleranceSpinBox->setRange(0.0, DIVS_VOLTAGE);
+	this->toleranceSpinBox->setSingleStep(0.1);
+	this->toleranceSpinBox->setSuffix(tr(" div"));
+	this->fromTraceButton = new QPushButton(tr("From trace"));
+	
+	this->stopOnFailCheckBox = new QCheckBox(tr("Stop on failure"));
+	this->saveFailuresCheckBox = new QCheckBox(tr("Save failures"));
+	this->failurePathButton = new QPushButton(tr("Folder..."));
+	
+	this->resultLabel = new QLabel();
+	this->resetButton = new QPushButton(tr("Reset"));
+	
+	this->dockLayout = new QGridLayout();
+	this->dockLayout->setColumnMinimumWidth(0, 64);
+	this->dockLayout->setColumnStretch(1, 1);
+	this->dockLayout->addWidget(this->enabledCheckBox, 0, 0, 1, 2);
+	this->dockLayout->addWidget(this->channelLabel, 1, 0);
+	this->dockLayout->addWidget(this->channelComboBox, 1, 1);
+	this->dockLayout->addWidget(this->pointTable, 2, 0, 1, 2);
+	this->dockLayout->addWidget(this->addPointButton, 3, 0);
+	this->dockLayout->addWidget(this->removePointButton, 3, 1);
+	this->dockLayout->addWidget(this->toleranceLabel, 4, 0);
+	this->dockLayout->addWidget(this->toleranceSpinBox, 4, 1);
+	this->dockLayout->addWidget(this->fromTraceButton, 5, 0, 1, 2);
+	this->dockLayout->addWidget(this->stopOnFailCheckBox, 6, 0, 1, 2);
+	this->dockLayout->addWidget(this->saveFailuresCheckBox, 7, 0);
+	this->dockLayout->addWidget(this->failurePathButton, 7, 1);
+	this->dockLayout->addWidget(this->resultLabel, 8, 0);
+	this->dockLayout->addWidget(this->resetButton, 8, 1);
+	
+	this->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+	
+	this->dockWidget = new QWidget();
+	this->dockWidget->setLayout(this->dockLayout);
+	this->setWidget(this->dockWidget);
+	
+	// Set values
+	this->enabledCheckBox->setChecked(this->settings->scope.mask.enabled);
+	if(this->settings->scope.mask.channel < (unsigned int) this->settings->scope.voltage.count())
+		this->channelComboBox->setCurrentIndex(this->settings->scope.mask.channel);
+	this->updatePointTable();
+	this->toleranceSpinBox->setValue(this->settings->scope.mask.tolerance);
+	this->stopOnFailCheckBox->setChecked(this->settings->scope.mask.stopOnFail);
+	this->saveFailuresCheckBox->setChecked(this->settings->scope.mask.saveFailures);
+	this->failurePathButton->setToolTip(this->settings->scope.mask.failurePath);
+	this->resultLabel->setText(tr("Tested: %1, failed: %2").arg(0).arg(0));
+	
+	// Connect signals and slots
+	connect(this->enabledCheckBox, SIGNAL(toggled(bool)), this, SLOT(enabledSwitched(bool)));
+	connect(this->channelComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(channelSelected(int)));
+	connect(this->pointTable, SIGNAL(cellChanged(int, int)), this, SLOT(pointChanged()));
+	connect(this->addPointButton, SIGNAL(clicked()), this, SLOT(addPoint()));
+	connect(this->removePointButton, SIGNAL(clicked()), this, SLOT(removePoint()));
+	connect(this->toleranceSpinBox, SIGNAL(valueChanged(double)), this, SLOT(toleranceChanged(double)));
+	connect(this->fromTraceButton, SIGNAL(clicked()), this, SLOT(createFromTrace()));
+	connect(this->stopOnFailCheckBox, SIGNAL(toggled(bool)), this, SLOT(stopOnFailSwitched(bool)));
+	connect(this->saveFailuresCheckBox, SIGNAL(toggled(bool)), this, SLOT(saveFailuresSwitched(bool)));
+	connect(this->failurePathButton, SIGNAL(clicked()), this, SLOT(selectFailurePath()));
+	connect(this->resetButton, SIGNAL(clicked()), this, SLOT(resetCounters()));
+}
+
+/// \brief Cleans up everything.
+MaskDock::~MaskDock() {
+}
+
+/// \brief Set the data analyzer that tests the frames.
+/// \param dataAnalyzer Pointer to the DataAnalyzer class.
+void MaskDock::setDataAnalyzer(DataAnalyzer *dataAnalyzer) {
+	if(this->dataAnalyzer) {
+		disconnect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this, SLOT(updateCounters()));
+		disconnect(this->dataAnalyzer, SIGNAL(maskFailed()), this, SLOT(frameFailed()));
+	}
+	this->dataAnalyzer = dataAnalyzer;
+	connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this, SLOT(updateCounters()));
+	connect(this->dataAnalyzer, SIGNAL(maskFailed()), this, SLOT(frameFailed()));
+}
+
+/// \brief Don't close the dock, just hide it.
+/// \param event The close event that should be handled.
+void MaskDock::closeEvent(QCloseEvent *event) {
+	this->hide();
+	
+	event->accept();
+}
+
+/// \brief Fills the table with the points of the mask polygon.
+void MaskDock::updatePointTable() {
+	this->pointTable->blockSignals(true);
+	this->pointTable->setRowCount(this->settings->scope.mask.polygon.count());
+	for(int point = 0; point < this->settings->scope.mask.polygon.count(); point++) {
+		this->pointTable->setItem(point, 0, new QTableWidgetItem(QString::number(this->settings->scope.mask.polygon[point].x())));
+		this->pointTable->setItem(point, 1, new QTableWidgetItem(QString::number(this->settings->scope.mask.polygon[point].y())));
+	}
+	this->pointTable->blockSignals(false);
+}
+
+/// \brief Passes the mask polygon from the settings to the data analyzer.
+void MaskDock::applyMask() {
+	if(this->dataAnalyzer)
+		this->dataAnalyzer->setMask(this->settings->scope.mask.polygon);
+}
+
+/// \brief Shows the pass/fail counters of the mask test.
+void MaskDock::updateCounters() {
+	if(!this->dataAnalyzer || !this->isVisible())
+		return;
+	
+	this->dataAnalyzer->mutex()->lock();
+	unsigned long int tested = this->dataAnalyzer->mask()->getTested();
+	unsigned long int failed = this->dataAnalyzer->mask()->getFailed();
+	this->dataAnalyzer->mutex()->unlock();
+	
+	this->resultLabel->setText(tr("Tested: %1, failed: %2").arg(tested).arg(failed));
+}
+
+/// \brief Stops the sampling and saves the frame if requested.
+void MaskDock::frameFailed() {
+	if(this->settings->scope.mask.stopOnFail)
+		emit stopRequested();
+	
+	if(!this->dataAnalyzer || !this->settings->scope.mask.saveFailures || this->settings->scope.mask.failurePath.isEmpty())
+		return;
+	
+	// Get a shared copy, the file is written after the analyzer was released
+	this->dataAnalyzer->mutex()->lock();
+	QVector<double> samples = this->dataAnalyzer->mask()->getFailedFrame();
+	double interval = this->dataAnalyzer->mask()->getFailedInterval();
+	unsigned long int failed = this->dataAnalyzer->mask()->getFailed();
+	this->dataAnalyzer->mutex()->unlock();
+	
+	QFile csvFile(QDir(this->settings->scope.mask.failurePath).filePath(QString("failure%1.csv").arg(failed)));
+	if(!csvFile.open(QIODevice::WriteOnly | QIODevice::Text))
+		return;
+	
+	QTextStream csvStream(&csvFile);
+	csvStream << "\"" << this->settings->scope.voltage[this->settings->scope.mask.channel].name << "\"";
+	for(int position = 0; position < samples.count(); position++)
+		csvStream << "\n" << interval * position << "," << samples[position];
+	csvStream << "\n";
+	
+	csvFile.close();
+}
+
+/// \brief Called when the test checkbox is switched.
+/// \param checked The check-state of the checkbox.
+void MaskDock::enabledSwitched(bool checked) {
+	this->settings->scope.mask.enabled = checked;
+}
+
+/// \brief Called when the channel combo box changes it's value.
+/// \param index The index of the combo box item.
+void MaskDock::channelSelected(int index) {
+	this->settings->scope.mask.channel = index;
+}
+
+/// \brief Called when a point of the mask was edited.
+void MaskDock::pointChanged() {
+	QPolygonF polygon;
+	for(int point = 0; point < this->pointTable->rowCount(); point++) {
+		QTableWidgetItem *xItem = this->pointTable->item(point, 0);
+		QTableWidgetItem *yItem = this->pointTable->item(point, 1);
+		polygon.append(QPointF(xItem ? xItem->text().toDouble() : 0.0, yItem ? yItem->text().toDouble() : 0.0));
+	}
+	
+	this->settings->scope.mask.polygon = polygon;
+	this->applyMask();
+}
+
+/// \brief Appends a point after the selected one.
+void MaskDock::addPoint() {
+	int point = this->pointTable->currentRow() + 1;
+	if(point <= 0)
+		point = this->settings->scope.mask.polygon.count();
+	
+	QPointF newPoint;
+	if(!this->settings->scope.mask.polygon.isEmpty())
+		newPoint = this->settings->scope.mask.polygon[point - 1];
+	this->settings->scope.mask.polygon.insert(point, newPoint);
+	this->updatePointTable();
+	this->pointTable->setCurrentCell(point, 0);
+	this->applyMask();
+}
+
+/// \brief Removes the selected point.
+void MaskDock::removePoint() {
+	int point = this->pointTable->currentRow();
+	if(point < 0 || point >= this->settings->scope.mask.polygon.count())
+		return;
+	
+	this->settings->scope.mask.polygon.remove(point);
+	this->updatePointTable();
+	this->applyMask();
+}
+
+/// \brief Called when the tolerance spin box changes it's value.
+/// \param value The new tolerance in divs.
+void MaskDock::toleranceChanged(double value) {
+	this->settings->scope.mask.tolerance = value;
+}
+
+/// \brief Creates a mask around the current trace of the tested channel.
+void MaskDock::createFromTrace() {
+	unsigned int channel = this->settings->scope.mask.channel;
+	if(!this->dataAnalyzer || channel >= (unsigned int) this->settings->scope.voltage.count())
+		return;
+	
+	this->dataAnalyzer->mutex()->lock();
+	const AnalyzedData *data = this->dataAnalyzer->data(channel);
+	QPolygonF polygon;
+	if(data)
+		polygon = MaskTest::fromTrace(&(data->samples.voltage), this->settings->scope.horizontal.timebase, this->settings->scope.voltage[channel].gain, this->settings->scope.voltage[channel].offset, this->settings->scope.mask.tolerance);
+	this->dataAnalyzer->mutex()->unlock();
+	
+	if(polygon.isEmpty())
+		return;
+	
+	this->settings->scope.mask.polygon = polygon;
+	this->updatePointTable();
+	this->applyMask();
+}
+
+/// \brief Called when the stop on failure checkbox is switched.
+/// \param checked The check-state of the checkbox.
+void MaskDock::stopOnFailSwitched(bool checked) {
+	this->settings->scope.mask.stopOnFail = checked;
+}
+
+/// \brief Called when the save failures checkbox is switched.
+/// \param checked The check-state of the checkbox.
+void MaskDock::saveFailuresSwitched(bool checked) {
+	this->settings->scope.mask.saveFailures = checked;
+	if(checked && this->settings->scope.mask.failurePath.isEmpty())
+		this->selectFailurePath();
+}
+
+/// \brief Asks for the directory the failing frames are saved to.
+void MaskDock::selectFailurePath() {
+	QString path = QFileDialog::getExistingDirectory(this, tr("Save failing frames to"), this->settings->scope.mask.failurePath);
+	if(path.isEmpty())
+		return;
+	
+	this->settings->scope.mask.failurePath = path;
+	this->failurePathButton->setToolTip(path);
+}
+
+/// \brief Called when the reset button is clicked.
+void MaskDock::resetCounters() {
+	if(!this->dataAnalyzer)
+		return;
+	
+	this->dataAnalyzer->resetMaskCounters();
+	this->updateCounters();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class PeakDock
+/// \brief Initializes the spectral peak docking window.
+/// \param settings The target settings object.
+/// \param parent The parent widget.
+/// \param flags Flags for the window manager.
+PeakDock::PeakDock(DsoSettings *settings, QWidget *parent, Qt::WindowFlags flags) : QDockWidget(tr("Peaks"), parent, flags) {
+	this->settings = settings;
+	this->dataAnalyzer = 0;
+	
+	// Initialize elements
+	this->channelLabel = new QLabel(tr("Channel"));
+	this->channelComboBox = new QComboBox();
+	for(int channel = 0; channel < this->settings->scope.spectrum.count(); channel++)
+		this->channelComboBox->addItem(this->settings->scope.spectrum[channel].name);
+	
+	this->countLabel = new QLabel(tr("Peaks"));
+	this->countSpinBox = new QSpinBox();
+	this->countSpinBox->setRange(1, 100);
+	
+	QStringList headerLabels;
+	headerLabels << tr("Frequency") << tr("Level") << tr("Harmonic");
+	this->peakTable = new QTableWidget(0, headerLabels.count());
+	this->peakTable->setHorizontalHeaderLabels(headerLabels);
+	this->peakTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	this->peakTable->setSelectionMode(QAbstractItemView::NoSelection);
+	this->peakTable->verticalHeader()->hide();
+	
+	this->distortionLabel = new QLabel();
+	
+	this->dockLayout = new QGridLayout();
+	this->dockLayout->setColumnMinimumWidth(0, 64);
+	this->dockLayout->setColumnStretch(1, 1);
+	this->dockLayout->addWidget(this->channelLabel, 0, 0);
+	this->dockLayout->addWidget(this->channelComboBox, 0, 1);
+	this->dockLayout->addWidget(this->countLabel, 1, 0);
+	this->dockLayout->addWidget(this->countSpinBox, 1, 1);
+	this->dockLayout->addWidget(this->peakTable, 2, 0, 1, 2);
+	this->dockLayout->addWidget(this->distortionLabel, 3, 0, 1, 2);
+	
+	this->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+	
+	this->dockWidget = new QWidget();
+	this->dockWidget->setLayout(this->dockLayout);
+	this->setWidget(this->dockWidget);
+	
+	// Set values
+	this->countSpinBox->setValue(this->settings->scope.spectrumPeaks);
+	
+	// Connect signals and slots
+	connect(this->channelComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(updatePeaks()));
+	connect(this->countSpinBox, SIGNAL(valueChanged(int)), this, SLOT(countChanged(int)));
+}
+
+/// \brief Cleans up everything.
+PeakDock::~PeakDock() {
+}
+
+/// \brief Set the data analyzer whose peaks will be shown.
+/// \param dataAnalyzer Pointer to the DataAnalyzer class.
+void PeakDock::setDataAnalyzer(DataAnalyzer *dataAnalyzer) {
+	if(this->dataAnalyzer)
+		disconnect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this, SLOT(updatePeaks()));
+	this->dataAnalyzer = dataAnalyzer;
+	connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this, SLOT(updatePeaks()));
+}
+
+/// \brief Don't close the dock, just hide it.
+/// \param event The close event that should be handled.
+void PeakDock::closeEvent(QCloseEvent *event) {
+	this->hide();
+	
+	event->accept();
+}
+
+/// \brief Shows the peaks of the selected spectrum.
+void PeakDock::updatePeaks() {
+	if(!this->dataAnalyzer || !this->isVisible())
+		return;
+	
+	int channel = this->channelComboBox->currentIndex();
+	
+	// Copy the results, the table is filled after the analyzer was released
+	QList<SpectrumPeak> peaks;
+	int harmonics = 0;
+	double thd = 0, sinad = 0, sfdr = 0;
+	this->dataAnalyzer->mutex()->lock();
+	const PeakFinder *peakFinder = this->dataAnalyzer->peaks(channel);
+	if(peakFinder) {
+		peaks = peakFinder->getPeaks();
+		harmonics = peakFinder->getHarmonics().count();
+		thd = peakFinder->getThd();
+		sinad = peakFinder->getSinad();
+		sfdr = peakFinder->getSfdr();
+	}
+	this->dataAnalyzer->mutex()->unlock();
+	
+	this->peakTable->setRowCount(peaks.count());
+	for(int row = 0; row < peaks.count(); row++) {
+		QStringList values;
+		values << Helper::valueToString(peaks[row].frequency, Helper::UNIT_HERTZ, 5);
+		values << Helper::valueToString(peaks[row].level, Helper::UNIT_DECIBEL, 4);
+		if(peaks[row].harmonic)
+			values << QString::number(peaks[row].harmonic);
+		else
+			values << QString();
+		
+		for(int column = 0; column < values.count(); column++) {
+			QTableWidgetItem *item = this->peakTable->item(row, column);
+			if(!item) {
+				item = new QTableWidgetItem();
+				this->peakTable->setItem(row, column, item);
+			}
+			item->setText(values[column]);
+		}
+	}
+	
+	if(peaks.isEmpty())
+		this->distortionLabel->setText(tr("No spectrum"));
+	else if(harmonics < 2)
+		this->distortionLabel->setText(tr("THD: -\nSINAD: %1\nSFDR: %2").arg(Helper::valueToString(sinad, Helper::UNIT_DECIBEL, 4), Helper::valueToString(sfdr, Helper::UNIT_DECIBEL, 4)));
+	else
+		this->distortionLabel->setText(tr("THD: %1 (%L2%)\nSINAD: %3\nSFDR: %4").arg(Helper::valueToString(thd, Helper::UNIT_DECIBEL, 4)).arg(100 * pow(10.0, thd / 20), 0, 'g', 4).arg(Helper::valueToString(sinad, Helper::UNIT_DECIBEL, 4), Helper::valueToString(sfdr, Helper::UNIT_DECIBEL, 4)));
+}
+
+/// \brief Called when the peak count spinbox changes its value.
+/// \param value The new number of peaks.
+void PeakDock::countChanged(int value) {
+	this->settings->scope.spectrumPeaks = value;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class PlaybackDock
+/// \brief Initializes the capture playback docking window.
+/// \param settings The target settings object.
+/// \param parent The parent widget.
+/// \param flags Flags for the window manager.
+PlaybackDock::PlaybackDock(DsoSettings *settings, QWidget *parent, Qt::WindowFlags flags) : QDockWidget(tr("Playback"), parent, flags) {
+	this->settings = settings;
+	this->capturePlayer = 0;
+	
+	// Initialize elements
+	this->openButton = new QPushButton(tr("Open..."));
+	this->fileLabel = new QLabel();
+	
+	this->overview = new CaptureOverview(this->settings);
+	
+	this->frameSlider = new QSlider(Qt::Horizontal);
+	this->frameLabel = new QLabel();
+	
+	this->playButton = new QPushButton(tr("Play"));
+	this->playButton->setCheckable(true);
+	this->closeButton = new QPushButton(tr("Close"));
+	
+	this->dockLayout = new QGridLayout();
+	this->dockLayout->setColumnStretch(1, 1);
+	this->dockLayout->addWidget(this->openButton, 0, 0);
+	this->dockLayout->addWidget(this->fileLabel, 0, 1, 1, 2);
+	this->dockLayout->addWidget(this->overview, 1, 0, 1, 3);
+	this->dockLayout->addWidget(this->frameSlider, 2, 0, 1, 3);
+	this->dockLayout->addWidget(this->frameLabel, 3, 0, 1, 3);
+	this->dockLayout->addWidget(this->playButton, 4, 0);
+	this->dockLayout->addWidget(this->closeButton, 4, 2);
+	
+	this->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+	
+	this->dockWidget = new QWidget();
+	this->dockWidget->setLayout(this->dockLayout);
+	this->setWidget(this->dockWidget);
+	
+	// Set values
+	this->closed();
+	
+	// Connect signals and slots
+	connect(this->openButton, SIGNAL(clicked()), this, SLOT(open()));
+	connect(this->frameSlider, SIGNAL(valueChanged(int)), this, SLOT(sliderChanged(int)));
+}
+
+/// \brief Cleans up everything.
+PlaybackDock::~PlaybackDock() {
+}
+
+/// \brief Set the player that opens the captures.
+/// \param capturePlayer Pointer to the CapturePlayer class.
+void PlaybackDock::setPlayer(CapturePlayer *capturePlayer) {
+	if(this->capturePlayer)
+		disconnect(this->capturePlayer, 0, this, 0);
+	this->capturePlayer = capturePlayer;
+	
+	connect(this->capturePlayer, SIGNAL(opened(unsigned int)), this, SLOT(opened(unsigned int)));
+	connect(this->capturePlayer, SIGNAL(closed()), this, SLOT(closed()));
+	connect(this->capturePlayer, SIGNAL(frameChanged(unsigned int)), this, SLOT(frameChanged(unsigned int)));
+	connect(this->capturePlayer, SIGNAL(frameChanged(unsigned int)), this->overview, SLOT(setFrame(unsigned int)));
+	connect(this->capturePlayer, SIGNAL(playingChanged(bool)), this->playButton, SLOT(setChecked(bool)));
+	connect(this->overview, SIGNAL(frameSelected(unsigned int)), this->capturePlayer, SLOT(setFrame(unsigned int)));
+	connect(this->playButton, SIGNAL(toggled(bool)), this->capturePlayer, SLOT(setPlaying(bool)));
+	connect(this->closeButton, SIGNAL(clicked()), this->capturePlayer, SLOT(close()));
+}
+
+/// \brief Don't close the dock, just hide it.
+/// \param event The close event that should be handled.
+void PlaybackDock::closeEvent(QCloseEvent *event) {
+	this->hide();
+	
+	event->accept();
+}
+
+/// \brief Asks for a capture file and opens it.
+void PlaybackDock::open() {
+	if(!this->capturePlayer)
+		return;
+	
+	QString filename = QFileDialog::getOpenFileName(this, tr("Open capture"), this->settings->options.recorder.path, tr("OpenHantek capture (*.ohc)"));
+	if(filename.isEmpty())
+		return;
+	
+	if(this->capturePlayer->open(filename))
+		this->fileLabel->setText(QFileInfo(filename).fileName());
+	else
+		this->fileLabel->setText(tr("Can't open %1").arg(QFileInfo(filename).fileName()));
+}
+
+/// \brief Enables the controls for the opened capture.
+/// \param frames The number of frames in the capture.
+void PlaybackDock::opened(unsigned int frames) {
+	this->overview->setCapture(this->capturePlayer->getCaptureFile());
+	
+	this->frameSlider->blockSignals(true);
+	this->frameSlider->setRange(0, frames - 1);
+	this->frameSlider->setValue(0);
+	this->frameSlider->blockSignals(false);
+	
+	this->overview->setEnabled(true);
+	this->frameSlider->setEnabled(true);
+	this->playButton->setEnabled(true);
+	this->closeButton->setEnabled(true);
+}
+
+/// \brief Disables the controls after the capture was closed.
+void PlaybackDock::closed() {
+	this->overview->setCapture(0);
+	
+	this->frameSlider->blockSignals(true);
+	this->frameSlider->setRange(0, 0);
+	this->frameSlider->blockSignals(false);
+	this->frameLabel->setText(tr("No capture opened"));
+	this->fileLabel->clear();
+	
+	this->overview->setEnabled(false);
+	this->frameSlider->setEnabled(false);
+	this->playButton->setEnabled(false);
+	this->closeButton->setEnabled(false);
+}
+
+/// \brief Shows the number and time of the current frame.
+/// \param frame The index of the frame.
+void PlaybackDock::frameChanged(unsigned int frame) {
+	this->frameSlider->blockSignals(true);
+	this->frameSlider->setValue(frame);
+	this->frameSlider->blockSignals(false);
+	
+	const CaptureHeader *header = this->capturePlayer->getCaptureFile()->header(frame);
+	this->frameLabel->setText(tr("Frame %L1 of %L2, %3").arg(frame + 1).arg(this->capturePlayer->getFrameCount()).arg(QDateTime::fromMSecsSinceEpoch(header->timestamp).toString("yyyy-MM-dd hh:mm:ss.zzz")));
+}
+
+/// \brief Called when the frame slider was moved.
+/// \param value The index of the selected frame.
+void PlaybackDock::sliderChanged(int value) {
+	if(this->capturePlayer)
+		this->capturePlayer->setFrame(value);
+}
@@ -35,9 +35,18 @@
 #include "settings.h"
 
 
+class CaptureOverview;
+class CapturePlayer;
+class DataAnalyzer;
 class QLabel;
 class QCheckBox;
 class QComboBox;
+class QDoubleSpinBox;
+class QListWidget;
+class QPushButton;
+class QSlider;
+class QSpinBox;
+class QTableWidget;
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -50,7 +59,8 @@ class HorizontalDock : public QDockWidget {
 	public:
 		HorizontalDock(DsoSettings *settings, QWidget *parent = 0, Qt::WindowFlags flags = 0);
 		~HorizontalDock();
-		
+	
+	public slots:
 		int setFrequencybase(double timebase);
 		int setTimebase(double timebase);
 		int setFormat(Dso::GraphFormat format);
@@ -97,7 +107,8 @@ class TriggerDock : public QDockWidget {
 	public:
 		TriggerDock(DsoSettings *settings, const QStringList *specialTriggers, QWidget *parent = 0, Qt::WindowFlags flags = 0);
 		~TriggerDock();
-		
+	
+	public slots:
 		int setMode(Dso::TriggerMode mode);
 		int setSource(bool special, unsigned int id);
 		int setSlope(Dso::Slope slope);
@@ -144,7 +155,8 @@ class VoltageDock : public QDockWidget {
 	public:
 		VoltageDock(DsoSettings *settings, QWidget *parent = 0, Qt::WindowFlags flags = 0);
 		~VoltageDock();
-		
+	
+	public slots:
 		int setCoupling(int channel, Dso::Coupling coupling);
 		int setGain(int channel, double gain);
 		int setMode(Dso::MathMode mode);
@@ -217,4 +229,224 @@ class SpectrumDock : public QDockWidget {
 };
 
 
+////////////////////////////////////////////////////////////////////////////////
+/// \class DecoderDock                                             dockwindows.h
+/// \brief Dock window for the serial protocol decoder.
+/// It contains the protocol settings and lists the decoded words.
+class DecoderDock : public QDockWidget {
+	Q_OBJECT
+	
+	public:
+		DecoderDock(DsoSettings *settings, QWidget *parent = 0, Qt::WindowFlags flags = 0);
+		~DecoderDock();
+		
+		void setDataAnalyzer(DataAnalyzer *dataAnalyzer);
+	
+	protected:
+		void closeEvent(QCloseEvent *event);
+		void updateLineLabels();
+		
+		QGridLayout *dockLayout; ///< The main layout for the dock window
+		QWidget *dockWidget; ///< The main widget for the dock window
+		QCheckBox *enabledCheckBox; ///< Enable/disable the decoder
+		QLabel *protocolLabel; ///< The label for the protocol combobox
+		QComboBox *protocolComboBox; ///< Select the decoded protocol
+		QLabel *lineLabel[2]; ///< The labels for the line comboboxes
+		QComboBox *lineComboBox[DECODER_LINES]; ///< Select the channels of the lines
+		QLabel *thresholdLabel; ///< The label for the threshold spinbox
+		QDoubleSpinBox *thresholdSpinBox; ///< Set the logic threshold
+		QLabel *hysteresisLabel; ///< The label for the hysteresis spinbox
+		QDoubleSpinBox *hysteresisSpinBox; ///< Set the width of the hysteresis band
+		QLabel *baudrateLabel; ///< The label for the baudrate spinbox
+		QSpinBox *baudrateSpinBox; ///< Set the UART bitrate
+		QLabel *clockSlopeLabel; ///< The label for the clock slope combobox
+		QComboBox *clockSlopeComboBox; ///< Select the SPI sampling edge
+		QListWidget *annotationList; ///< Shows the decoded words
+		
+		DsoSettings *settings; ///< The settings provided by the parent class
+		DataAnalyzer *dataAnalyzer; ///< The source of the decoded words
+	
+	public slots:
+		void updateAnnotations();
+	
+	protected slots:
+		void enabledSwitched(bool checked);
+		void protocolSelected(int index);
+		void lineSelected(int index);
+		void thresholdChanged(double value);
+		void hysteresisChanged(double value);
+		void baudrateChanged(int value);
+		void clockSlopeSelected(int index);
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class StatisticsDock                                          dockwindows.h
+/// \brief Dock window for the measurement statistics.
+/// It shows count, mean, standard deviation and range of the automatic
+/// measurements since the last reset.
+class StatisticsDock : public QDockWidget {
+	Q_OBJECT
+	
+	public:
+		StatisticsDock(DsoSettings *settings, QWidget *parent = 0, Qt::WindowFlags flags = 0);
+		~StatisticsDock();
+		
+		void setDataAnalyzer(DataAnalyzer *dataAnalyzer);
+	
+	protected:
+		void closeEvent(QCloseEvent *event);
+		
+		QGridLayout *dockLayout; ///< The main layout for the dock window
+		QWidget *dockWidget; ///< The main widget for the dock window
+		QTableWidget *statisticsTable; ///< Shows the statistics of all measurements
+		QPushButton *resetButton; ///< Clears the collected statistics
+		QPushButton *exportButton; ///< Saves the statistics and histograms as CSV
+		
+		DsoSettings *settings; ///< The settings provided by the parent class
+		DataAnalyzer *dataAnalyzer; ///< The source of the statistics
+	
+	public slots:
+		void updateStatistics();
+	
+	protected slots:
+		void resetStatistics();
+		void exportStatistics();
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class MaskDock                                                dockwindows.h
+/// \brief Dock window for the pass/fail mask test.
+/// It contains the mask points, the actions on failures and the counters.
+class MaskDock : public QDockWidget {
+	Q_OBJECT
+	
+	public:
+		MaskDock(DsoSettings *settings, QWidget *parent = 0, Qt::WindowFlags flags = 0);
+		~MaskDock();
+		
+		void setDataAnalyzer(DataAnalyzer *dataAnalyzer);
+	
+	protected:
+		void closeEvent(QCloseEvent *event);
+		void updatePointTable();
+		void applyMask();
+		
+		QGridLayout *dockLayout; ///< The main layout for the dock window
+		QWidget *dockWidget; ///< The main widget for the dock window
+		QCheckBox *enabledCheckBox; ///< Enable/disable the mask test
+		QLabel *channelLabel; ///< The label for the channel combobox
+		QComboBox *channelComboBox; ///< Select the tested channel
+		QTableWidget *pointTable; ///< The editable points of the mask polygon
+		QPushButton *addPointButton; ///< Appends a point to the polygon
+		QPushButton *removePointButton; ///< Removes the selected point
+		QLabel *toleranceLabel; ///< The label for the tolerance spinbox
+		QDoubleSpinBox *toleranceSpinBox; ///< Set the distance of a mask from the trace
+		QPushButton *fromTraceButton; ///< Creates the mask from the current trace
+		QCheckBox *stopOnFailCheckBox; ///< Stop the sampling on a failure
+		QCheckBox *saveFailuresCheckBox; ///< Save the failing frames
+		QPushButton *failurePathButton; ///< Select the directory for the failing frames
+		QLabel *resultLabel; ///< Shows the pass/fail counters
+		QPushButton *resetButton; ///< Resets the counters
+		
+		DsoSettings *settings; ///< The settings provided by the parent class
+		DataAnalyzer *dataAnalyzer; ///< The analyzer that tests the frames
+	
+	public slots:
+		void updateCounters();
+		void frameFailed();
+	
+	protected slots:
+		void enabledSwitched(bool checked);
+		void channelSelected(int index);
+		void pointChanged();
+		void addPoint();
+		void removePoint();
+		void toleranceChanged(double value);
+		void createFromTrace();
+		void stopOnFailSwitched(bool checked);
+		void saveFailuresSwitched(bool checked);
+		void selectFailurePath();
+		void resetCounters();
+	
+	signals:
+		void stopRequested(); ///< The sampling should be stopped after a failure
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class PeakDock                                                dockwindows.h
+/// \brief Dock window for the spectral peaks.
+/// It lists the highest peaks of a spectrum and the harmonic distortion.
+class PeakDock : public QDockWidget {
+	Q_OBJECT
+	
+	public:
+		PeakDock(DsoSettings *settings, QWidget *parent = 0, Qt::WindowFlags flags = 0);
+		~PeakDock();
+		
+		void setDataAnalyzer(DataAnalyzer *dataAnalyzer);
+	
+	protected:
+		void closeEvent(QCloseEvent *event);
+		
+		QGridLayout *dockLayout; ///< The main layout for the dock window
+		QWidget *dockWidget; ///< The main widget for the dock window
+		QLabel *channelLabel; ///< The label for the channel combobox
+		QComboBox *channelComboBox; ///< Select the shown spectrum
+		QLabel *countLabel; ///< The label for the peak count spinbox
+		QSpinBox *countSpinBox; ///< Set the number of listed peaks
+		QTableWidget *peakTable; ///< Shows the highest peaks
+		QLabel *distortionLabel; ///< Shows THD, SINAD and SFDR
+		
+		DsoSettings *settings; ///< The settings provided by the parent class
+		DataAnalyzer *dataAnalyzer; ///< The analyzer that finds the peaks
+	
+	public slots:
+		void updatePeaks();
+	
+	protected slots:
+		void countChanged(int value);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class PlaybackDock                                            dockwindows.h
+/// \brief Dock window for browsing recorded captures.
+/// The shown frame is passed through the analyzer, so all other windows work
+/// on it like on the samples of the oscilloscope.
+class PlaybackDock : public QDockWidget {
+	Q_OBJECT
+	
+	public:
+		PlaybackDock(DsoSettings *settings, QWidget *parent = 0, Qt::WindowFlags flags = 0);
+		~PlaybackDock();
+		
+		void setPlayer(CapturePlayer *capturePlayer);
+	
+	protected:
+		void closeEvent(QCloseEvent *event);
+		
+		QGridLayout *dockLayout; ///< The main layout for the dock window
+		QWidget *dockWidget; ///< The main widget for the dock window
+		QPushButton *openButton; ///< Opens a capture file
+		QLabel *fileLabel; ///< Shows the name of the opened file
+		CaptureOverview *overview; ///< Shows the envelope of all frames
+		QSlider *frameSlider; ///< Selects the shown frame
+		QLabel *frameLabel; ///< Shows the frame number and its time
+		QPushButton *playButton; ///< Starts and stops the playback
+		QPushButton *closeButton; ///< Closes the capture file
+		
+		DsoSettings *settings; ///< The settings provided by the parent class
+		CapturePlayer *capturePlayer; ///< The player for the opened capture
+	
+	protected slots:
+		void open();
+		void opened(unsigned int frames);
+		void closed();
+		void frameChanged(unsigned int frame);
+		void sliderChanged(int value);
+};
+
+
 #endif
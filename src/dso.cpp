@@ -52,6 +52,10 @@ namespace Dso {
 				return QApplication::tr("T - Y");
 			case GRAPHFORMAT_XY:
 				return QApplication::tr("X - Y");
+			case GRAPHFORMAT_EYE:
+				return QApplication::tr("Eye diagram");
+			case GRAPHFORMAT_WATERFALL:
+				return QApplication::tr("Waterfall");
 			default:
 				return QString();
 		}
@@ -174,4 +178,48 @@ namespace Dso {
 				return QString();
 		}
 	}
+	
+	/// \brief Return string representation of the given measurement.
+	/// \param measurement The #Measurement that should be returned as string.
+	/// \return The string that should be used in labels etc.
+	QString measurementString(Measurement measurement) {
+		switch(measurement) {
+			case MEASUREMENT_AMPLITUDE:
+				return QApplication::tr("Amplitude");
+			case MEASUREMENT_FREQUENCY:
+				return QApplication::tr("Frequency");
+			default:
+				return QString();
+		}
+	}
+	
+	/// \brief Return string representation of the given decoder protocol.
+	/// \param protocol The #DecoderProtocol that should be returned as string.
+	/// \return The string that should be used in labels etc.
+	QString decoderProtocolString(DecoderProtocol protocol) {
+		switch(protocol) {
+			case DECODER_UART:
+				return QApplication::tr("UART");
+			case DECODER_SPI:
+				return QApplication::tr("SPI");
+			case DECODER_I2C:
+				return QApplication::tr("I\262C");
+			default:
+				return QString();
+		}
+	}
+	
+	/// \brief Return string representation of the given CSV layout.
+	/// \param layout The #CsvLayout that should be returned as string.
+	/// \return The string that should be used in labels etc.
+	QString csvLayoutString(CsvLayout layout) {
+		switch(layout) {
+			case CSV_ROWS:
+				return QApplication::tr("Channels in rows");
+			case CSV_COLUMNS:
+				return QApplication::tr("Channels in columns");
+			default:
+				return QString();
+		}
+	}
 }
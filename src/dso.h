@@ -30,7 +30,12 @@
 #include <QString>
 
 
+#define DIVS_TIME                  10.0 ///< Number of horizontal screen divs
+#define DIVS_VOLTAGE                8.0 ///< Number of vertical screen divs
+#define DIVS_SUB                      5 ///< Number of sub-divisions per div
+
 #define MARKER_COUNT                  2 ///< Number of markers
+#define DECODER_LINES                 2 ///< Maximum number of decoded channels
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -52,6 +57,8 @@ namespace Dso {
 	enum GraphFormat {
 		GRAPHFORMAT_TY,                     ///< The standard mode
 		GRAPHFORMAT_XY,                     ///< CH1 on X-axis, CH2 on Y-axis
+		GRAPHFORMAT_EYE,                    ///< Persistence histogram of symbols
+		GRAPHFORMAT_WATERFALL,              ///< Scrolling history of the spectra
 		GRAPHFORMAT_COUNT                   ///< The total number of formats
 	};
 	
@@ -128,6 +135,34 @@ namespace Dso {
 		INTERPOLATION_COUNT                 ///< Total number of interpolation modes
 	};
 	
+	//////////////////////////////////////////////////////////////////////////////
+	/// \enum Measurement                                                    dso.h
+	/// \brief The automatic measurements for each channel.
+	enum Measurement {
+		MEASUREMENT_AMPLITUDE,              ///< Peak-to-peak voltage
+		MEASUREMENT_FREQUENCY,              ///< Frequency from the autocorrelation
+		MEASUREMENT_COUNT                   ///< Total number of measurements
+	};
+	
+	//////////////////////////////////////////////////////////////////////////////
+	/// \enum DecoderProtocol                                                dso.h
+	/// \brief The serial protocols that can be decoded.
+	enum DecoderProtocol {
+		DECODER_UART,                       ///< Asynchronous serial, 8N1
+		DECODER_SPI,                        ///< Clock and data line, MSB first
+		DECODER_I2C,                        ///< SCL and SDA line
+		DECODER_COUNT                       ///< Total number of protocols
+	};
+	
+	//////////////////////////////////////////////////////////////////////////////
+	/// \enum CsvLayout                                                      dso.h
+	/// \brief The table layouts for exported CSV files.
+	enum CsvLayout {
+		CSV_ROWS,                           ///< One line per channel
+		CSV_COLUMNS,                        ///< One line per sample, one column per channel
+		CSV_COUNT                           ///< Total number of layouts
+	};
+	
 	QString channelModeString(ChannelMode mode);
 	QString graphFormatString(GraphFormat format);
 	QString couplingString(Coupling coupling);
@@ -136,6 +171,9 @@ namespace Dso {
 	QString slopeString(Slope slope);
 	QString windowFunctionString(WindowFunction window);
 	QString interpolationModeString(InterpolationMode interpolation);
+	QString measurementString(Measurement measurement);
+	QString decoderProtocolString(DecoderProtocol protocol);
+	QString csvLayoutString(CsvLayout layout);
 }
 
 
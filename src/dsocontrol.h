@@ -47,6 +47,7 @@ class DsoControl : public QThread {
 		DsoControl(QObject *parent = 0);
 		
 		virtual unsigned int getChannelCount() = 0; ///< Get the number of channels for this oscilloscope
+		virtual QString getModelName() = 0; ///< Get the name of the connected oscilloscope model
 		
 		const QStringList *getSpecialTriggerSources();
 	
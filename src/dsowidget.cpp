@@ -36,6 +36,7 @@
 #include "glscope.h"
 #include "helper.h"
 #include "levelslider.h"
+#include "renderscheduler.h"
 #include "settings.h"
 
 
@@ -60,9 +61,15 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 	this->generator->setDataAnalyzer(this->dataAnalyzer);
 	this->mainScope = new GlScope(this->settings);
 	this->mainScope->setGenerator(this->generator);
-	this->zoomScope = new GlScope(this->settings);
+	// The zoomed scope draws from the vertex buffers of the main scope
+	this->zoomScope = new GlScope(this->settings, 0, this->mainScope);
 	this->zoomScope->setGenerator(this->generator);
 	this->zoomScope->setZoomMode(true);
+	// Limits the generated and drawn frames to the configured frame rate
+	this->scheduler = new RenderScheduler(this->settings, this);
+	this->scheduler->setGenerator(this->generator);
+	this->scheduler->addScope(this->mainScope);
+	this->scheduler->addScope(this->zoomScope);
 	
 	// The offset sliders for all possible channels
 	this->offsetSlider = new LevelSlider(Qt::RightArrow);
@@ -126,12 +133,16 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 	this->settingsFrequencybaseLabel = new QLabel();
 	this->settingsFrequencybaseLabel->setAlignment(Qt::AlignRight);
 	this->settingsFrequencybaseLabel->setPalette(palette);
+	this->settingsFramesLabel = new QLabel();
+	this->settingsFramesLabel->setAlignment(Qt::AlignRight);
+	this->settingsFramesLabel->setPalette(palette);
 	this->settingsLayout = new QHBoxLayout();
 	this->settingsLayout->addWidget(this->settingsTriggerLabel);
 	this->settingsLayout->addWidget(this->settingsBufferLabel, 1);
 	this->settingsLayout->addWidget(this->settingsRateLabel, 1);
 	this->settingsLayout->addWidget(this->settingsTimebaseLabel, 1);
 	this->settingsLayout->addWidget(this->settingsFrequencybaseLabel, 1);
+	this->settingsLayout->addWidget(this->settingsFramesLabel, 1);
 	
 	// The table for the marker details
 	this->markerInfoLabel = new QLabel();
@@ -165,6 +176,7 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 	this->measurementLayout->setColumnStretch(3, 2);
 	this->measurementLayout->setColumnStretch(4, 3);
 	this->measurementLayout->setColumnStretch(5, 3);
+	this->measurementLayout->setColumnStretch(6, 4);
 	for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
 		tablePalette.setColor(QPalette::WindowText, this->settings->view.color.screen.voltage[channel]);
 		this->measurementNameLabel.append(new QLabel(this->settings->scope.voltage[channel].name));
@@ -184,6 +196,9 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 		this->measurementFrequencyLabel.append(new QLabel());
 		this->measurementFrequencyLabel[channel]->setAlignment(Qt::AlignRight);
 		this->measurementFrequencyLabel[channel]->setPalette(palette);
+		this->measurementPhaseLabel.append(new QLabel());
+		this->measurementPhaseLabel[channel]->setAlignment(Qt::AlignRight);
+		this->measurementPhaseLabel[channel]->setPalette(palette);
 		this->setMeasurementVisible(channel, this->settings->scope.voltage[channel].used);
 		this->measurementLayout->addWidget(this->measurementNameLabel[channel], channel, 0);
 		this->measurementLayout->addWidget(this->measurementMiscLabel[channel], channel, 1);
@@ -191,6 +206,7 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 		this->measurementLayout->addWidget(this->measurementMagnitudeLabel[channel], channel, 3);
 		this->measurementLayout->addWidget(this->measurementAmplitudeLabel[channel], channel, 4);
 		this->measurementLayout->addWidget(this->measurementFrequencyLabel[channel], channel, 5);
+		this->measurementLayout->addWidget(this->measurementPhaseLabel[channel], channel, 6);
 		if((unsigned int) channel < this->settings->scope.physicalChannels)
 			this->updateVoltageCoupling(channel);
 		else
@@ -241,10 +257,10 @@ DsoWidget::DsoWidget(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget
 	this->connect(this->triggerPositionSlider, SIGNAL(valueChanged(int, double)), this, SLOT(updateTriggerPosition(int, double)));
 	this->connect(this->triggerLevelSlider, SIGNAL(valueChanged(int, double)), this, SLOT(updateTriggerLevel(int, double)));
 	this->connect(this->markerSlider, SIGNAL(valueChanged(int, double)), this, SLOT(updateMarker(int, double)));
-	this->connect(this->markerSlider, SIGNAL(valueChanged(int, double)), this->mainScope, SLOT(updateGL()));
-	this->connect(this->markerSlider, SIGNAL(valueChanged(int, double)), this->zoomScope, SLOT(updateGL()));
 	
 	// Connect other signals
+	this->connect(this->dataAnalyzer, SIGNAL(finished()), this->scheduler, SLOT(requestFrame()));
+	this->connect(this->scheduler, SIGNAL(framesCounted(unsigned int, unsigned int)), this, SLOT(updateFrames(unsigned int, unsigned int)));
 	this->connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this, SLOT(dataAnalyzed()));
 	this->connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this, SLOT(updateBufferSize(unsigned int)));
 }
@@ -267,11 +283,13 @@ void DsoWidget::setMeasurementVisible(unsigned int channel, bool visible) {
 	this->measurementMagnitudeLabel[channel]->setVisible(visible);
 	this->measurementAmplitudeLabel[channel]->setVisible(visible);
 	this->measurementFrequencyLabel[channel]->setVisible(visible);
+	this->measurementPhaseLabel[channel]->setVisible(visible);
 	if(!visible) {
 		this->measurementGainLabel[channel]->setText(QString());
 		this->measurementMagnitudeLabel[channel]->setText(QString());
 		this->measurementAmplitudeLabel[channel]->setText(QString());
 		this->measurementFrequencyLabel[channel]->setText(QString());
+		this->measurementPhaseLabel[channel]->setText(QString());
 	}
 }
 
@@ -325,9 +343,18 @@ void DsoWidget::updateVoltageDetails(unsigned int channel) {
 		this->measurementGainLabel[channel]->setText(QString());
 }
 
+/// \brief Redraw the scopes with the current view settings.
+void DsoWidget::updateView() {
+	this->mainScope->resetPhosphor();
+	this->zoomScope->resetPhosphor();
+	this->scheduler->requestRedraw();
+}
+
 /// \brief Handles frequencybaseChanged signal from the horizontal dock.
 void DsoWidget::updateFrequencybase() {
 	this->settingsFrequencybaseLabel->setText(Helper::valueToString(this->settings->scope.horizontal.frequencybase, Helper::UNIT_HERTZ, 0) + tr("/div"));
+	
+	this->updateView();
 }
 
 /// \brief Updates the samplerate field after changing the samplerate.
@@ -340,12 +367,14 @@ void DsoWidget::updateTimebase() {
 	this->settingsTimebaseLabel->setText(Helper::valueToString(this->settings->scope.horizontal.timebase, Helper::UNIT_SECONDS, 0) + tr("/div"));
 	
 	this->updateMarkerDetails();
+	this->updateView();
 }
 
 /// \brief Handles magnitudeChanged signal from the spectrum dock.
 /// \param channel The channel whose magnitude was changed.
 void DsoWidget::updateSpectrumMagnitude(unsigned int channel) {
 	this->updateSpectrumDetails(channel);
+	this->updateView();
 }
 
 /// \brief Handles usedChanged signal from the spectrum dock.
@@ -408,6 +437,7 @@ void DsoWidget::updateVoltageGain(unsigned int channel) {
 		this->adaptTriggerLevelSlider(channel);
 	
 	this->updateVoltageDetails(channel);
+	this->updateView();
 }
 
 /// \brief Handles usedChanged signal from the voltage dock.
@@ -424,6 +454,16 @@ void DsoWidget::updateVoltageUsed(unsigned int channel, bool used) {
 	this->updateVoltageDetails(channel);
 }
 
+/// \brief Show the frame counters of the render scheduler.
+/// \param shown The number of frames shown during the last second.
+/// \param skipped The number of frames skipped during the last second.
+void DsoWidget::updateFrames(unsigned int shown, unsigned int skipped) {
+	if(skipped)
+		this->settingsFramesLabel->setText(tr("%1 fps (%2 skipped)").arg(shown).arg(skipped));
+	else
+		this->settingsFramesLabel->setText(tr("%1 fps").arg(shown));
+}
+
 /// \brief Change the buffer size.
 void DsoWidget::updateBufferSize(unsigned int size) {
 	this->settingsBufferLabel->setText(tr("%1 S").arg(size));
@@ -437,7 +477,8 @@ bool DsoWidget::exportAs() {
 			<< tr("Portable Document Format (*.pdf)")
 			<< tr("PostScript (*.ps)")
 			<< tr("Image (*.png *.xpm *.jpg)")
-			<< tr("Comma-Separated Values (*.csv)");
+			<< tr("Comma-Separated Values (*.csv)")
+			<< tr("OpenHantek capture (*.ohc)");
 	
 	QFileDialog fileDialog((QWidget *) this->parent(), tr("Export file..."), QString(), filters.join(";;"));
 	fileDialog.setFileMode(QFileDialog::AnyFile);
@@ -445,9 +486,10 @@ bool DsoWidget::exportAs() {
 	if(fileDialog.exec() != QDialog::Accepted)
 		return false;
 	
-	Exporter exporter(this->settings, this->dataAnalyzer, (QWidget *) this->parent());
+	Exporter exporter(this->settings, this->dataAnalyzer, this->generator, (QWidget *) this->parent());
 	exporter.setFilename(fileDialog.selectedFiles().first());
 	exporter.setFormat((ExportFormat) (EXPORT_FORMAT_PDF + filters.indexOf(fileDialog.selectedFilter())));
+	exporter.setPhosphor(this->mainScope->phosphorImage(), this->zoomScope->phosphorImage());
 	
 	return exporter.doExport();
 }
@@ -455,8 +497,9 @@ bool DsoWidget::exportAs() {
 /// \brief Print the oscilloscope screen.
 /// \return true if the document was sent to the printer successfully.
 bool DsoWidget::print() {
-	Exporter exporter(this->settings, this->dataAnalyzer, (QWidget *) this->parent());
+	Exporter exporter(this->settings, this->dataAnalyzer, this->generator, (QWidget *) this->parent());
 	exporter.setFormat(EXPORT_FORMAT_PRINTER);
+	exporter.setPhosphor(this->mainScope->phosphorImage(), this->zoomScope->phosphorImage());
 	
 	return exporter.doExport();
 }
@@ -487,6 +530,11 @@ void DsoWidget::dataAnalyzed() {
 			this->measurementAmplitudeLabel[channel]->setText(Helper::valueToString(this->dataAnalyzer->data(channel)->amplitude, Helper::UNIT_VOLTS, 4));
 			// Frequency string representation (5 significant digits)
 			this->measurementFrequencyLabel[channel]->setText(Helper::valueToString(this->dataAnalyzer->data(channel)->frequency, Helper::UNIT_HERTZ, 5));
+			// Delay and phase relative to the first channel
+			if(channel > 0 && this->settings->scope.voltage[0].used)
+				this->measurementPhaseLabel[channel]->setText(tr("%1 / %L2\260").arg(Helper::valueToString(this->dataAnalyzer->data(channel)->delay, Helper::UNIT_SECONDS, 4)).arg(this->dataAnalyzer->data(channel)->phase, 0, 'f', 1));
+			else
+				this->measurementPhaseLabel[channel]->setText(QString());
 		}
 	}
 }
@@ -504,6 +552,8 @@ void DsoWidget::updateOffset(int channel, double value) {
 	else if(channel < this->settings->scope.voltage.count() * 2)
 		this->settings->scope.spectrum[channel - this->settings->scope.voltage.count()].offset = value;
 	
+	this->updateView();
+	
 	emit offsetChanged(channel, value);
 }
 
@@ -539,6 +589,9 @@ void DsoWidget::updateMarker(int marker, double value) {
 	this->settings->scope.horizontal.marker[marker] = value;
 	
 	this->updateMarkerDetails();
+	// The markers only change the zoom of the magnified scope
+	this->zoomScope->resetPhosphor();
+	this->scheduler->requestRedraw();
 	
 	emit markerChanged(marker, value);
 }
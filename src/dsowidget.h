@@ -37,6 +37,7 @@
 class DataAnalyzer;
 class DsoSettings;
 class QGridLayout;
+class RenderScheduler;
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -57,11 +58,13 @@ class DsoWidget : public QWidget {
 		void updateSpectrumDetails(unsigned int channel);
 		void updateTriggerDetails();
 		void updateVoltageDetails(unsigned int channel);
+		void updateView();
 		
 		QGridLayout *mainLayout; ///< The main layout for this widget
 		GlGenerator *generator; ///< The generator for the OpenGL vertex arrays
 		GlScope *mainScope; ///< The main scope screen
 		GlScope *zoomScope; ///< The optional magnified scope screen
+		RenderScheduler *scheduler; ///< Limits the frame rate of the scopes
 		LevelSlider *offsetSlider; ///< The sliders for the graph offsets
 		LevelSlider *triggerPositionSlider; ///< The slider for the pretrigger
 		LevelSlider *triggerLevelSlider; ///< The sliders for the trigger level
@@ -73,6 +76,7 @@ class DsoWidget : public QWidget {
 		QLabel *settingsRateLabel; ///< The samplerate
 		QLabel *settingsTimebaseLabel; ///< The timebase of the main scope
 		QLabel *settingsFrequencybaseLabel; ///< The frequencybase of the main scope
+		QLabel *settingsFramesLabel; ///< The shown and skipped frames per second
 		
 		QHBoxLayout *markerLayout; ///< The table for the marker details
 		QLabel *markerInfoLabel; ///< The info about the zoom factor
@@ -88,6 +92,7 @@ class DsoWidget : public QWidget {
 		QList<QLabel *> measurementMiscLabel; ///< Coupling or math mode
 		QList<QLabel *> measurementAmplitudeLabel; ///< Amplitude of the signal (V)
 		QList<QLabel *> measurementFrequencyLabel; ///< Frequency of the signal (Hz)
+		QList<QLabel *> measurementPhaseLabel; ///< Delay and phase relative to the first channel
 		
 		DsoSettings *settings; ///< The settings provided by the main window
 		
@@ -117,6 +122,7 @@ class DsoWidget : public QWidget {
 		
 		// Menus
 		void updateBufferSize(unsigned int size);
+		void updateFrames(unsigned int shown, unsigned int skipped);
 		
 		// Export
 		bool exportAs();
@@ -24,21 +24,21 @@
 
 #include <cmath>
 
-#include <QFile>
 #include <QImage>
 #include <QMutex>
 #include <QPainter>
-#include <QPixmap>
 #include <QPrintDialog>
 #include <QPrinter>
-#include <QTextStream>
 
 
 #include "exporter.h"
 
+#include "capturefile.h"
+#include "csvwriter.h"
 #include "dataanalyzer.h"
 #include "dso.h"
 #include "glgenerator.h"
+#include "graphrenderer.h"
 #include "helper.h"
 #include "settings.h"
 
@@ -46,9 +46,14 @@
 ////////////////////////////////////////////////////////////////////////////////
 // class HorizontalDock
 /// \brief Initializes the printer object.
-Exporter::Exporter(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget *parent) : QObject(parent) {
+/// \param settings The settings that should be used.
+/// \param dataAnalyzer The data analyzer with the measured values.
+/// \param generator The generator whose graphs are exported as image.
+/// \param parent The parent widget.
+Exporter::Exporter(DsoSettings *settings, DataAnalyzer *dataAnalyzer, GlGenerator *generator, QWidget *parent) : QObject(parent) {
 	this->settings = settings;
 	this->dataAnalyzer = dataAnalyzer;
+	this->generator = generator;
 	
 	this->format = EXPORT_FORMAT_PRINTER;
 }
@@ -65,10 +70,19 @@ void Exporter::setFilename(QString filename) {
 
 /// \brief Set the output format.
 void Exporter::setFormat(ExportFormat format) {
-	if(format >= EXPORT_FORMAT_PRINTER && format <= EXPORT_FORMAT_CSV)
+	if(format >= EXPORT_FORMAT_PRINTER && format <= EXPORT_FORMAT_CAPTURE)
 		this->format = format;
 }
 
+/// \brief Set the digital phosphor the scopes accumulated in textures.
+/// Without it only the newest graphs are exported if the generator doesn't keep the older ones.
+/// \param screen The phosphor of the scope, a null image if there is none.
+/// \param zoomed The phosphor of the zoomed scope, a null image if there is none.
+void Exporter::setPhosphor(const QImage &screen, const QImage &zoomed) {
+	this->phosphor[0] = screen;
+	this->phosphor[1] = zoomed;
+}
+
 /// \brief Print the document (May be a file too)
 bool Exporter::doExport() {
 	if(this->format < EXPORT_FORMAT_CSV) {
@@ -101,9 +115,9 @@ bool Exporter::doExport() {
 			}
 		}
 		else {
-			// We need a QPixmap for image-export
-			paintDevice = new QPixmap(this->settings->options.imageSize);
-			((QPixmap *) paintDevice)->fill(colorValues->background);
+			// We need a QImage for image-export, it doesn't need a display
+			paintDevice = new QImage(this->settings->options.imageSize, QImage::Format_ARGB32);
+			((QImage *) paintDevice)->fill(colorValues->background.rgba());
 		}
 		
 		// Create a painter for our device
@@ -176,8 +190,6 @@ bool Exporter::doExport() {
 		// Calculate variables needed for zoomed scope
 		double divs = fabs(this->settings->scope.horizontal.marker[1] - this->settings->scope.horizontal.marker[0]);
 		double time = divs * this->settings->scope.horizontal.timebase;
-		double zoomFactor = DIVS_TIME / divs;
-		double zoomOffset = (this->settings->scope.horizontal.marker[0] + this->settings->scope.horizontal.marker[1]) / 2;
 		
 		if(this->settings->view.zoom) {
 			scopeHeight = (double) (paintDevice->height() - (channelCount + 5) * lineHeight) / 2;
@@ -201,82 +213,15 @@ bool Exporter::doExport() {
 			painter.drawText(QRectF(lineHeight * 10 + stretchBase * 2, top, stretchBase * 2, lineHeight), Helper::valueToString(1.0 / time, Helper::UNIT_HERTZ, 4), QTextOption(Qt::AlignRight));
 		}
 		
-		// Set DIVS_TIME x DIVS_VOLTAGE matrix for oscillograph
-		painter.setMatrix(QMatrix((paintDevice->width() - 1) / DIVS_TIME, 0, 0, -(scopeHeight - 1) / DIVS_VOLTAGE, (double) (paintDevice->width() - 1) / 2, (scopeHeight - 1) / 2 + lineHeight * 1.5), false);
-		
-		// Draw the graphs
-		painter.setRenderHint(QPainter::Antialiasing);
-		painter.setBrush(Qt::NoBrush);
+		// Draw the graphs, they are reduced to the pixel columns of the device or the printer resolution for vector output
+		double columnWidth = 1;
+		if(this->format < EXPORT_FORMAT_IMAGE)
+			columnWidth = qMax(1.0, (double) ((QPrinter *) paintDevice)->resolution() / EXPORT_VECTOR_DPI);
 		
+		GraphRenderer renderer(this->settings, this->generator);
 		for(int zoomed = 0; zoomed < (this->settings->view.zoom ? 2 : 1); zoomed++) {
-			switch(this->settings->scope.horizontal.format) {
-				case Dso::GRAPHFORMAT_TY:
-					// Add graphs for channels
-					for(int channel = 0 ; channel < this->settings->scope.voltage.count(); channel++) {
-						if(this->settings->scope.voltage[channel].used) {
-							painter.setPen(colorValues->voltage[channel]);
-							
-							// What's the horizontal distance between sampling points?
-							double horizontalFactor = this->dataAnalyzer->data(channel)->samples.voltage.interval / this->settings->scope.horizontal.timebase;
-							// How many samples are visible?
-							double centerPosition, centerOffset;
-							if(zoomed) {
-								centerPosition = (zoomOffset + DIVS_TIME / 2) / horizontalFactor;
-								centerOffset = DIVS_TIME / horizontalFactor / zoomFactor / 2;
-							}
-							else {
-								centerPosition = DIVS_TIME / 2 / horizontalFactor;
-								centerOffset = DIVS_TIME / horizontalFactor / 2;
-							}
-							unsigned int firstPosition = qMax((int) (centerPosition - centerOffset), 0);
-							unsigned int lastPosition = qMin((int) (centerPosition + centerOffset), (int) this->dataAnalyzer->data(channel)->samples.voltage.count - 1);
-							
-							// Draw graph
-							QPointF *graph = new QPointF[lastPosition - firstPosition + 1];
-							for(unsigned int position = firstPosition; position <= lastPosition; position++)
-								graph[position - firstPosition] = QPointF(position * horizontalFactor - DIVS_TIME / 2, this->dataAnalyzer->data(channel)->samples.voltage.sample[position] / this->settings->scope.voltage[channel].gain + this->settings->scope.voltage[channel].offset);
-							painter.drawPolyline(graph, lastPosition - firstPosition + 1);
-						}
-					}
-				
-					// Add spectrum graphs
-					for (int channel = 0; channel < this->settings->scope.spectrum.count(); channel++) {
-						if(this->settings->scope.spectrum[channel].used) {
-							painter.setPen(colorValues->spectrum[channel]);
-							
-							// What's the horizontal distance between sampling points?
-							double horizontalFactor = this->dataAnalyzer->data(channel)->samples.spectrum.interval / this->settings->scope.horizontal.frequencybase;
-							// How many samples are visible?
-							double centerPosition, centerOffset;
-							if(zoomed) {
-								centerPosition = (zoomOffset + DIVS_TIME / 2) / horizontalFactor;
-								centerOffset = DIVS_TIME / horizontalFactor / zoomFactor / 2;
-							}
-							else {
-								centerPosition = DIVS_TIME / 2 / horizontalFactor;
-								centerOffset = DIVS_TIME / horizontalFactor / 2;
-							}
-							unsigned int firstPosition = qMax((int) (centerPosition - centerOffset), 0);
-							unsigned int lastPosition = qMin((int) (centerPosition + centerOffset), (int) this->dataAnalyzer->data(channel)->samples.spectrum.count - 1);
-							
-							// Draw graph
-							QPointF *graph = new QPointF[lastPosition - firstPosition + 1];
-							for(unsigned int position = firstPosition; position <= lastPosition; position++)
-								graph[position - firstPosition] = QPointF(position * horizontalFactor - DIVS_TIME / 2, this->dataAnalyzer->data(channel)->samples.spectrum.sample[position] / this->settings->scope.spectrum[channel].magnitude + this->settings->scope.spectrum[channel].offset);
-							painter.drawPolyline(graph, lastPosition - firstPosition + 1);
-						}
-					}
-					break;
-					
-				case Dso::GRAPHFORMAT_XY:
-					break;
-				
-				default:
-					break;
-			}
-			
-			// Set DIVS_TIME / zoomFactor x DIVS_VOLTAGE matrix for zoomed oscillograph
-			painter.setMatrix(QMatrix((paintDevice->width() - 1) / DIVS_TIME * zoomFactor, 0, 0, -(scopeHeight - 1) / DIVS_VOLTAGE, (double) (paintDevice->width() - 1) / 2 - zoomOffset * zoomFactor * (paintDevice->width() - 1) / DIVS_TIME, (scopeHeight - 1) * 1.5 + lineHeight * 4), false);
+			double scopeTop = zoomed ? scopeHeight - 1 + lineHeight * 4 : lineHeight * 1.5;
+			renderer.draw(&painter, QRectF(0, scopeTop, paintDevice->width() - 1, scopeHeight - 1), zoomed, colorValues, columnWidth, this->phosphor[zoomed]);
 		}
 		
 		this->dataAnalyzer->mutex()->unlock();
@@ -354,45 +299,22 @@ bool Exporter::doExport() {
 		painter.end();
 		
 		if(this->format == EXPORT_FORMAT_IMAGE)
-			((QPixmap *) paintDevice)->save(this->filename);
+			((QImage *) paintDevice)->save(this->filename);
 		
 		return true;
 	}
-	else {
-		QFile csvFile(this->filename);
-		if(!csvFile.open(QIODevice::WriteOnly | QIODevice::Text))
+	else if(this->format == EXPORT_FORMAT_CSV) {
+		CsvWriter csvWriter(this->settings, this->dataAnalyzer);
+		if(!csvWriter.open(this->filename))
 			return false;
 		
-		QTextStream csvStream(&csvFile);
+		bool written = csvWriter.writeFrame();
+		if(!csvWriter.close())
+			written = false;
 		
-		for(int channel = 0 ; channel < this->settings->scope.voltage.count(); channel++) {
-			if(this->settings->scope.voltage[channel].used) {
-				// Start with channel name and the sample interval
-				csvStream << "\"" << this->settings->scope.voltage[channel].name << "\"," << this->dataAnalyzer->data(channel)->samples.voltage.interval;
-				
-				// And now all sample values in volts
-				for(unsigned int position = 0; position < this->dataAnalyzer->data(channel)->samples.voltage.count; position++)
-					csvStream << "," << this->dataAnalyzer->data(channel)->samples.voltage.sample[position];
-				
-				// Finally a newline
-				csvStream << '\n';
-			}
-			
-			if(this->settings->scope.spectrum[channel].used) {
-				// Start with channel name and the sample interval
-				csvStream << "\"" << this->settings->scope.spectrum[channel].name << "\"," << this->dataAnalyzer->data(channel)->samples.spectrum.interval;
-				
-				// And now all magnitudes in dB
-				for(unsigned int position = 0; position < this->dataAnalyzer->data(channel)->samples.spectrum.count; position++)
-					csvStream << "," << this->dataAnalyzer->data(channel)->samples.spectrum.sample[position];
-				
-				// Finally a newline
-				csvStream << '\n';
-			}
-		}
-		
-		csvFile.close();
-		
-		return true;
+		return written;
+	}
+	else {
+		return CaptureFile::write(this->filename, this->settings, this->dataAnalyzer);
 	}
 }
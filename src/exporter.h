@@ -27,12 +27,17 @@
 #define EXPORTER_H
 
 
+#include <QImage>
 #include <QObject>
 #include <QSize>
 
 
+#define EXPORT_VECTOR_DPI           300 ///< Resolution the graphs of printouts and vector exports are reduced to
+
+
 class DsoSettings;
 class DataAnalyzer;
+class GlGenerator;
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -42,7 +47,8 @@ enum ExportFormat {
 	EXPORT_FORMAT_PRINTER,
 	EXPORT_FORMAT_PDF, EXPORT_FORMAT_PS,
 	EXPORT_FORMAT_IMAGE,
-	EXPORT_FORMAT_CSV
+	EXPORT_FORMAT_CSV,
+	EXPORT_FORMAT_CAPTURE
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -52,21 +58,25 @@ class Exporter : public QObject {
 	Q_OBJECT
 	
 	public:
-		Exporter(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QWidget *parent = 0);
+		Exporter(DsoSettings *settings, DataAnalyzer *dataAnalyzer, GlGenerator *generator, QWidget *parent = 0);
 		~Exporter();
 		
 		void setFilename(QString filename);
 		void setFormat(ExportFormat format);
+		void setPhosphor(const QImage &screen, const QImage &zoomed);
 		
 		bool doExport();
 	
 	private:
 		DataAnalyzer *dataAnalyzer;
 		DsoSettings *settings;
+		GlGenerator *generator;
 		
 		QString filename;
 		ExportFormat format;
 		QSize size;
+		QImage phosphor[2]; ///< The digital phosphor of the scope and the zoomed scope
+
 };
 
 
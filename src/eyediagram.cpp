@@ -0,0 +1,325 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  eyediagram.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+#include <cstring>
+
+#include <QFuture>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrentRun>
+
+
+#include "eyediagram.h"
+
+#include "dataanalyzer.h"
+#include "dso.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct EyeSlice                                              eyediagram.cpp
+/// \brief A block of samples that is folded into one histogram by one thread.
+struct EyeSlice {
+	const double *sample; ///< The first sample of the block
+	unsigned int count; ///< Number of samples in the block
+	double binPosition; ///< Horizontal bin of the first sample
+	double binStep; ///< Horizontal bins between two samples
+	double voltageFactor; ///< Vertical bins per volt
+	double voltageOffset; ///< Vertical bin of 0 V
+	unsigned int *histogram; ///< The histogram the block is folded into
+};
+
+/// \brief Folds the samples of a block into its histogram.
+/// The horizontal position is advanced incrementally, so there is no division
+/// inside the loop and the histogram rows stay hot in the cache.
+/// \param slice The block that should be accumulated.
+static void accumulateSlice(EyeSlice *slice) {
+	double binPosition = slice->binPosition;
+	
+	for(unsigned int position = 0; position < slice->count; position++) {
+		double voltageBin = slice->sample[position] * slice->voltageFactor + slice->voltageOffset;
+		if(voltageBin >= 0 && voltageBin < EYE_VOLTAGE_BINS)
+			slice->histogram[(unsigned int) voltageBin * EYE_TIME_BINS + (unsigned int) binPosition]++;
+		
+		binPosition += slice->binStep;
+		if(binPosition >= EYE_TIME_BINS)
+			binPosition -= EYE_TIME_BINS;
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class EyeDiagram
+/// \brief Allocates the histogram.
+EyeDiagram::EyeDiagram() {
+	this->histogram = new unsigned int[EYE_TIME_BINS * EYE_VOLTAGE_BINS];
+	
+	this->gain = 0;
+	this->offset = 0;
+	this->interval = 0;
+	this->configuredPeriod = 0;
+	this->period = 0;
+	
+	this->clear();
+}
+
+/// \brief Deallocates the histograms.
+EyeDiagram::~EyeDiagram() {
+	delete[] this->histogram;
+	for(int index = 0; index < this->partialHistograms.count(); index++)
+		delete[] this->partialHistograms[index];
+}
+
+/// \brief Folds a frame into the histogram.
+/// The histogram is cleared automatically if the gain, offset, samplerate or
+/// configured symbol period differ from the previously accumulated frames.
+/// \param samples The voltage samples of the frame.
+/// \param period The symbol period in seconds, 0 to recover it from the frame.
+/// \param gain The gain of the channel in V/div.
+/// \param offset The offset of the channel in divs.
+void EyeDiagram::accumulate(const SampleValues *samples, double period, double gain, double offset) {
+	if(!samples->sample || !samples->count || samples->interval <= 0 || gain <= 0)
+		return;
+	
+	if(gain != this->gain || offset != this->offset || samples->interval != this->interval || period != this->configuredPeriod) {
+		this->clear();
+		this->gain = gain;
+		this->offset = offset;
+		this->interval = samples->interval;
+		this->configuredPeriod = period;
+	}
+	
+	// Get the symbol period and the position of the transitions
+	double phase;
+	double symbolPeriod = EyeDiagram::recoverPeriod(samples, period, &phase);
+	if(symbolPeriod <= 0)
+		return;
+	this->period = symbolPeriod;
+	
+	// The transitions are placed half a symbol into the screen
+	double slicePeriod = symbolPeriod * EYE_SYMBOLS;
+	double sliceStart = phase - symbolPeriod / 2;
+	double binStep = fmod(samples->interval / slicePeriod * EYE_TIME_BINS, EYE_TIME_BINS);
+	double voltageFactor = EYE_VOLTAGE_BINS / DIVS_VOLTAGE / gain;
+	double voltageOffset = (offset + DIVS_VOLTAGE / 2) * EYE_VOLTAGE_BINS / DIVS_VOLTAGE;
+	
+	// Split large frames into blocks that are folded by separate threads
+	unsigned int threadCount = samples->count / EYE_PARALLEL_SAMPLES;
+	if(threadCount > (unsigned int) QThread::idealThreadCount())
+		threadCount = QThread::idealThreadCount();
+	if(threadCount < 1)
+		threadCount = 1;
+	
+	for(int index = this->partialHistograms.count(); index < (int) threadCount - 1; index++)
+		this->partialHistograms.append(new unsigned int[EYE_TIME_BINS * EYE_VOLTAGE_BINS]);
+	
+	QVector<EyeSlice> slices(threadCount);
+	unsigned int blockSize = samples->count / threadCount;
+	for(unsigned int thread = 0; thread < threadCount; thread++) {
+		unsigned int blockStart = thread * blockSize;
+		
+		slices[thread].sample = samples->sample + blockStart;
+		slices[thread].count = (thread == threadCount - 1) ? samples->count - blockStart : blockSize;
+		double sliceTime = (blockStart * samples->interval - sliceStart) / slicePeriod;
+		slices[thread].binPosition = (sliceTime - floor(sliceTime)) * EYE_TIME_BINS;
+		if(slices[thread].binPosition >= EYE_TIME_BINS)
+			slices[thread].binPosition = 0;
+		slices[thread].binStep = binStep;
+		slices[thread].voltageFactor = voltageFactor;
+		slices[thread].voltageOffset = voltageOffset;
+		
+		// The first block is folded directly into the main histogram
+		if(thread == 0)
+			slices[thread].histogram = this->histogram;
+		else {
+			slices[thread].histogram = this->partialHistograms[thread - 1];
+			memset(slices[thread].histogram, 0, sizeof(unsigned int) * EYE_TIME_BINS * EYE_VOLTAGE_BINS);
+		}
+	}
+	
+	if(threadCount == 1)
+		accumulateSlice(&slices[0]);
+	else {
+		QList<QFuture<void> > futures;
+		for(unsigned int thread = 1; thread < threadCount; thread++)
+			futures.append(QtConcurrent::run(accumulateSlice, &slices[thread]));
+		accumulateSlice(&slices[0]);
+		for(int index = 0; index < futures.count(); index++)
+			futures[index].waitForFinished();
+		
+		// Reduce the partial histograms into the main histogram
+		for(unsigned int thread = 1; thread < threadCount; thread++) {
+			const unsigned int *partialHistogram = this->partialHistograms[thread - 1];
+			for(unsigned int bin = 0; bin < EYE_TIME_BINS * EYE_VOLTAGE_BINS; bin++)
+				this->histogram[bin] += partialHistogram[bin];
+		}
+	}
+	
+	this->maximum = 0;
+	for(unsigned int bin = 0; bin < EYE_TIME_BINS * EYE_VOLTAGE_BINS; bin++) {
+		if(this->histogram[bin] > this->maximum)
+			this->maximum = this->histogram[bin];
+	}
+	this->frames++;
+}
+
+/// \brief Resets the histogram.
+void EyeDiagram::clear() {
+	memset(this->histogram, 0, sizeof(unsigned int) * EYE_TIME_BINS * EYE_VOLTAGE_BINS);
+	this->maximum = 0;
+	this->frames = 0;
+}
+
+/// \brief Returns the histogram.
+/// \return The hit counts, #EYE_VOLTAGE_BINS rows with #EYE_TIME_BINS values.
+const unsigned int *EyeDiagram::data() const {
+	return this->histogram;
+}
+
+/// \brief Returns the highest hit count.
+/// \return The highest value in the histogram.
+unsigned int EyeDiagram::getMaximum() const {
+	return this->maximum;
+}
+
+/// \brief Returns the number of accumulated frames.
+/// \return Frames folded into the histogram since the last reset.
+unsigned long int EyeDiagram::getFrames() const {
+	return this->frames;
+}
+
+/// \brief Returns the symbol period of the last frame.
+/// \return The symbol period in seconds, 0 if there was none.
+double EyeDiagram::getPeriod() const {
+	return this->period;
+}
+
+/// \brief Converts the histogram into logarithmic intensities.
+/// \param buffer Array of #EYE_TIME_BINS * #EYE_VOLTAGE_BINS intensities.
+void EyeDiagram::toIntensity(unsigned char *buffer) const {
+	if(!this->maximum) {
+		memset(buffer, 0, EYE_TIME_BINS * EYE_VOLTAGE_BINS);
+		return;
+	}
+	
+	double factor = 255.0 / log(1.0 + this->maximum);
+	for(unsigned int bin = 0; bin < EYE_TIME_BINS * EYE_VOLTAGE_BINS; bin++)
+		buffer[bin] = (unsigned char) (log(1.0 + this->histogram[bin]) * factor + 0.5);
+}
+
+/// \brief Recovers the symbol period and phase from the transitions.
+/// The signal is compared against its mid-level with a hysteresis of 10 % of
+/// the amplitude, the crossings are interpolated linearly. The shortest
+/// distance between two crossings is used as first guess and refined by
+/// averaging over all distances.
+/// \param samples The voltage samples of the frame.
+/// \param period The symbol period in seconds, 0 if it should be recovered.
+/// \param phase Set to the time of the transitions within a symbol in seconds.
+/// \return The symbol period in seconds, 0 if there were too few transitions.
+double EyeDiagram::recoverPeriod(const SampleValues *samples, double period, double *phase) {
+	*phase = 0;
+	if(samples->count < 2)
+		return 0;
+	
+	// Get the threshold level
+	double minimalVoltage, maximalVoltage;
+	minimalVoltage = maximalVoltage = samples->sample[0];
+	for(unsigned int position = 1; position < samples->count; position++) {
+		if(samples->sample[position] < minimalVoltage)
+			minimalVoltage = samples->sample[position];
+		else if(samples->sample[position] > maximalVoltage)
+			maximalVoltage = samples->sample[position];
+	}
+	if(maximalVoltage <= minimalVoltage)
+		return 0;
+	double threshold = (maximalVoltage + minimalVoltage) / 2;
+	double hysteresis = (maximalVoltage - minimalVoltage) * 0.05;
+	
+	// Find the transitions, the positions are in samples
+	QVector<double> crossings;
+	bool high = samples->sample[0] > threshold;
+	double crossing = 0;
+	for(unsigned int position = 1; position < samples->count; position++) {
+		double previous = samples->sample[position - 1];
+		double current = samples->sample[position];
+		if((previous > threshold) != (current > threshold))
+			crossing = position - 1 + (previous - threshold) / (previous - current);
+		
+		if(!high && current > threshold + hysteresis) {
+			high = true;
+			crossings.append(crossing);
+		}
+		else if(high && current < threshold - hysteresis) {
+			high = false;
+			crossings.append(crossing);
+		}
+	}
+	
+	double symbolSamples;
+	if(period > 0)
+		symbolSamples = period / samples->interval;
+	else {
+		if(crossings.count() < 3)
+			return 0;
+		
+		// Shortest distance between two transitions as first guess
+		symbolSamples = crossings[1] - crossings[0];
+		for(int index = 2; index < crossings.count(); index++) {
+			if(crossings[index] - crossings[index - 1] < symbolSamples)
+				symbolSamples = crossings[index] - crossings[index - 1];
+		}
+		if(symbolSamples <= 0)
+			return 0;
+		
+		// Average over all distances weighted by their symbol count
+		double distanceSum = 0;
+		double symbolSum = 0;
+		for(int index = 1; index < crossings.count(); index++) {
+			double distance = crossings[index] - crossings[index - 1];
+			double symbols = floor(distance / symbolSamples + 0.5);
+			if(symbols >= 1) {
+				distanceSum += distance;
+				symbolSum += symbols;
+			}
+		}
+		if(symbolSum > 0)
+			symbolSamples = distanceSum / symbolSum;
+	}
+	
+	// Get the phase as circular mean of the transition positions
+	if(!crossings.isEmpty()) {
+		double sumCos = 0, sumSin = 0;
+		for(int index = 0; index < crossings.count(); index++) {
+			double angle = 2.0 * M_PI * crossings[index] / symbolSamples;
+			sumCos += cos(angle);
+			sumSin += sin(angle);
+		}
+		double phaseSamples = atan2(sumSin, sumCos) / (2.0 * M_PI) * symbolSamples;
+		if(phaseSamples < 0)
+			phaseSamples += symbolSamples;
+		*phase = phaseSamples * samples->interval;
+	}
+	
+	return symbolSamples * samples->interval;
+}
@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file eyediagram.h
+/// \brief Declares the EyeDiagram class.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef EYEDIAGRAM_H
+#define EYEDIAGRAM_H
+
+
+#include <QList>
+
+
+#define EYE_TIME_BINS               256 ///< Horizontal resolution of the histogram
+#define EYE_VOLTAGE_BINS            256 ///< Vertical resolution of the histogram
+#define EYE_SYMBOLS                   2 ///< Symbol periods shown on the screen
+#define EYE_PARALLEL_SAMPLES      65536 ///< Minimum samples per worker thread
+
+
+struct SampleValues;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class EyeDiagram                                               eyediagram.h
+/// \brief Accumulates frames into a time x voltage hit-count histogram.
+/// Every frame is sliced into windows of #EYE_SYMBOLS symbol periods, the
+/// samples of all slices are folded into one histogram. The histogram is stored
+/// row by row with one row per voltage bin, so it can be used as image directly.
+class EyeDiagram {
+	public:
+		EyeDiagram();
+		~EyeDiagram();
+		
+		void accumulate(const SampleValues *samples, double period, double gain, double offset);
+		void clear();
+		
+		const unsigned int *data() const;
+		unsigned int getMaximum() const;
+		unsigned long int getFrames() const;
+		double getPeriod() const;
+		void toIntensity(unsigned char *buffer) const;
+		
+		static double recoverPeriod(const SampleValues *samples, double period, double *phase);
+	
+	protected:
+		unsigned int *histogram; ///< The hit counts, #EYE_TIME_BINS per row
+		QList<unsigned int *> partialHistograms; ///< Private histograms for the worker threads
+		unsigned int maximum; ///< The highest hit count in the histogram
+		unsigned long int frames; ///< Number of accumulated frames
+		
+		double gain; ///< The gain used for the accumulated frames
+		double offset; ///< The offset used for the accumulated frames
+		double interval; ///< The sample interval of the accumulated frames
+		double configuredPeriod; ///< The requested symbol period, 0 if recovered
+		double period; ///< The symbol period of the last frame
+};
+
+
+#endif
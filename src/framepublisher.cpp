@@ -0,0 +1,290 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  framepublisher.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef OS_WINDOWS
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <QFile>
+#include <QMutex>
+
+
+#include "framepublisher.h"
+
+#include "capturefile.h"
+#include "framering.h"
+#include "settings.h"
+
+
+// The C description of the ring has to match the capture records
+typedef char FrameRingHeaderSize[sizeof(FrameRingHeader) == FRAMERING_ALIGNMENT ? 1 : -1];
+typedef char FrameRingSlotSize[sizeof(FrameRingSlot) == FRAMERING_ALIGNMENT ? 1 : -1];
+typedef char FrameRingRecordSize[sizeof(FrameRingRecord) == sizeof(CaptureHeader) ? 1 : -1];
+typedef char FrameRingChannelSize[sizeof(FrameRingChannel) == sizeof(CaptureChannel) ? 1 : -1];
+
+
+/// \brief Orders the memory accesses for the readers in other processes.
+static inline void memoryBarrier() {
+	__sync_synchronize();
+}
+
+#ifndef OS_WINDOWS
+/// \brief Checks if an existing ring was left behind by a stopped writer.
+/// Objects without a complete header may still be initialized by their writer
+/// and are treated as in use.
+/// \param path The encoded name of the shared memory object.
+/// \return true if the object can be removed.
+static bool isStale(const char *path) {
+	int descriptor = shm_open(path, O_RDONLY, 0);
+	if(descriptor < 0)
+		return errno == ENOENT;
+	
+	bool stale = false;
+	struct stat status;
+	if(fstat(descriptor, &status) == 0 && (size_t) status.st_size >= sizeof(FrameRingHeader)) {
+		void *address = mmap(0, sizeof(FrameRingHeader), PROT_READ, MAP_SHARED, descriptor, 0);
+		if(address != MAP_FAILED) {
+			const FrameRingHeader *header = (const FrameRingHeader *) address;
+			if(!memcmp(header->magic, FRAMERING_MAGIC, sizeof(header->magic))) {
+				memoryBarrier();
+				stale = header->closed || (header->owner && kill((pid_t) header->owner, 0) < 0 && errno == ESRCH);
+			}
+			munmap(address, sizeof(FrameRingHeader));
+		}
+	}
+	::close(descriptor);
+	
+	return stale;
+}
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class FramePublisher
+/// \brief Initializes the publisher, the ring is created by open().
+/// \param settings The settings of the published frames.
+/// \param dataAnalyzer The analyzer providing the frames.
+/// \param parent The parent object.
+FramePublisher::FramePublisher(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QObject *parent) : QObject(parent) {
+	this->settings = settings;
+	this->dataAnalyzer = dataAnalyzer;
+	
+	this->mutex = new QMutex();
+	this->map = 0;
+	this->mapSize = 0;
+	this->header = 0;
+	this->device = 0;
+	this->inode = 0;
+	
+	this->record = new CaptureRecord();
+	this->sequence = 0;
+	this->reported = false;
+}
+
+/// \brief Removes the ring.
+FramePublisher::~FramePublisher() {
+	this->close();
+	
+	delete this->record;
+	delete this->mutex;
+}
+
+/// \brief Creates the shared memory object and maps it, closes the old ring first.
+/// \param name The name of the shared memory object, starting with a slash.
+/// \param slotCount The number of slots in the ring.
+/// \param slotSize The size of each slot in bytes, rounded up to the alignment.
+/// \return true if the ring was created.
+bool FramePublisher::open(const QString &name, unsigned int slotCount, quint64 slotSize) {
+	this->close();
+
+#ifdef OS_WINDOWS
+	Q_UNUSED(slotCount);
+	Q_UNUSED(slotSize);
+	emit statusMessage(tr("Shared memory %1 isn't supported on this system").arg(name), 0);
+	return false;
+#else
+	if(!slotCount) {
+		emit statusMessage(tr("The shared memory %1 needs at least one slot").arg(name), 0);
+		return false;
+	}
+	if(slotSize <= sizeof(FrameRingSlot)) {
+		emit statusMessage(tr("The slots of the shared memory %1 are too small: %2 bytes").arg(name).arg(slotSize), 0);
+		return false;
+	}
+	
+	// Keep the slots and the values in them aligned
+	slotSize = (slotSize + FRAMERING_ALIGNMENT - 1) / FRAMERING_ALIGNMENT * FRAMERING_ALIGNMENT;
+	quint64 size = sizeof(FrameRingHeader) + slotCount * slotSize;
+	QByteArray path = QFile::encodeName(name);
+	
+	// Another running instance keeps its ring, a crashed one leaves it behind
+	int descriptor = shm_open(path.constData(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	if(descriptor < 0 && errno == EEXIST) {
+		if(!isStale(path.constData())) {
+			emit statusMessage(tr("The shared memory %1 is already in use").arg(name), 0);
+			return false;
+		}
+		shm_unlink(path.constData());
+		descriptor = shm_open(path.constData(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	}
+	if(descriptor < 0) {
+		emit statusMessage(tr("Can't create the shared memory %1: %2").arg(name, strerror(errno)), 0);
+		return false;
+	}
+	struct stat status;
+	fstat(descriptor, &status);
+	
+	uchar *map = 0;
+	if(ftruncate(descriptor, size) == 0) {
+		void *address = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+		if(address != MAP_FAILED)
+			map = (uchar *) address;
+	}
+	if(!map)
+		emit statusMessage(tr("Can't map the shared memory %1: %2").arg(name, strerror(errno)), 0);
+	// The mapping stays valid without the descriptor
+	::close(descriptor);
+	if(!map) {
+		shm_unlink(path.constData());
+		return false;
+	}
+	
+	// The object is filled with zeros, so all slots are empty. The magic is
+	// written last, readers that attach early wait for it.
+	FrameRingHeader *header = (FrameRingHeader *) map;
+	header->version = FRAMERING_VERSION;
+	header->headerSize = sizeof(FrameRingHeader);
+	header->slotCount = slotCount;
+	header->slotSize = slotSize;
+	header->owner = getpid();
+	memoryBarrier();
+	memcpy(header->magic, FRAMERING_MAGIC, sizeof(header->magic));
+	
+	this->mutex->lock();
+	this->name = name;
+	this->map = map;
+	this->mapSize = size;
+	this->header = header;
+	this->device = status.st_dev;
+	this->inode = status.st_ino;
+	this->sequence = 0;
+	this->reported = false;
+	this->mutex->unlock();
+	
+	return true;
+#endif
+}
+
+/// \brief Removes the ring and marks it as closed.
+/// Readers that have the ring mapped can still use it until they unmap it. The
+/// name is only removed if it still belongs to the ring of this instance.
+void FramePublisher::close() {
+	this->mutex->lock();
+
+#ifndef OS_WINDOWS
+	if(this->map) {
+		QByteArray path = QFile::encodeName(this->name);
+		int descriptor = shm_open(path.constData(), O_RDONLY, 0);
+		if(descriptor >= 0) {
+			struct stat status;
+			if(fstat(descriptor, &status) == 0 && (quint64) status.st_dev == this->device && (quint64) status.st_ino == this->inode)
+				shm_unlink(path.constData());
+			::close(descriptor);
+		}
+		
+		memoryBarrier();
+		this->header->closed = 1;
+		munmap(this->map, this->mapSize);
+	}
+#endif
+	this->map = 0;
+	this->mapSize = 0;
+	this->header = 0;
+	
+	this->mutex->unlock();
+}
+
+/// \brief Checks if the ring is available to readers.
+/// \return true if the ring has been created.
+bool FramePublisher::isOpen() const {
+	return this->map != 0;
+}
+
+/// \brief Creates, recreates or removes the ring after the options have changed.
+void FramePublisher::applySettings() {
+	const DsoSettingsOptionsRing &options = this->settings->options.ring;
+	if(!options.enabled) {
+		this->close();
+		return;
+	}
+	
+	// Keep the readers attached if nothing changed
+	quint64 slotSize = (quint64) options.slotSize << 20;
+	if(this->isOpen() && this->name == options.name && this->header->slotCount == options.slotCount && this->header->slotSize == slotSize)
+		return;
+	
+	this->open(options.name, options.slotCount, slotSize);
+}
+
+/// \brief Copies the analyzed frame into the next slot.
+/// Has to be connected directly to DataAnalyzer::analyzed(), it's called from
+/// the analyzer thread while the analyzed data is locked.
+void FramePublisher::publish() {
+	this->mutex->lock();
+	
+	if(this->map) {
+		CaptureFile::collect(this->settings, this->dataAnalyzer, this->record, false);
+		
+		if(sizeof(FrameRingSlot) + this->record->header.recordSize > this->header->slotSize) {
+			this->header->dropped++;
+			if(!this->reported) {
+				emit statusMessage(tr("The frames don't fit into the shared memory slots"), 0);
+				this->reported = true;
+			}
+		}
+		else {
+			this->sequence++;
+			FrameRingSlot *slot = (FrameRingSlot *) (this->map + this->header->headerSize + (this->sequence % this->header->slotCount) * this->header->slotSize);
+			
+			// Readers that still use the slot notice that it's overwritten
+			slot->sequence = 0;
+			memoryBarrier();
+			CaptureFile::writeRecord((uchar *) slot + sizeof(FrameRingSlot), this->record);
+			slot->size = this->record->header.recordSize;
+			memoryBarrier();
+			slot->sequence = this->sequence;
+			memoryBarrier();
+			this->header->sequence = this->sequence;
+		}
+	}
+	
+	this->mutex->unlock();
+}
@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file framepublisher.h
+/// \brief Declares the FramePublisher class.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef FRAMEPUBLISHER_H
+#define FRAMEPUBLISHER_H
+
+
+#include <QObject>
+#include <QString>
+#include <QtGlobal>
+
+
+class QMutex;
+
+struct CaptureRecord;
+class DataAnalyzer;
+class DsoSettings;
+struct FrameRingHeader;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class FramePublisher                                       framepublisher.h
+/// \brief Publishes the analyzed frames in a POSIX shared memory ring.
+/// Every frame is copied once into the next slot of the ring described in
+/// framering.h. Readers in other processes map the ring and use the values in
+/// place, the writer never waits for them.
+class FramePublisher : public QObject {
+	Q_OBJECT
+	
+	public:
+		FramePublisher(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QObject *parent = 0);
+		~FramePublisher();
+		
+		bool open(const QString &name, unsigned int slotCount, quint64 slotSize);
+		void close();
+		bool isOpen() const;
+	
+	protected:
+		void closeRing();
+		
+		DsoSettings *settings; ///< The settings of the published frames
+		DataAnalyzer *dataAnalyzer; ///< The analyzer providing the frames
+		
+		QMutex *mutex; ///< Protects the mapping, frames are published by the analyzer thread
+		QString name; ///< The name of the shared memory object
+		quint64 device; ///< Device of the created object, identifies it together with #inode
+		quint64 inode; ///< Inode of the created object, the name may have been reused
+		uchar *map; ///< The mapped shared memory object, 0 if there is none
+		quint64 mapSize; ///< The size of the mapping in bytes
+		FrameRingHeader *header; ///< The header at the start of the mapping
+		
+		CaptureRecord *record; ///< The frame that is copied into the ring
+		quint64 sequence; ///< The number of the last published frame
+		bool reported; ///< true if the too small slots have been reported
+	
+	public slots:
+		void applySettings();
+		void publish();
+	
+	signals:
+		void statusMessage(const QString &message, int timeout); ///< Reports errors
+};
+
+
+#endif
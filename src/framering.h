@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file framering.h
+/// \brief Describes the shared memory frame ring for other programs.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+
+// This header is plain C, so readers in other programs can include it
+#include <stdint.h>
+
+
+#define FRAMERING_MAGIC         "OHFRRING" ///< Identifies the ring, without the terminating null
+#define FRAMERING_VERSION                1 ///< Version of the ring layout written by this program
+#define FRAMERING_NAME       "/openhantek" ///< Default name of the shared memory object
+#define FRAMERING_ALIGNMENT             64 ///< Size of the headers, alignment of the slots and values
+#define FRAMERING_NAME_LENGTH           32 ///< Size of the name fields including the terminating null
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct FrameRingHeader                                          framering.h
+/// \brief The header at the start of the shared memory object.
+/// The header is followed by slotCount slots of slotSize bytes each, frame
+/// number n is written into slot n % slotCount. All fields are in the byte
+/// order of the host. A reader waits until sequence changes, checks that the
+/// sequence of the slot matches the frame number, uses the values in place and
+/// checks the sequence of the slot again. If it changed, the writer has reused
+/// the slot in the meantime and the results have to be discarded. The sequence
+/// fields have to be read with atomic 64 bit loads followed by a memory
+/// barrier.
+typedef struct FrameRingHeader {
+	char magic[8]; ///< Always #FRAMERING_MAGIC
+	uint32_t version; ///< The #FRAMERING_VERSION of the writer
+	uint32_t headerSize; ///< Size of the header in bytes, the first slot starts there
+	uint32_t slotCount; ///< Number of slots in the ring
+	uint32_t closed; ///< 1 after the writer has stopped, the object is already unlinked
+	uint64_t slotSize; ///< Size of a slot including its header in bytes
+	volatile uint64_t sequence; ///< Number of the newest complete frame, 0 if there is none yet
+	volatile uint64_t dropped; ///< Number of frames that were too large for the slots
+	uint64_t owner; ///< Process id of the writer, rings of crashed writers are replaced
+	uint64_t reserved; ///< Always 0
+} FrameRingHeader;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct FrameRingSlot                                            framering.h
+/// \brief The header of a slot, followed by a #FrameRingRecord.
+typedef struct FrameRingSlot {
+	volatile uint64_t sequence; ///< Number of the frame in the slot, 0 while it's written
+	uint64_t size; ///< Size of the record in bytes
+	uint64_t reserved[6]; ///< Always 0
+} FrameRingSlot;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct FrameRingRecord                                          framering.h
+/// \brief The header of a frame, same as a record of a capture file.
+/// The header is followed by channelCount #FrameRingChannel entries.
+typedef struct FrameRingRecord {
+	char magic[8]; ///< Always "OHCAPTUR"
+	uint32_t version; ///< The capture file version of the writer
+	uint32_t byteOrder; ///< Always 0x01020304
+	uint32_t headerSize; ///< Size of the header in bytes, the channel table starts there
+	uint32_t channelSize; ///< Size of one channel table entry in bytes
+	uint32_t channelCount; ///< Number of entries in the channel table
+	uint32_t reserved; ///< Always 0
+	int64_t timestamp; ///< Time of the frame in ms since 1970-01-01 00:00 UTC
+	uint64_t recordSize; ///< Size of the record in bytes
+	double samplerate; ///< The samplerate in S/s
+	double triggerTime; ///< Time of the trigger point in s after the first sample
+	char model[FRAMERING_NAME_LENGTH]; ///< Name of the oscilloscope model
+} FrameRingRecord;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct FrameRingChannel                                         framering.h
+/// \brief An entry of the channel table describing one value array.
+/// The values in the ring are always 64 bit floating point numbers.
+typedef struct FrameRingChannel {
+	char name[FRAMERING_NAME_LENGTH]; ///< Name of the channel
+	uint32_t mode; ///< 0 for voltage values, 1 for spectrum values
+	uint32_t format; ///< Always 0 for 64 bit floating point values
+	uint32_t index; ///< Number of the channel, the math channel follows the physical ones
+	uint32_t reserved; ///< Always 0
+	uint64_t dataOffset; ///< Position of the values in bytes from the record start
+	uint64_t dataSize; ///< Size of the values in bytes
+	uint64_t count; ///< Number of values
+	double interval; ///< Time or frequency between two values
+	double gain; ///< The vertical resolution in V/div or dB/div
+	double offset; ///< The vertical offset in divs
+	double scale; ///< Always 1
+	double zero; ///< Always 0
+	double amplitude; ///< The measured amplitude in V, 0 for spectrum channels
+	double frequency; ///< The measured frequency in Hz, 0 for spectrum channels
+	double minimum; ///< The smallest value
+	double maximum; ///< The largest value
+} FrameRingChannel;
+
+
+#endif
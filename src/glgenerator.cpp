@@ -22,6 +22,11 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 
+#include <cmath>
+#include <cstring>
+
+#include <QGLBuffer>
+#include <QGLShaderProgram>
 #include <QGLWidget>
 #include <QMutex>
 
@@ -29,6 +34,7 @@
 #include "glgenerator.h"
 
 #include "dataanalyzer.h"
+#include "eyediagram.h"
 #include "settings.h"
 
 
@@ -38,12 +44,23 @@
 GlArray::GlArray() {
 	this->data = 0;
 	this->size = 0;
+	this->components = 2;
+	this->interval = 0;
+	this->spanFirst = 0;
+	this->spanCount = 0;
+	this->buffer = 0;
+	this->context = 0;
+	this->uploaded = false;
+	this->bound = false;
 }
 
 /// \brief Deletes the array.
 GlArray::~GlArray() {
 	if(this->data)
-		delete this->data;
+		delete[] this->data;
+	// The buffer makes its context current for the deletion itself
+	if(this->buffer)
+		delete this->buffer;
 }
 
 /// \brief Get the size of the array.
@@ -52,10 +69,24 @@ unsigned long int GlArray::getSize() {
 	return this->size;
 }
 
+/// \brief Get the number of vertices in the array.
+/// \return Number of array elements divided by the components per vertex.
+unsigned long int GlArray::getVertexCount() {
+	return this->size / this->components;
+}
+
+/// \brief Get the number of values per vertex.
+/// \return 2 for x/y pairs, 1 for compact arrays that only contain the samples.
+unsigned int GlArray::getComponents() {
+	return this->components;
+}
+
 /// \brief Set the size of the array.
 /// Previous array contents are lost.
 /// \param size New number of array elements.
-void GlArray::setSize(unsigned long int size) {
+/// \param components Number of values per vertex.
+void GlArray::setSize(unsigned long int size, unsigned int components) {
+	this->components = components;
 	if(this->size == size)
 		return;
 	
@@ -67,6 +98,84 @@ void GlArray::setSize(unsigned long int size) {
 		this->data = 0;
 	
 	this->size = size;
+	this->uploaded = false;
+}
+
+/// \brief Exchange the values with another array.
+/// The vertex buffer objects stay with their arrays, both arrays are uploaded
+/// again when they are drawn the next time.
+/// \param other The array whose values should be exchanged.
+void GlArray::swapData(GlArray *other) {
+	qSwap(this->data, other->data);
+	qSwap(this->size, other->size);
+	qSwap(this->components, other->components);
+	qSwap(this->interval, other->interval);
+	qSwap(this->spanFirst, other->spanFirst);
+	qSwap(this->spanCount, other->spanCount);
+	this->uploaded = false;
+	other->uploaded = false;
+}
+
+/// \brief Mark the values as changed.
+/// Has to be called after the values were written, they are uploaded again
+/// when the array is drawn the next time.
+void GlArray::invalidate() {
+	this->uploaded = false;
+}
+
+/// \brief Use the array as vertex array for the following drawing commands.
+/// Uploads the values into the vertex buffer object if they have changed. If
+/// vertex buffer objects aren't supported or the current context doesn't
+/// share the buffer, the values are used from client memory instead.
+/// \param program The shader program, 0 to use the array as vertex coordinates.
+/// \param attribute The attribute of the shader program that gets the values.
+/// \return false if the array is empty.
+bool GlArray::bind(QGLShaderProgram *program, const char *attribute) {
+	this->bound = false;
+	if(!this->data)
+		return false;
+	
+	const QGLContext *currentContext = QGLContext::currentContext();
+	if(!this->buffer && currentContext) {
+		this->buffer = new QGLBuffer(QGLBuffer::VertexBuffer);
+		// The graphs change with every frame, the grid never
+		this->buffer->setUsagePattern(QGLBuffer::DynamicDraw);
+		if(this->buffer->create()) {
+			this->context = currentContext;
+			this->uploaded = false;
+		}
+		else {
+			delete this->buffer;
+			this->buffer = 0;
+		}
+	}
+	
+	if(this->buffer && (this->context == currentContext || QGLContext::areSharing(this->context, currentContext)) && this->buffer->bind()) {
+		if(!this->uploaded) {
+			// Reallocating the storage orphans the old one, so there's no need to wait until it was drawn
+			this->buffer->allocate(this->data, this->size * sizeof(GLfloat));
+			this->uploaded = true;
+		}
+		if(program)
+			program->setAttributeBuffer(attribute, GL_FLOAT, 0, this->components);
+		else
+			glVertexPointer(this->components, GL_FLOAT, 0, 0);
+		this->bound = true;
+	}
+	else if(program)
+		program->setAttributeArray(attribute, this->data, this->components);
+	else
+		glVertexPointer(this->components, GL_FLOAT, 0, this->data);
+	
+	return true;
+}
+
+/// \brief Stop using the vertex buffer object after drawing the array.
+void GlArray::release() {
+	if(this->bound) {
+		this->buffer->release();
+		this->bound = false;
+	}
 }
 
 
@@ -75,153 +184,277 @@ void GlArray::setSize(unsigned long int size) {
 /// \brief Initializes the scope widget.
 /// \param settings The target settings object.
 /// \param parent The parent widget.
-GlGenerator::GlGenerator(DsoSettings *settings, QObject *parent) : QObject(parent) {
+GlGenerator::GlGenerator(DsoSettings *settings, QObject *parent) : QThread(parent) {
 	this->settings = settings;
 	
 	this->dataAnalyzer = 0;
+	this->requestMutex = new QMutex();
+	this->requested = false;
+	this->generating = false;
+	this->indexBack = 0;
+	this->graphsMutex = new QMutex();
+	this->zoomColumns = 0;
 	this->digitalPhosphorDepth = 0;
+	this->phosphorTextures = true;
+	this->sampleShaders = true;
+	this->frames = 0;
+	this->waterfallRows = 0;
+	
+	// Black, blue, cyan, yellow, red and white for rising levels
+	const unsigned char colormapStops[6][3] = {{0x00, 0x00, 0x00}, {0x00, 0x00, 0xff}, {0x00, 0xff, 0xff}, {0xff, 0xff, 0x00}, {0xff, 0x00, 0x00}, {0xff, 0xff, 0xff}};
+	for(int level = 0; level < 256; level++) {
+		double stopPosition = level * 5.0 / 255;
+		int stop = (int) stopPosition;
+		if(stop > 4)
+			stop = 4;
+		double fraction = stopPosition - stop;
+		for(int component = 0; component < 3; component++)
+			this->waterfallColormap[level][component] = (unsigned char) (colormapStops[stop][component] + (colormapStops[stop + 1][component] - colormapStops[stop][component]) * fraction + 0.5);
+	}
 	
 	this->generateGrid();
 }
 
 /// \brief Deletes OpenGL objects.
 GlGenerator::~GlGenerator() {
-	delete[] this->vaChannel;
+	// The generator thread mustn't use the arrays anymore
+	this->wait();
+	
+	for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
+		for(int channel = 0; channel < this->vaChannel[mode].count(); channel++)
+			qDeleteAll(this->vaChannel[mode][channel]);
+		qDeleteAll(this->vaZoom[mode]);
+		qDeleteAll(this->vaBack[mode]);
+		qDeleteAll(this->vaZoomBack[mode]);
+	}
+	qDeleteAll(this->unusedArrays);
+	delete this->requestMutex;
+	delete this->graphsMutex;
 }
 
 /// \brief Set the data analyzer whose data will be drawn.
+/// The graphs are generated when generateGraphs() is called, the
+/// RenderScheduler does that for the newest analyzed data.
 /// \param dataAnalyzer Pointer to the DataAnalyzer class.
 void GlGenerator::setDataAnalyzer(DataAnalyzer *dataAnalyzer) {
-	if(this->dataAnalyzer)
-		disconnect(this->dataAnalyzer, SIGNAL(finished()), this, SLOT(generateGraphs()));
 	this->dataAnalyzer = dataAnalyzer;
-	connect(this->dataAnalyzer, SIGNAL(finished()), this, SLOT(generateGraphs()));
 }
 
-/// \brief Prepare arrays for drawing the data we get from the data analyzer.
-void GlGenerator::generateGraphs() {
-	if(!this->dataAnalyzer)
-		return;
-	
-	// Adapt the number of graphs
-	for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
-		for(int channel = this->vaChannel[mode].count(); channel < this->settings->scope.voltage.count(); channel++)
-			this->vaChannel[mode].append(QList<GlArray *>());
-		for(int channel = this->settings->scope.voltage.count(); channel < this->vaChannel[mode].count(); channel++)
-			this->vaChannel[mode].removeLast();
+/// \brief Get the mutex for the graphs.
+/// The graphs are only replaced by the generator thread while it holds the
+/// mutex, so it has to be locked while drawing them.
+/// \return The mutex for the shown graphs.
+QMutex *GlGenerator::mutex() const {
+	return this->graphsMutex;
+}
+
+/// \brief Get the transformation of a graph from its values into divs.
+/// The x coordinate is \p scale[0] times the sample index or the voltage of
+/// the first XY channel plus \p offset[0], the y coordinate is calculated
+/// with \p scale[1] and \p offset[1].
+/// \param settings The settings with the current view settings.
+/// \param mode The Dso::ChannelMode of the graph.
+/// \param channel The channel of the graph, the first one for XY graphs.
+/// \param interval The sample interval of the graph.
+/// \param scale Array for the horizontal and vertical scale.
+/// \param offset Array for the horizontal and vertical offset.
+void GlGenerator::graphTransform(const DsoSettings *settings, int mode, int channel, double interval, GLfloat *scale, GLfloat *offset) {
+	if(settings->scope.horizontal.format == Dso::GRAPHFORMAT_XY) {
+		scale[0] = 1.0 / settings->scope.voltage[channel].gain;
+		offset[0] = settings->scope.voltage[channel].offset;
+		scale[1] = 1.0 / settings->scope.voltage[channel + 1].gain;
+		offset[1] = settings->scope.voltage[channel + 1].offset;
 	}
+	else if(mode == Dso::CHANNELMODE_VOLTAGE) {
+		scale[0] = interval / settings->scope.horizontal.timebase;
+		offset[0] = -DIVS_TIME / 2;
+		scale[1] = 1.0 / settings->scope.voltage[channel].gain;
+		offset[1] = settings->scope.voltage[channel].offset;
+	}
+	else {
+		scale[0] = interval / settings->scope.horizontal.frequencybase;
+		offset[0] = -DIVS_TIME / 2;
+		scale[1] = 1.0 / settings->scope.spectrum[channel].magnitude;
+		offset[1] = settings->scope.spectrum[channel].offset;
+	}
+}
+
+/// \brief Get the samples of a graph that are visible in the zoomed scope.
+/// The samples next to the markers are included, so the graph reaches the
+/// borders of the zoomed scope.
+/// \param settings The settings with the marker positions.
+/// \param divSamples The number of samples per div.
+/// \param count The number of samples of the graph.
+/// \param first Returns the index of the first visible sample.
+/// \return The number of visible samples.
+unsigned long int GlGenerator::zoomSpan(const DsoSettings *settings, double divSamples, unsigned long int count, unsigned long int *first) {
+	*first = 0;
+	if(!count)
+		return 0;
 	
-	// Set digital phosphor depth to one if we don't use it
-	if(this->settings->view.digitalPhosphor)
-		this->digitalPhosphorDepth = this->settings->view.digitalPhosphorDepth;
-	else
-		this->digitalPhosphorDepth = 1;
+	double begin = floor((qMin(settings->scope.horizontal.marker[0], settings->scope.horizontal.marker[1]) + DIVS_TIME / 2) * divSamples);
+	double end = ceil((qMax(settings->scope.horizontal.marker[0], settings->scope.horizontal.marker[1]) + DIVS_TIME / 2) * divSamples);
+	if(begin < 0)
+		begin = 0;
+	if(end > count - 1)
+		end = count - 1;
+	if(end < begin)
+		return 0;
 	
-	// Handle all digital phosphor related list manipulations
-	for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
-		for(int channel = 0; channel < this->vaChannel[mode].count(); channel++) {
-			// Resize lists for vector array if the digital phosphor depth has changed
-			if(this->vaChannel[mode][channel].count() != this->digitalPhosphorDepth)
-			for(int index = this->vaChannel[mode][channel].count(); index < this->digitalPhosphorDepth; index++)
-				this->vaChannel[mode][channel].append(new GlArray());
-			for(int index = this->digitalPhosphorDepth; index < this->vaChannel[mode][channel].count(); index++) {
-				delete this->vaChannel[mode][channel].last();
-				this->vaChannel[mode][channel].removeLast();
-			}
-			
-			// Move the last list element to the front
-			this->vaChannel[mode][channel].move(this->digitalPhosphorDepth -1, 0);
+	*first = (unsigned long int) begin;
+	return (unsigned long int) end - *first + 1;
+}
+
+/// \brief Generates graphs until no new data is waiting.
+void GlGenerator::run() {
+	while(true) {
+		this->requestMutex->lock();
+		if(!this->requested) {
+			this->generating = false;
+			this->requestMutex->unlock();
+			return;
 		}
+		this->requested = false;
+		this->requestMutex->unlock();
+		
+		// Use the same settings for the whole frame
+		Dso::GraphFormat format = this->settings->scope.horizontal.format;
+		int channelCount = this->settings->scope.voltage.count();
+		
+		this->generateBack(format, channelCount);
+		this->publishBack(format, channelCount);
+		
+		emit graphsGenerated();
 	}
+}
+
+/// \brief Write the data we get from the data analyzer into the back arrays.
+/// Only the data analyzer is locked meanwhile, the shown graphs aren't touched.
+/// \param format The graph format that should be generated.
+/// \param channelCount The number of channels.
+void GlGenerator::generateBack(Dso::GraphFormat format, int channelCount) {
+	// Adapt the number of back arrays
+	for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
+		while(this->vaBack[mode].count() < channelCount)
+			this->vaBack[mode].append(new GlArray());
+		while(this->vaBack[mode].count() > channelCount)
+			delete this->vaBack[mode].takeLast();
+		while(this->vaZoomBack[mode].count() < channelCount)
+			this->vaZoomBack[mode].append(new GlArray());
+		while(this->vaZoomBack[mode].count() > channelCount)
+			delete this->vaZoomBack[mode].takeLast();
+	}
+	while(this->eyeBack.count() < channelCount)
+		this->eyeBack.append(QByteArray());
+	while(this->eyeBack.count() > channelCount)
+		this->eyeBack.removeLast();
+	while(this->waterfallBack.count() < channelCount)
+		this->waterfallBack.append(QByteArray());
+	while(this->waterfallBack.count() > channelCount)
+		this->waterfallBack.removeLast();
+	
+	bool compact = this->sampleShaders;
+	this->indexBack = 0;
 	
 	this->dataAnalyzer->mutex()->lock();
 	
-	switch(this->settings->scope.horizontal.format) {
+	switch(format) {
 		case Dso::GRAPHFORMAT_TY:
 			// Add graphs for channels
 			for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
-				for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
+				for(int channel = 0; channel < channelCount; channel++) {
+					GlArray *graph = this->vaBack[mode][channel];
+					
 					// Check if this channel is used and available at the data analyzer
 					if(((mode == Dso::CHANNELMODE_VOLTAGE) ? this->settings->scope.voltage[channel].used : this->settings->scope.spectrum[channel].used) && this->dataAnalyzer->data(channel)->samples.voltage.sample) {
-						// Check if the sample count has changed
-						unsigned int neededSize = ((mode == Dso::CHANNELMODE_VOLTAGE) ? this->dataAnalyzer->data(channel)->samples.voltage.count : this->dataAnalyzer->data(channel)->samples.spectrum.count) * 2;
-						for(int index = 0; index < this->digitalPhosphorDepth; index++) {
-							if(this->vaChannel[mode][channel][index]->getSize() != neededSize)
-								this->vaChannel[mode][channel][index]->setSize(0);
-						}
+						const SampleValues *samples = (mode == Dso::CHANNELMODE_VOLTAGE) ? &(this->dataAnalyzer->data(channel)->samples.voltage) : &(this->dataAnalyzer->data(channel)->samples.spectrum);
 						
-						// Check if the array is allocated
-						if(!this->vaChannel[mode][channel].first()->data)
-							this->vaChannel[mode][channel].first()->setSize(neededSize);
-						
-						GLfloat *vaNewChannel = this->vaChannel[mode][channel].first()->data;
-						
-						// What's the horizontal distance between sampling points?
-						double horizontalFactor;
-						if(mode == Dso::CHANNELMODE_VOLTAGE)
-							horizontalFactor = this->dataAnalyzer->data(channel)->samples.voltage.interval / this->settings->scope.horizontal.timebase;
-						else
-							horizontalFactor = this->dataAnalyzer->data(channel)->samples.spectrum.interval / this->settings->scope.horizontal.frequencybase;
-						
-						// Fill vector array
-						unsigned int arrayPosition = 0;
-						if(mode == Dso::CHANNELMODE_VOLTAGE) {
-							for(unsigned int position = 0; position < this->dataAnalyzer->data(channel)->samples.voltage.count; position++) {
-								vaNewChannel[arrayPosition++] = position * horizontalFactor - DIVS_TIME / 2;
-								vaNewChannel[arrayPosition++] = this->dataAnalyzer->data(channel)->samples.voltage.sample[position] / this->settings->scope.voltage[channel].gain + this->settings->scope.voltage[channel].offset;
-							}
+						if(compact) {
+							// Only copy the samples, the coordinates are calculated by the shader
+							graph->setSize(samples->count, 1);
+							for(unsigned int position = 0; position < samples->count; position++)
+								graph->data[position] = samples->sample[position];
+							
+							if(this->indexBack < samples->count)
+								this->indexBack = samples->count;
 						}
 						else {
-							for(unsigned int position = 0; position < this->dataAnalyzer->data(channel)->samples.spectrum.count; position++) {
-								vaNewChannel[arrayPosition++] = position * horizontalFactor - DIVS_TIME / 2;
-								vaNewChannel[arrayPosition++] = this->dataAnalyzer->data(channel)->samples.spectrum.sample[position] / this->settings->scope.spectrum[channel].magnitude + this->settings->scope.spectrum[channel].offset;
+							// Fill vector array with sample index and value, the GlScope transforms them into divs
+							graph->setSize(samples->count * 2);
+							unsigned int arrayPosition = 0;
+							for(unsigned int position = 0; position < samples->count; position++) {
+								graph->data[arrayPosition++] = position;
+								graph->data[arrayPosition++] = samples->sample[position];
 							}
 						}
+						graph->interval = samples->interval;
+						
+						// The zoomed scope gets its own graph if there are more samples than pixels
+						this->generateZoom(samples, (mode == Dso::CHANNELMODE_VOLTAGE) ? this->settings->scope.horizontal.timebase : this->settings->scope.horizontal.frequencybase, this->vaZoomBack[mode][channel]);
 					}
 					else {
-						// Delete all vector arrays
-						for(int index = 0; index < this->digitalPhosphorDepth; index++)
-							this->vaChannel[mode][channel][index]->setSize(0);
+						graph->setSize(0);
+						this->vaZoomBack[mode][channel]->setSize(0);
 					}
 				}
 			}
 			break;
-			
+		
 		case Dso::GRAPHFORMAT_XY:
-			for(int channel = 0; channel < this->settings->scope.voltage.count(); channel ++) {
+			for(int channel = 0; channel < channelCount; channel ++) {
+				GlArray *graph = this->vaBack[Dso::CHANNELMODE_VOLTAGE][channel];
+				
 				// For even channel numbers check if this channel is used and this and the following channel are available at the data analyzer
-				if(channel % 2 == 0 && channel + 1 < this->settings->scope.voltage.count() && this->settings->scope.voltage[channel].used && this->dataAnalyzer->data(channel)->samples.voltage.sample && this->dataAnalyzer->data(channel + 1)->samples.voltage.sample) {
-					// Check if the sample count has changed
-					unsigned int neededSize = qMin(this->dataAnalyzer->data(channel)->samples.voltage.count, this->dataAnalyzer->data(channel + 1)->samples.voltage.count) * 2;
-					for(int index = 0; index < this->digitalPhosphorDepth; index++) {
-						if(this->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel][index]->getSize() != neededSize)
-							this->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel][index]->setSize(0);
-					}
+				if(channel % 2 == 0 && channel + 1 < channelCount && this->settings->scope.voltage[channel].used && this->dataAnalyzer->data(channel)->samples.voltage.sample && this->dataAnalyzer->data(channel + 1)->samples.voltage.sample) {
+					unsigned int count = qMin(this->dataAnalyzer->data(channel)->samples.voltage.count, this->dataAnalyzer->data(channel + 1)->samples.voltage.count);
+					graph->setSize(count * 2);
 					
-					// Check if the array is allocated
-					if(!this->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel].first()->data)
-						this->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel].first()->setSize(neededSize);
-					
-					GLfloat *vaNewChannel = this->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel].first()->data;
-					
-					// Fill vector array
+					// Fill vector array with the voltages, the GlScope transforms them into divs
 					unsigned int arrayPosition = 0;
 					unsigned int xChannel = channel;
 					unsigned int yChannel = channel + 1;
-					for(unsigned int position = 0; position < this->dataAnalyzer->data(channel)->samples.voltage.count; position++) {
-						vaNewChannel[arrayPosition++] = this->dataAnalyzer->data(xChannel)->samples.voltage.sample[position] / this->settings->scope.voltage[xChannel].gain + this->settings->scope.voltage[xChannel].offset;
-						vaNewChannel[arrayPosition++] = this->dataAnalyzer->data(yChannel)->samples.voltage.sample[position] / this->settings->scope.voltage[yChannel].gain + this->settings->scope.voltage[yChannel].offset;
+					for(unsigned int position = 0; position < count; position++) {
+						graph->data[arrayPosition++] = this->dataAnalyzer->data(xChannel)->samples.voltage.sample[position];
+						graph->data[arrayPosition++] = this->dataAnalyzer->data(yChannel)->samples.voltage.sample[position];
 					}
 				}
-				else {
-					// Delete all vector arrays
-					for(int index = 0; index < this->digitalPhosphorDepth; index++)
-						this->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel][index]->setSize(0);
-				}
+				else
+					graph->setSize(0);
 				
 				// Delete all spectrum graphs
-				for(int index = 0; index < this->digitalPhosphorDepth; index++)
-					this->vaChannel[Dso::CHANNELMODE_SPECTRUM][channel][index]->setSize(0);
+				this->vaBack[Dso::CHANNELMODE_SPECTRUM][channel]->setSize(0);
+			}
+			break;
+		
+		case Dso::GRAPHFORMAT_EYE:
+			for(int channel = 0; channel < channelCount; channel++) {
+				const EyeDiagram *eyeDiagram = this->dataAnalyzer->eyeDiagram(channel);
+				if(this->settings->scope.voltage[channel].used && eyeDiagram && eyeDiagram->getFrames()) {
+					// Convert the hit counts into texture intensities
+					this->eyeBack[channel].resize(EYE_TIME_BINS * EYE_VOLTAGE_BINS);
+					eyeDiagram->toIntensity((unsigned char *) this->eyeBack[channel].data());
+				}
+				else
+					this->eyeBack[channel].clear();
+				
+				// Delete all graphs, the histogram replaces them
+				for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++)
+					this->vaBack[mode][channel]->setSize(0);
+			}
+			break;
+		
+		case Dso::GRAPHFORMAT_WATERFALL:
+			for(int channel = 0; channel < channelCount; channel++) {
+				if(this->settings->scope.spectrum[channel].used && this->dataAnalyzer->data(channel)->samples.spectrum.sample) {
+					this->waterfallBack[channel].resize(WATERFALL_WIDTH * 3);
+					this->generateWaterfallRow(channel, (unsigned char *) this->waterfallBack[channel].data());
+				}
+				else
+					this->waterfallBack[channel].clear();
+				
+				// Delete all graphs, the waterfall replaces them
+				for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++)
+					this->vaBack[mode][channel]->setSize(0);
 			}
 			break;
 		
@@ -229,9 +462,229 @@ void GlGenerator::generateGraphs() {
 			break;
 	}
 	
+	// Only the TY graphs are decimated for the zoomed scope
+	if(format != Dso::GRAPHFORMAT_TY) {
+		for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
+			for(int channel = 0; channel < channelCount; channel++)
+				this->vaZoomBack[mode][channel]->setSize(0);
+		}
+	}
+	
+	// Get the decoded words, they are shared with the data analyzer
+	if(this->settings->scope.decoder.enabled && format == Dso::GRAPHFORMAT_TY)
+		this->annotationsBack = this->dataAnalyzer->decoder()->getAnnotations();
+	else
+		this->annotationsBack.clear();
+	
 	this->dataAnalyzer->mutex()->unlock();
+}
+
+/// \brief Decimate the samples between the markers for the zoomed scope.
+/// Every pixel column gets the minimum and maximum of its samples in their
+/// original order, so the graph looks like the one with all samples. The
+/// array stays empty if there aren't more samples than pixels.
+/// \param samples The samples of the graph.
+/// \param base The time-/frequencybase of the graph.
+/// \param zoom The array for the decimated graph.
+void GlGenerator::generateZoom(const SampleValues *samples, double base, GlArray *zoom) {
+	unsigned long int first;
+	unsigned long int count = zoomSpan(this->settings, base / samples->interval, samples->count, &first);
+	unsigned long int columns = this->zoomColumns;
+	if(!this->settings->view.zoom || !columns || count <= columns * 2) {
+		zoom->setSize(0);
+		return;
+	}
+	
+	zoom->setSize(columns * 2 * 2);
+	unsigned int arrayPosition = 0;
+	for(unsigned long int column = 0; column < columns; column++) {
+		unsigned long int columnBegin = first + count * column / columns;
+		unsigned long int columnEnd = first + count * (column + 1) / columns;
+		
+		unsigned long int minimum = columnBegin;
+		unsigned long int maximum = columnBegin;
+		for(unsigned long int position = columnBegin + 1; position < columnEnd; position++) {
+			if(samples->sample[position] < samples->sample[minimum])
+				minimum = position;
+			else if(samples->sample[position] > samples->sample[maximum])
+				maximum = position;
+		}
+		
+		zoom->data[arrayPosition++] = qMin(minimum, maximum);
+		zoom->data[arrayPosition++] = samples->sample[qMin(minimum, maximum)];
+		zoom->data[arrayPosition++] = qMax(minimum, maximum);
+		zoom->data[arrayPosition++] = samples->sample[qMax(minimum, maximum)];
+	}
+	zoom->interval = samples->interval;
+	zoom->spanFirst = first;
+	zoom->spanCount = count;
+}
+
+/// \brief Replace the shown graphs with the back arrays.
+/// Only pointers are swapped while the graphs are locked, the oldest graphs
+/// become the back arrays for the next frame.
+/// \param format The graph format that was generated.
+/// \param channelCount The number of channels.
+void GlGenerator::publishBack(Dso::GraphFormat format, int channelCount) {
+	this->graphsMutex->lock();
+	
+	// Adapt the number of graphs
+	for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
+		while(this->vaChannel[mode].count() < channelCount)
+			this->vaChannel[mode].append(QList<GlArray *>());
+		while(this->vaChannel[mode].count() > channelCount)
+			this->unusedArrays.append(this->vaChannel[mode].takeLast());
+		while(this->vaZoom[mode].count() < channelCount)
+			this->vaZoom[mode].append(new GlArray());
+		while(this->vaZoom[mode].count() > channelCount)
+			this->unusedArrays.append(this->vaZoom[mode].takeLast());
+	}
+	while(this->eyeChannel.count() < channelCount)
+		this->eyeChannel.append(QByteArray());
+	while(this->eyeChannel.count() > channelCount)
+		this->eyeChannel.removeLast();
+	while(this->waterfallChannel.count() < channelCount)
+		this->waterfallChannel.append(QByteArray());
+	while(this->waterfallChannel.count() > channelCount)
+		this->waterfallChannel.removeLast();
+	
+	// Set digital phosphor depth to one if we don't use it or the scopes accumulate it in textures
+	if(this->settings->view.digitalPhosphor && !this->phosphorTextures)
+		this->digitalPhosphorDepth = this->settings->view.digitalPhosphorDepth;
+	else
+		this->digitalPhosphorDepth = 1;
+	
+	// Handle all digital phosphor related list manipulations
+	for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
+		for(int channel = 0; channel < channelCount; channel++) {
+			QList<GlArray *> &layers = this->vaChannel[mode][channel];
+			
+			// Resize lists for vector array if the digital phosphor depth has changed
+			while(layers.count() < this->digitalPhosphorDepth)
+				layers.append(new GlArray());
+			while(layers.count() > this->digitalPhosphorDepth)
+				this->unusedArrays.append(layers.takeLast());
+			
+			// Move the last list element to the front and replace it with the new graph
+			layers.move(this->digitalPhosphorDepth - 1, 0);
+			layers.first()->swapData(this->vaBack[mode][channel]);
+			this->vaZoom[mode][channel]->swapData(this->vaZoomBack[mode][channel]);
+			
+			// Older graphs with another sample count don't fit anymore
+			for(int index = 1; index < this->digitalPhosphorDepth; index++) {
+				if(layers[index]->getSize() != layers.first()->getSize() || layers[index]->getComponents() != layers.first()->getComponents())
+					layers[index]->setSize(0);
+			}
+		}
+	}
+	
+	// The indices are shared by all compact arrays, so they only have to grow
+	if(this->vaIndex.getSize() < this->indexBack) {
+		this->vaIndex.setSize(this->indexBack, 1);
+		for(unsigned int position = 0; position < this->indexBack; position++)
+			this->vaIndex.data[position] = position;
+	}
+	
+	for(int channel = 0; channel < channelCount; channel++)
+		qSwap(this->eyeChannel[channel], this->eyeBack[channel]);
+	
+	if(format == Dso::GRAPHFORMAT_WATERFALL) {
+		for(int channel = 0; channel < channelCount; channel++) {
+			if(this->waterfallBack[channel].isEmpty()) {
+				this->waterfallChannel[channel].clear();
+				continue;
+			}
+			
+			// Start with an empty history for new channels
+			if(this->waterfallChannel[channel].size() != WATERFALL_WIDTH * WATERFALL_HISTORY * 3)
+				this->waterfallChannel[channel].fill(0, WATERFALL_WIDTH * WATERFALL_HISTORY * 3);
+			
+			// Only the new row is written, the older rows stay where they are
+			memcpy(this->waterfallChannel[channel].data() + (this->waterfallRows % WATERFALL_HISTORY) * WATERFALL_WIDTH * 3, this->waterfallBack[channel].constData(), WATERFALL_WIDTH * 3);
+		}
+		this->waterfallRows++;
+	}
+	else if(this->waterfallRows) {
+		// Free the waterfall history when it isn't shown
+		for(int channel = 0; channel < this->waterfallChannel.count(); channel++)
+			this->waterfallChannel[channel].clear();
+		this->waterfallRows = 0;
+	}
+	
+	qSwap(this->annotations, this->annotationsBack);
+	
+	this->frames++;
 	
-	emit graphsGenerated();
+	this->graphsMutex->unlock();
+}
+
+/// \brief Generate the graphs for the newly analyzed data.
+/// The generator thread is started if it isn't running, otherwise it will
+/// generate the graphs again after the current frame.
+/// \return false if a request that wasn't handled yet was replaced.
+bool GlGenerator::generateGraphs() {
+	if(!this->dataAnalyzer)
+		return true;
+	
+	this->requestMutex->lock();
+	bool replaced = this->requested;
+	this->requested = true;
+	bool idle = !this->generating;
+	this->generating = true;
+	this->requestMutex->unlock();
+	
+	if(idle) {
+		// The thread may still be returning from the previous request
+		this->wait();
+		this->start();
+	}
+	
+	return !replaced;
+}
+
+/// \brief Converts the spectrum of a channel into a colored waterfall row.
+/// Several frequency bins can share a column, the strongest one is used so
+/// narrow peaks don't disappear.
+/// \param channel The channel whose spectrum should be converted.
+/// \param row The row with #WATERFALL_WIDTH RGB values.
+void GlGenerator::generateWaterfallRow(int channel, unsigned char *row) {
+	const SampleValues *spectrum = &(this->dataAnalyzer->data(channel)->samples.spectrum);
+	
+	// Get the strongest bin of each column
+	double columnLevel[WATERFALL_WIDTH];
+	bool columnUsed[WATERFALL_WIDTH];
+	for(int column = 0; column < WATERFALL_WIDTH; column++)
+		columnUsed[column] = false;
+	double columnFactor = spectrum->interval / this->settings->scope.horizontal.frequencybase / DIVS_TIME * WATERFALL_WIDTH;
+	for(unsigned int position = 0; position < spectrum->count; position++) {
+		int column = (int) (position * columnFactor);
+		if(column >= WATERFALL_WIDTH)
+			break;
+		
+		if(!columnUsed[column] || spectrum->sample[position] > columnLevel[column]) {
+			columnLevel[column] = spectrum->sample[position];
+			columnUsed[column] = true;
+		}
+	}
+	
+	// Map the magnitude into the colormap like the screen position of the spectrum graph
+	int level = 0;
+	for(int column = 0; column < WATERFALL_WIDTH; column++) {
+		// Repeat the previous bin if the bins are wider than the columns
+		if(columnUsed[column]) {
+			double screenLevel = (columnLevel[column] / this->settings->scope.spectrum[channel].magnitude + this->settings->scope.spectrum[channel].offset + DIVS_VOLTAGE / 2) / DIVS_VOLTAGE;
+			if(screenLevel < 0)
+				level = 0;
+			else if(screenLevel > 1)
+				level = 255;
+			else
+				level = (int) (screenLevel * 255);
+		}
+		
+		row[column * 3] = this->waterfallColormap[level][0];
+		row[column * 3 + 1] = this->waterfallColormap[level][1];
+		row[column * 3 + 2] = this->waterfallColormap[level][2];
+	}
 }
 
 /// \brief Create the needed OpenGL vertex arrays for the grid.
@@ -29,69 +29,132 @@
 #define GLGENERATOR_H
 
 
+#include <QByteArray>
 #include <QGLWidget>
 #include <QList>
-#include <QObject>
+#include <QThread>
 
 
+#include "decoder.h"
 #include "dso.h"
 
 
-#define DIVS_TIME                  10.0 ///< Number of horizontal screen divs
-#define DIVS_VOLTAGE                8.0 ///< Number of vertical screen divs
-#define DIVS_SUB                      5 ///< Number of sub-divisions per div
+#define WATERFALL_WIDTH             512 ///< Columns of the waterfall texture
+#define WATERFALL_HISTORY           256 ///< Spectra kept in the waterfall texture
 
 
 class DataAnalyzer;
 class DsoSettings;
 class GlScope;
+class QGLBuffer;
+class QGLShaderProgram;
+class QMutex;
+struct SampleValues;
 
 
 ////////////////////////////////////////////////////////////////////////////////
 /// \class GlArray                                                 glgenerator.h
 /// \brief An array of GLfloat values and it's size.
+/// The values are copied into a vertex buffer object when they are drawn the
+/// first time after a change, so unchanged arrays aren't sent to the graphics
+/// card again. The buffer can be used by all GlScopes sharing the context.
+/// Compact arrays only contain one value per sample, the x coordinate is
+/// calculated from the index of the value by the shader. Decimated arrays
+/// contain a part of the samples, the minimum and maximum for each pixel.
 class GlArray {
 	public:
 		GlArray();
 		~GlArray();
 		
 		unsigned long int getSize();
-		void setSize(unsigned long int size);
+		unsigned long int getVertexCount();
+		unsigned int getComponents();
+		void setSize(unsigned long int size, unsigned int components = 2);
+		void swapData(GlArray *other);
+		void invalidate();
+		
+		bool bind(QGLShaderProgram *program = 0, const char *attribute = 0);
+		void release();
 		
 		GLfloat *data; ///< Pointer to the array
+		double interval; ///< Distance between two samples of a compact array in s or Hz
+		unsigned long int spanFirst; ///< Index of the first sample a decimated array was generated from
+		unsigned long int spanCount; ///< Number of samples a decimated array was generated from
 	
 	protected:
 		unsigned long int size; ///< The array size (Number of GLfloat values)
+		unsigned int components; ///< Number of GLfloat values per vertex
+		QGLBuffer *buffer; ///< The vertex buffer object, 0 if not created yet
+		const QGLContext *context; ///< The context the buffer was created in
+		bool uploaded; ///< true if the buffer holds the current values
+		bool bound; ///< true if the buffer is bound by the last call of bind()
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 /// \class GlGenerator                                             glgenerator.h
 /// \brief Generates the vertex arrays for the GlScope classes.
-class GlGenerator : public QObject {
+/// The arrays are filled by the generator thread. The new graphs are written
+/// into back arrays first and swapped with the shown ones afterwards, the
+/// GlScope classes lock the mutex() while they are drawing the graphs.
+class GlGenerator : public QThread {
 	Q_OBJECT
 	
 	friend class GlScope;
+	friend class GraphRenderer;
 	
 	public:
 		GlGenerator(DsoSettings *settings, QObject *parent = 0);
 		~GlGenerator();
 		
 		void setDataAnalyzer(DataAnalyzer *dataAnalyzer);
+		QMutex *mutex() const;
+		
+		static void graphTransform(const DsoSettings *settings, int mode, int channel, double interval, GLfloat *scale, GLfloat *offset);
+		static unsigned long int zoomSpan(const DsoSettings *settings, double divSamples, unsigned long int count, unsigned long int *first);
 	
 	protected:
+		void run();
+		void generateBack(Dso::GraphFormat format, int channelCount);
+		void generateZoom(const SampleValues *samples, double base, GlArray *zoom);
+		void publishBack(Dso::GraphFormat format, int channelCount);
 		void generateGrid();
+		void generateWaterfallRow(int channel, unsigned char *row);
 	
 	private:
 		DataAnalyzer *dataAnalyzer;
 		DsoSettings *settings;
 		
+		QMutex *requestMutex; ///< A mutex for the request flags
+		bool requested; ///< true if new data was analyzed since the generation was started
+		bool generating; ///< true until the generator thread has no more requests
+		
+		QList<GlArray *> vaBack[Dso::CHANNELMODE_COUNT]; ///< The arrays the generator thread writes the next graph of each channel to
+		QList<GlArray *> vaZoomBack[Dso::CHANNELMODE_COUNT]; ///< The next decimated graphs for the zoomed scope
+		QList<QByteArray> eyeBack; ///< The next eye diagram intensities
+		QList<QByteArray> waterfallBack; ///< The next waterfall row of each channel, empty if unused
+		QList<DecoderAnnotation> annotationsBack; ///< The next decoded words
+		unsigned int indexBack; ///< The number of sample indices needed by the back arrays
+		
+		QMutex *graphsMutex; ///< A mutex for the shown graphs
+		QList<GlArray *> unusedArrays; ///< Removed arrays, they are deleted by the GUI thread that owns their buffers
 		QList<QList<GlArray *> > vaChannel[Dso::CHANNELMODE_COUNT];
+		QList<GlArray *> vaZoom[Dso::CHANNELMODE_COUNT]; ///< The decimated newest graphs for the zoomed scope, empty if not needed
+		int zoomColumns; ///< Width of the zoomed scope in pixels, set by the GlScope
 		GlArray vaGrid[3];
+		GlArray vaIndex; ///< The sample indices for the compact arrays
+		QList<QByteArray> eyeChannel; ///< Eye diagram intensities, empty if unused
+		QList<QByteArray> waterfallChannel; ///< Ring of RGB spectrum rows, empty if unused
+		unsigned long int waterfallRows; ///< Rows written into the rings, the next one goes to waterfallRows % #WATERFALL_HISTORY
+		unsigned char waterfallColormap[256][3]; ///< RGB color for each spectrum level
+		QList<DecoderAnnotation> annotations; ///< Decoded words of the protocol decoder
 		
 		int digitalPhosphorDepth;
+		bool phosphorTextures; ///< true if the scopes accumulate the digital phosphor in textures
+		bool sampleShaders; ///< true if the scopes calculate the coordinates of the TY graphs with shaders
+		unsigned long int frames; ///< Number of generated frames
 	
 	public slots:
-		void generateGraphs();
+		bool generateGraphs();
 	
 	signals:
 		void graphsGenerated(); ///< The graphs are ready to be drawn
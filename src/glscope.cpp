@@ -27,29 +27,83 @@
 #include <cmath>
 
 #include <QColor>
+#include <QFontMetrics>
+#include <QMutex>
 
 
 #include "glscope.h"
 
 #include "dataanalyzer.h"
+#include "eyediagram.h"
 #include "glgenerator.h"
 #include "settings.h"
 
 
+/// \brief Calculates the coordinates of compact arrays from index and sample value.
+static const char *graphVertexShader =
+	"attribute float index;\n"
+	"attribute float value;\n"
+	"uniform vec2 scale;\n"
+	"uniform vec2 offset;\n"
+	"void main() {\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * vec4(index * scale.x + offset.x, value * scale.y + offset.y, 0.0, 1.0);\n"
+	"	gl_FrontColor = gl_Color;\n"
+	"}\n";
+
+/// \brief Uses the color set with glColor like the fixed function pipeline.
+static const char *graphFragmentShader =
+	"void main() {\n"
+	"	gl_FragColor = gl_Color;\n"
+	"}\n";
+
+
+/// \brief Get the OpenGL format for the scopes.
+/// \param settings The settings that should be used.
+/// \return The default format, synchronized to the vertical retrace if enabled.
+static QGLFormat scopeFormat(DsoSettings *settings) {
+	QGLFormat format = QGLFormat::defaultFormat();
+	if(settings->view.vsync)
+		format.setSwapInterval(1);
+	
+	return format;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // class GlScope
 /// \brief Initializes the scope widget.
 /// \param settings The settings that should be used.
 /// \param parent The parent widget.
-GlScope::GlScope(DsoSettings *settings, QWidget *parent) : QGLWidget(parent) {
+/// \param shareWidget The scope whose textures and vertex buffers should be shared.
+GlScope::GlScope(DsoSettings *settings, QWidget *parent, const QGLWidget *shareWidget) : QGLWidget(scopeFormat(settings), parent, shareWidget) {
 	this->settings = settings;
 	
 	this->generator = 0;
 	this->zoomed = false;
+	this->phosphorBuffer = 0;
+	this->phosphorFrames = 0;
+	this->phosphorReset = false;
+	this->phosphorRounded = false;
+	this->blendEquation = 0;
+	this->graphProgram = 0;
 }
 
 /// \brief Deletes OpenGL objects.
 GlScope::~GlScope() {
+	if(this->phosphorBuffer) {
+		this->makeCurrent();
+		delete this->phosphorBuffer;
+	}
+	if(!this->eyeTextures.isEmpty()) {
+		this->makeCurrent();
+		for(int channel = 0; channel < this->eyeTextures.count(); channel++)
+			glDeleteTextures(1, &(this->eyeTextures[channel]));
+	}
+	if(!this->waterfallTextures.isEmpty()) {
+		this->makeCurrent();
+		for(int channel = 0; channel < this->waterfallTextures.count(); channel++)
+			glDeleteTextures(1, &(this->waterfallTextures[channel]));
+	}
 }
 
 /// \brief Initializes OpenGL output.
@@ -66,6 +120,17 @@ void GlScope::initializeGL() {
 	glLineStipple(1, 0x3333);
 	
 	glEnableClientState(GL_VERTEX_ARRAY);
+	
+	// The shader calculates the coordinates of the TY graphs from the samples
+	if(QGLShaderProgram::hasOpenGLShaderPrograms(this->context())) {
+		this->graphProgram = new QGLShaderProgram(this->context(), this);
+		if(!this->graphProgram->addShaderFromSourceCode(QGLShader::Vertex, graphVertexShader) || !this->graphProgram->addShaderFromSourceCode(QGLShader::Fragment, graphFragmentShader) || !this->graphProgram->link()) {
+			delete this->graphProgram;
+			this->graphProgram = 0;
+		}
+	}
+	if(!this->graphProgram && this->generator)
+		this->generator->sampleShaders = false;
 }
 
 /// \brief Draw the graphs and the grid.
@@ -77,77 +142,81 @@ void GlScope::paintGL() {
 	glClear(GL_COLOR_BUFFER_BIT);
 	glLineWidth(1);
 	
-	// Draw the graphs
-	if(this->generator && this->generator->digitalPhosphorDepth > 0) {
-		if(this->settings->view.antialiasing) {
-			glEnable(GL_POINT_SMOOTH);
-			glEnable(GL_LINE_SMOOTH);
-			glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
-		}
-		
-		// Apply zoom settings via matrix transformation
-		if(this->zoomed) {
-			glPushMatrix();
-			glScalef(DIVS_TIME / fabs(this->settings->scope.horizontal.marker[1] - this->settings->scope.horizontal.marker[0]), 1.0, 1.0);
-			glTranslatef(-(this->settings->scope.horizontal.marker[0] + this->settings->scope.horizontal.marker[1]) / 2, 0.0, 0.0);
-		}
+	// Draw the graphs, the generator doesn't replace them meanwhile
+	if(this->generator) {
+		this->generator->mutex()->lock();
 		
-		// Values we need for the fading of the digital phosphor
-		double *fadingFactor = new double[this->generator->digitalPhosphorDepth];
-		fadingFactor[0] = 100;
-		double fadingRatio = pow(10.0, 2.0 / this->generator->digitalPhosphorDepth);
-		for(int index = 1; index < this->generator->digitalPhosphorDepth; index++)
-			fadingFactor[index] = fadingFactor[index - 1] * fadingRatio;
+		// Delete the arrays the generator doesn't use anymore, their buffers belong to this thread
+		while(!this->generator->unusedArrays.isEmpty())
+			delete this->generator->unusedArrays.takeFirst();
 		
-		switch(this->settings->scope.horizontal.format) {
-			case Dso::GRAPHFORMAT_TY:
-				// Real and virtual channels
-				for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < Dso::CHANNELMODE_COUNT; mode++) {
-					for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
-						if((mode == Dso::CHANNELMODE_VOLTAGE) ? this->settings->scope.voltage[channel].used : this->settings->scope.spectrum[channel].used) {
-							// Draw graph for all available depths
-							for(int index = this->generator->digitalPhosphorDepth - 1; index >= 0; index--) {
-								if(this->generator->vaChannel[mode][channel][index]->data) {
-									if(mode == Dso::CHANNELMODE_VOLTAGE)
-										this->qglColor(this->settings->view.color.screen.voltage[channel].darker(fadingFactor[index]));
-									else
-										this->qglColor(this->settings->view.color.screen.spectrum[channel].darker(fadingFactor[index]));
-									glVertexPointer(2, GL_FLOAT, 0, this->generator->vaChannel[mode][channel][index]->data);
-									glDrawArrays((this->settings->view.interpolation == Dso::INTERPOLATION_OFF) ? GL_POINTS : GL_LINE_STRIP, 0, this->generator->vaChannel[mode][channel][index]->getSize() / 2);
-								}
-							}
-						}
-					}
-				}
-				break;
+		if(this->generator->digitalPhosphorDepth > 0) {
+			if(this->settings->view.antialiasing) {
+				glEnable(GL_POINT_SMOOTH);
+				glEnable(GL_LINE_SMOOTH);
+				glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
+			}
+			
+			// Apply zoom settings via matrix transformation
+			if(this->zoomed) {
+				glPushMatrix();
+				glScalef(DIVS_TIME / fabs(this->settings->scope.horizontal.marker[1] - this->settings->scope.horizontal.marker[0]), 1.0, 1.0);
+				glTranslatef(-(this->settings->scope.horizontal.marker[0] + this->settings->scope.horizontal.marker[1]) / 2, 0.0, 0.0);
+			}
+			
+			// The digital phosphor is accumulated in a texture if possible
+			bool accumulate = this->settings->view.digitalPhosphor && (this->settings->scope.horizontal.format == Dso::GRAPHFORMAT_TY || this->settings->scope.horizontal.format == Dso::GRAPHFORMAT_XY) && this->accumulatePhosphor();
+			if(!accumulate && this->phosphorBuffer) {
+				delete this->phosphorBuffer;
+				this->phosphorBuffer = 0;
+			}
 			
-			case Dso::GRAPHFORMAT_XY:
-				// Real and virtual channels
-				for(int channel = 0; channel < this->settings->scope.voltage.count() - 1; channel += 2) {
-					if(this->settings->scope.voltage[channel].used) {
+			// Values we need for the fading of the digital phosphor
+			double *fadingFactor = new double[this->generator->digitalPhosphorDepth];
+			fadingFactor[0] = 100;
+			double fadingRatio = pow(10.0, 2.0 / this->generator->digitalPhosphorDepth);
+			for(int index = 1; index < this->generator->digitalPhosphorDepth; index++)
+				fadingFactor[index] = fadingFactor[index - 1] * fadingRatio;
+			
+			switch(this->settings->scope.horizontal.format) {
+				case Dso::GRAPHFORMAT_TY:
+				case Dso::GRAPHFORMAT_XY:
+					if(accumulate)
+						this->drawPhosphor();
+					else {
 						// Draw graph for all available depths
-						for(int index = this->generator->digitalPhosphorDepth - 1; index >= 0; index--) {
-							if(this->generator->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel][index]->data) {
-								this->qglColor(this->settings->view.color.screen.voltage[channel].darker(fadingFactor[index]));
-								glVertexPointer(2, GL_FLOAT, 0, this->generator->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel][index]->data);
-								glDrawArrays((this->settings->view.interpolation == Dso::INTERPOLATION_OFF) ? GL_POINTS : GL_LINE_STRIP, 0, this->generator->vaChannel[Dso::CHANNELMODE_VOLTAGE][channel][index]->getSize() / 2);
-							}
-						}
+						for(int index = this->generator->digitalPhosphorDepth - 1; index >= 0; index--)
+							this->drawGraphs(index, fadingFactor[index]);
 					}
-				}
-				break;
+					
+					if(this->settings->scope.horizontal.format == Dso::GRAPHFORMAT_TY) {
+						this->drawAnnotations();
+						this->drawMask();
+					}
+					break;
+				
+				case Dso::GRAPHFORMAT_EYE:
+					this->drawEyeDiagrams();
+					break;
+				
+				case Dso::GRAPHFORMAT_WATERFALL:
+					this->drawWaterfall();
+					break;
+				
+				default:
+					break;
+			}
 			
-			default:
-				break;
+			delete[] fadingFactor;
+			
+			glDisable(GL_POINT_SMOOTH);
+			glDisable(GL_LINE_SMOOTH);
+			
+			if(this->zoomed)
+				glPopMatrix();
 		}
 		
-		delete[] fadingFactor;
-		
-		glDisable(GL_POINT_SMOOTH);
-		glDisable(GL_LINE_SMOOTH);
-		
-		if(this->zoomed)
-			glPopMatrix();
+		this->generator->mutex()->unlock();
 	}
 	
 	if(!this->zoomed) {
@@ -158,15 +227,22 @@ void GlScope::paintGL() {
 		for(int marker = 0; marker < MARKER_COUNT; marker++) {
 			if(!this->vaMarker[marker].data) {
 				this->vaMarker[marker].setSize(2 * 2);
+				this->vaMarker[marker].data[0] = this->settings->scope.horizontal.marker[marker];
 				this->vaMarker[marker].data[1] = - DIVS_VOLTAGE;
+				this->vaMarker[marker].data[2] = this->settings->scope.horizontal.marker[marker];
 				this->vaMarker[marker].data[3] = DIVS_VOLTAGE;
 			}
 			
-			this->vaMarker[marker].data[0] = this->settings->scope.horizontal.marker[marker];
-			this->vaMarker[marker].data[2] = this->settings->scope.horizontal.marker[marker];
+			// Only upload the marker again if it was moved
+			if(this->vaMarker[marker].data[0] != (GLfloat) this->settings->scope.horizontal.marker[marker]) {
+				this->vaMarker[marker].data[0] = this->settings->scope.horizontal.marker[marker];
+				this->vaMarker[marker].data[2] = this->settings->scope.horizontal.marker[marker];
+				this->vaMarker[marker].invalidate();
+			}
 			
-			glVertexPointer(2, GL_FLOAT, 0, this->vaMarker[marker].data);
+			this->vaMarker[marker].bind();
 			glDrawArrays(GL_LINES, 0, this->vaMarker[marker].getSize() / 2);
+			this->vaMarker[marker].release();
 		}
 		
 		glDisable(GL_LINE_STIPPLE);
@@ -186,6 +262,10 @@ void GlScope::resizeGL(int width, int height) {
 	glLoadIdentity();
 	glOrtho(-DIVS_TIME / 2, DIVS_TIME / 2, -DIVS_VOLTAGE / 2, DIVS_VOLTAGE / 2, -1.0, 1.0);
 	glMatrixMode(GL_MODELVIEW);
+	
+	// The graphs for the zoomed scope are decimated to its width
+	if(this->zoomed && this->generator)
+		this->generator->zoomColumns = width;
 }
 
 /// \brief Set the generator that provides the vertex arrays.
@@ -197,10 +277,407 @@ void GlScope::setGenerator(GlGenerator *generator) {
 	connect(this->generator, SIGNAL(graphsGenerated()), this, SLOT(updateGL()));
 }
 
+/// \brief Restart the digital phosphor with the next drawn graphs.
+/// Has to be called after the view settings were changed, because the
+/// accumulated graphs were drawn with the old gain, offset, timebase or zoom.
+void GlScope::resetPhosphor() {
+	this->phosphorReset = true;
+}
+
 /// \brief Set the zoom mode for this GlScope.
 /// \param zoomed true magnifies the area between the markers.
 void GlScope::setZoomMode(bool zoomed) {
 	this->zoomed = zoomed;
+	if(this->zoomed && this->generator)
+		this->generator->zoomColumns = this->width();
+}
+
+/// \brief Draw the graphs of one digital phosphor depth.
+/// \param index The depth, 0 is the newest frame.
+/// \param fadingFactor The colors are darkened by this factor, see QColor::darker.
+/// \param weight The intensity of the graphs in the phosphor texture, 0 if they are drawn on the screen.
+void GlScope::drawGraphs(int index, double fadingFactor, double weight) {
+	int channelStep = 1;
+	int modeCount = Dso::CHANNELMODE_COUNT;
+	if(this->settings->scope.horizontal.format == Dso::GRAPHFORMAT_XY) {
+		// Only voltage graphs for even channels
+		channelStep = 2;
+		modeCount = Dso::CHANNELMODE_SPECTRUM;
+	}
+	
+	// Real and virtual channels
+	for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < modeCount; mode++) {
+		for(int channel = 0; channel < this->generator->vaChannel[mode].count(); channel += channelStep) {
+			if(!((mode == Dso::CHANNELMODE_VOLTAGE) ? this->settings->scope.voltage[channel].used : this->settings->scope.spectrum[channel].used) || index >= this->generator->vaChannel[mode][channel].count())
+				continue;
+			
+			GlArray *graph = this->generator->vaChannel[mode][channel][index];
+			if(!graph->data)
+				continue;
+			
+			QColor color = (mode == Dso::CHANNELMODE_VOLTAGE) ? this->settings->view.color.screen.voltage[channel] : this->settings->view.color.screen.spectrum[channel];
+			if(weight > 0)
+				glColor4d(color.redF(), color.greenF(), color.blueF(), color.alphaF() * weight);
+			else
+				this->qglColor(color.darker(fadingFactor));
+			
+			// The zoomed scope only draws the samples between the markers
+			unsigned long int first = 0;
+			unsigned long int count = graph->getVertexCount();
+			if(this->zoomed && this->settings->scope.horizontal.format == Dso::GRAPHFORMAT_TY) {
+				double base = (mode == Dso::CHANNELMODE_VOLTAGE) ? this->settings->scope.horizontal.timebase : this->settings->scope.horizontal.frequencybase;
+				count = GlGenerator::zoomSpan(this->settings, base / graph->interval, graph->getVertexCount(), &first);
+				if(!count)
+					continue;
+				
+				// Use the decimated graph if it was generated for the current markers
+				GlArray *decimated = this->generator->vaZoom[mode][channel];
+				if(index == 0 && decimated->data && decimated->spanFirst == first && decimated->spanCount == count) {
+					graph = decimated;
+					first = 0;
+					count = graph->getVertexCount();
+				}
+			}
+			
+			// The graphs contain samples, the view settings are applied while drawing
+			GLfloat scale[2], offset[2];
+			GlGenerator::graphTransform(this->settings, mode, channel, graph->interval, scale, offset);
+			
+			if(graph->getComponents() == 1) {
+				// Compact arrays are transformed by the shader
+				if(!this->graphProgram)
+					continue;
+				
+				// The shader only uses generic attributes
+				glDisableClientState(GL_VERTEX_ARRAY);
+				this->graphProgram->bind();
+				this->graphProgram->setUniformValue("scale", scale[0], scale[1]);
+				this->graphProgram->setUniformValue("offset", offset[0], offset[1]);
+				this->graphProgram->enableAttributeArray("index");
+				this->graphProgram->enableAttributeArray("value");
+				this->generator->vaIndex.bind(this->graphProgram, "index");
+				this->generator->vaIndex.release();
+				graph->bind(this->graphProgram, "value");
+				glDrawArrays((this->settings->view.interpolation == Dso::INTERPOLATION_OFF) ? GL_POINTS : GL_LINE_STRIP, first, count);
+				graph->release();
+				this->graphProgram->disableAttributeArray("index");
+				this->graphProgram->disableAttributeArray("value");
+				this->graphProgram->release();
+				glEnableClientState(GL_VERTEX_ARRAY);
+			}
+			else {
+				glPushMatrix();
+				glTranslatef(offset[0], offset[1], 0.0);
+				glScalef(scale[0], scale[1], 1.0);
+				graph->bind();
+				glDrawArrays((this->settings->view.interpolation == Dso::INTERPOLATION_OFF) ? GL_POINTS : GL_LINE_STRIP, first, count);
+				graph->release();
+				glPopMatrix();
+			}
+		}
+	}
+}
+
+/// \brief Draw the newest frame into the phosphor texture.
+/// The texture is faded once for every generated frame and the new graphs are
+/// added to it, so the drawing costs don't depend on the phosphor depth. Graphs
+/// that hit the same pixels more often get a higher intensity.
+/// \return false if framebuffer objects aren't supported.
+bool GlScope::accumulatePhosphor() {
+	if(!this->generator->phosphorTextures)
+		return false;
+	
+	// The history is lost if the widget was resized
+	if(this->phosphorBuffer && this->phosphorBuffer->size() != this->size()) {
+		delete this->phosphorBuffer;
+		this->phosphorBuffer = 0;
+	}
+	
+	if(!this->phosphorBuffer) {
+		if(!QGLFramebufferObject::hasOpenGLFramebufferObjects()) {
+			this->generator->phosphorTextures = false;
+			return false;
+		}
+		
+		// A float texture avoids rounding errors when fading, not every driver supports it as render target
+		this->phosphorBuffer = new QGLFramebufferObject(this->size(), QGLFramebufferObject::NoAttachment, GL_TEXTURE_2D, GL_RGBA16F_ARB);
+		this->phosphorRounded = !this->phosphorBuffer->isValid();
+		if(this->phosphorRounded) {
+			delete this->phosphorBuffer;
+			this->phosphorBuffer = new QGLFramebufferObject(this->size());
+			
+			// The 8 bit texture can only be faded completely with a subtraction
+			this->blendEquation = (GlBlendEquation) this->context()->getProcAddress("glBlendEquation");
+		}
+		if(!this->phosphorBuffer->isValid() || (this->phosphorRounded && !this->blendEquation)) {
+			delete this->phosphorBuffer;
+			this->phosphorBuffer = 0;
+			this->generator->phosphorTextures = false;
+			return false;
+		}
+		
+		this->phosphorReset = true;
+	}
+	
+	// Start again with the newest frame if the view settings were changed
+	if(this->phosphorReset) {
+		this->phosphorBuffer->bind();
+		glClearColor(0.0, 0.0, 0.0, 0.0);
+		glClear(GL_COLOR_BUFFER_BIT);
+		this->qglClearColor(this->settings->view.color.screen.background);
+		this->phosphorBuffer->release();
+		this->phosphorFrames = this->generator->frames - 1;
+		this->phosphorReset = false;
+	}
+	
+	// Nothing to do if there's no new frame, e.g. when a marker was moved
+	if(this->phosphorFrames == this->generator->frames)
+		return true;
+	
+	// The intensity fades to 1% within the phosphor depth
+	unsigned long int newFrames = qMin(this->generator->frames - this->phosphorFrames, (unsigned long int) this->settings->view.digitalPhosphorDepth);
+	double decay = pow(10.0, -2.0 / this->settings->view.digitalPhosphorDepth);
+	GLfloat fading = pow(decay, (double) newFrames);
+	
+	this->phosphorBuffer->bind();
+	
+	// Multiply the texture with the fading factor
+	glBlendFunc(GL_ZERO, GL_SRC_COLOR);
+	glColor4f(fading, fading, fading, fading);
+	glPushMatrix();
+	glLoadIdentity();
+	glRectf(-DIVS_TIME / 2, -DIVS_VOLTAGE / 2, DIVS_TIME / 2, DIVS_VOLTAGE / 2);
+	
+	// With 8 bits low intensities are rounded back to their old value, so every frame lowers them by one step too
+	if(this->phosphorRounded) {
+		GLfloat step = qMin(newFrames / 255.0, 1.0);
+		this->blendEquation(GL_FUNC_REVERSE_SUBTRACT);
+		glBlendFunc(GL_ONE, GL_ONE);
+		glColor4f(step, step, step, step);
+		glRectf(-DIVS_TIME / 2, -DIVS_VOLTAGE / 2, DIVS_TIME / 2, DIVS_VOLTAGE / 2);
+		this->blendEquation(GL_FUNC_ADD);
+	}
+	glPopMatrix();
+	
+	// Add the new graphs, a graph that is drawn every frame reaches full intensity
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+	this->drawGraphs(0, 0, 1.0 - decay);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	
+	this->phosphorBuffer->release();
+	this->phosphorFrames = this->generator->frames;
+	
+	return true;
+}
+
+/// \brief Read back the accumulated digital phosphor for exports.
+/// \return The phosphor texture, a null image if the phosphor isn't accumulated in a texture.
+QImage GlScope::phosphorImage() {
+	if(!this->phosphorBuffer)
+		return QImage();
+	
+	this->makeCurrent();
+	return this->phosphorBuffer->toImage();
+}
+
+/// \brief Add the phosphor texture to the screen.
+void GlScope::drawPhosphor() {
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, this->phosphorBuffer->texture());
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	glBlendFunc(GL_ONE, GL_ONE);
+	
+	// The texture already contains the zoomed graphs
+	glPushMatrix();
+	glLoadIdentity();
+	glBegin(GL_QUADS);
+	glTexCoord2f(0.0, 0.0);
+	glVertex2f(-DIVS_TIME / 2, -DIVS_VOLTAGE / 2);
+	glTexCoord2f(1.0, 0.0);
+	glVertex2f(DIVS_TIME / 2, -DIVS_VOLTAGE / 2);
+	glTexCoord2f(1.0, 1.0);
+	glVertex2f(DIVS_TIME / 2, DIVS_VOLTAGE / 2);
+	glTexCoord2f(0.0, 1.0);
+	glVertex2f(-DIVS_TIME / 2, DIVS_VOLTAGE / 2);
+	glEnd();
+	glPopMatrix();
+	
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+}
+
+/// \brief Draw the eye diagram histograms as intensity textures.
+void GlScope::drawEyeDiagrams() {
+	// Create the textures for new channels
+	while(this->eyeTextures.count() < this->generator->eyeChannel.count()) {
+		GLuint texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+		this->eyeTextures.append(texture);
+	}
+	
+	glEnable(GL_TEXTURE_2D);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	// The intensity is used as alpha value for the channel color
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	
+	for(int channel = 0; channel < this->generator->eyeChannel.count(); channel++) {
+		if(this->generator->eyeChannel[channel].isEmpty() || !this->settings->scope.voltage[channel].used)
+			continue;
+		
+		glBindTexture(GL_TEXTURE_2D, this->eyeTextures[channel]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, EYE_TIME_BINS, EYE_VOLTAGE_BINS, 0, GL_ALPHA, GL_UNSIGNED_BYTE, this->generator->eyeChannel[channel].constData());
+		
+		this->qglColor(this->settings->view.color.screen.voltage[channel]);
+		glBegin(GL_QUADS);
+		glTexCoord2f(0.0, 0.0);
+		glVertex2f(-DIVS_TIME / 2, -DIVS_VOLTAGE / 2);
+		glTexCoord2f(1.0, 0.0);
+		glVertex2f(DIVS_TIME / 2, -DIVS_VOLTAGE / 2);
+		glTexCoord2f(1.0, 1.0);
+		glVertex2f(DIVS_TIME / 2, DIVS_VOLTAGE / 2);
+		glTexCoord2f(0.0, 1.0);
+		glVertex2f(-DIVS_TIME / 2, DIVS_VOLTAGE / 2);
+		glEnd();
+	}
+	
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+}
+
+/// \brief Draw the spectrum history of each channel as scrolling texture.
+/// The texture is used as ring, only the rows generated since the last paint
+/// are uploaded and the texture coordinates are shifted to scroll it.
+void GlScope::drawWaterfall() {
+	// Create the textures for new channels
+	while(this->waterfallTextures.count() < this->generator->waterfallChannel.count()) {
+		GLuint texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		this->waterfallTextures.append(texture);
+		this->waterfallUploaded.append(0);
+	}
+	
+	// The channels share the screen height
+	int usedChannels = 0;
+	for(int channel = 0; channel < this->generator->waterfallChannel.count(); channel++) {
+		if(!this->generator->waterfallChannel[channel].isEmpty())
+			usedChannels++;
+	}
+	if(!usedChannels || !this->generator->waterfallRows)
+		return;
+	
+	glEnable(GL_TEXTURE_2D);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	
+	unsigned long int rows = this->generator->waterfallRows;
+	// The newest row is at the top, the oldest one at the bottom
+	GLfloat top = (GLfloat) (rows % WATERFALL_HISTORY) / WATERFALL_HISTORY;
+	GLfloat bottom = top - 1.0;
+	double bandHeight = DIVS_VOLTAGE / usedChannels;
+	int band = 0;
+	
+	for(int channel = 0; channel < this->generator->waterfallChannel.count(); channel++) {
+		if(this->generator->waterfallChannel[channel].isEmpty()) {
+			this->waterfallUploaded[channel] = 0;
+			continue;
+		}
+		
+		const char *ring = this->generator->waterfallChannel[channel].constData();
+		glBindTexture(GL_TEXTURE_2D, this->waterfallTextures[channel]);
+		if(!this->waterfallUploaded[channel] || this->waterfallUploaded[channel] > rows || rows - this->waterfallUploaded[channel] >= WATERFALL_HISTORY) {
+			// Upload the whole ring if the history isn't in the texture yet
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, WATERFALL_WIDTH, WATERFALL_HISTORY, 0, GL_RGB, GL_UNSIGNED_BYTE, ring);
+		}
+		else {
+			// Otherwise only the new rows are uploaded
+			for(unsigned long int row = this->waterfallUploaded[channel]; row < rows; row++) {
+				int ringRow = row % WATERFALL_HISTORY;
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, ringRow, WATERFALL_WIDTH, 1, GL_RGB, GL_UNSIGNED_BYTE, ring + ringRow * WATERFALL_WIDTH * 3);
+			}
+		}
+		this->waterfallUploaded[channel] = rows;
+		
+		GLfloat bandTop = DIVS_VOLTAGE / 2 - band * bandHeight;
+		GLfloat bandBottom = bandTop - bandHeight;
+		glBegin(GL_QUADS);
+		glTexCoord2f(0.0, bottom);
+		glVertex2f(-DIVS_TIME / 2, bandBottom);
+		glTexCoord2f(1.0, bottom);
+		glVertex2f(DIVS_TIME / 2, bandBottom);
+		glTexCoord2f(1.0, top);
+		glVertex2f(DIVS_TIME / 2, bandTop);
+		glTexCoord2f(0.0, top);
+		glVertex2f(-DIVS_TIME / 2, bandTop);
+		glEnd();
+		band++;
+	}
+	
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+}
+
+/// \brief Draw the words of the protocol decoder below the graphs.
+void GlScope::drawAnnotations() {
+	if(this->generator->annotations.isEmpty())
+		return;
+	
+	// Pixels per div, the zoomed scope is magnified horizontally
+	double pixelsPerDiv = this->width() / DIVS_TIME;
+	if(this->zoomed)
+		pixelsPerDiv *= DIVS_TIME / fabs(this->settings->scope.horizontal.marker[1] - this->settings->scope.horizontal.marker[0]);
+	QFontMetrics fontMetrics(this->font());
+	
+	double bottom = -DIVS_VOLTAGE / 2 + 0.1;
+	double top = bottom + 0.5;
+	
+	for(int index = 0; index < this->generator->annotations.count(); index++) {
+		const DecoderAnnotation &annotation = this->generator->annotations[index];
+		double left = annotation.start / this->settings->scope.horizontal.timebase - DIVS_TIME / 2;
+		double right = annotation.end / this->settings->scope.horizontal.timebase - DIVS_TIME / 2;
+		if(right < -DIVS_TIME / 2 || left > DIVS_TIME / 2)
+			continue;
+		
+		// Frame the word, malformed words are framed red
+		if(annotation.error)
+			this->qglColor(Qt::red);
+		else
+			this->qglColor(this->settings->view.color.screen.markers);
+		glBegin(GL_LINE_LOOP);
+		glVertex2f(left, bottom);
+		glVertex2f(right, bottom);
+		glVertex2f(right, top);
+		glVertex2f(left, top);
+		glEnd();
+		
+		// Only label the word if the text fits into the frame
+		if(annotation.start == annotation.end || (right - left) * pixelsPerDiv > fontMetrics.width(annotation.text) + 4) {
+			this->qglColor(this->settings->view.color.screen.text);
+			this->renderText(left + 2 / pixelsPerDiv, bottom + 0.1, 0.0, annotation.text);
+		}
+	}
+}
+
+/// \brief Draw the outline of the pass/fail mask.
+void GlScope::drawMask() {
+	if(!this->settings->scope.mask.enabled || this->settings->scope.mask.polygon.count() < 2)
+		return;
+	
+	this->qglColor(this->settings->view.color.screen.markers);
+	glBegin(GL_LINE_LOOP);
+	for(int point = 0; point < this->settings->scope.mask.polygon.count(); point++)
+		glVertex2f(this->settings->scope.mask.polygon[point].x(), this->settings->scope.mask.polygon[point].y());
+	glEnd();
 }
 
 /// \brief Draw the grid.
@@ -210,14 +687,17 @@ void GlScope::drawGrid() {
 	
 	// Grid
 	this->qglColor(this->settings->view.color.screen.grid);
-	glVertexPointer(2, GL_FLOAT, 0, this->generator->vaGrid[0].data);
+	this->generator->vaGrid[0].bind();
 	glDrawArrays(GL_POINTS, 0, this->generator->vaGrid[0].getSize() / 2);
+	this->generator->vaGrid[0].release();
 	// Axes
 	this->qglColor(this->settings->view.color.screen.axes);
-	glVertexPointer(2, GL_FLOAT, 0, this->generator->vaGrid[1].data);
+	this->generator->vaGrid[1].bind();
 	glDrawArrays(GL_LINES, 0, this->generator->vaGrid[1].getSize() / 2);
+	this->generator->vaGrid[1].release();
 	// Border
 	this->qglColor(this->settings->view.color.screen.border);
-	glVertexPointer(2, GL_FLOAT, 0, this->generator->vaGrid[2].data);
+	this->generator->vaGrid[2].bind();
 	glDrawArrays(GL_LINE_LOOP, 0, this->generator->vaGrid[2].getSize() / 2);
+	this->generator->vaGrid[2].release();
 }
@@ -36,6 +36,24 @@
 #include "dso.h"
 
 
+#ifndef GL_RGBA16F_ARB
+#define GL_RGBA16F_ARB           0x881A ///< Half float texture format of ARB_texture_float
+#endif
+#ifndef GL_FUNC_ADD
+#define GL_FUNC_ADD              0x8006 ///< Default blend equation of OpenGL 1.4
+#endif
+#ifndef GL_FUNC_REVERSE_SUBTRACT
+#define GL_FUNC_REVERSE_SUBTRACT 0x800B ///< Subtracting blend equation of OpenGL 1.4
+#endif
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+
+/// \brief Pointer to glBlendEquation, older OpenGL headers don't declare it.
+typedef void (APIENTRY *GlBlendEquation)(GLenum mode);
+
+
 class DataAnalyzer;
 class DsoSettings;
 
@@ -47,11 +65,13 @@ class GlScope : public QGLWidget {
 	Q_OBJECT
 	
 	public:
-		GlScope(DsoSettings *settings, QWidget* parent = 0);
+		GlScope(DsoSettings *settings, QWidget* parent = 0, const QGLWidget *shareWidget = 0);
 		~GlScope();
 		
 		void setGenerator(GlGenerator *generator);
 		void setZoomMode(bool zoomed);
+		void resetPhosphor();
+		QImage phosphorImage();
 	
 	protected:
 		void initializeGL();
@@ -59,13 +79,30 @@ class GlScope : public QGLWidget {
 		void resizeGL(int width, int height);
 		
 		void drawGrid();
+		void drawGraphs(int index, double fadingFactor, double weight = 0);
+		bool accumulatePhosphor();
+		void drawPhosphor();
+		void drawEyeDiagrams();
+		void drawWaterfall();
+		void drawAnnotations();
+		void drawMask();
 	
 	private:
 		GlGenerator *generator;
 		DsoSettings *settings;
 		
 		GlArray vaMarker[2];
+		QList<GLuint> eyeTextures; ///< The eye diagram texture for each channel
+		QList<GLuint> waterfallTextures; ///< The waterfall texture ring for each channel
+		QList<unsigned long int> waterfallUploaded; ///< Rows of the ring already in the texture
 		bool zoomed;
+		
+		QGLShaderProgram *graphProgram; ///< Transforms the compact arrays, 0 if shaders aren't supported
+		QGLFramebufferObject *phosphorBuffer; ///< Accumulates the graphs for the digital phosphor
+		unsigned long int phosphorFrames; ///< The number of generated frames when the phosphor was updated
+		bool phosphorReset; ///< true if the phosphor has to be cleared before the next frame
+		bool phosphorRounded; ///< true if the phosphor texture only has 8 bits per color
+		GlBlendEquation blendEquation; ///< glBlendEquation of the context, 0 if not supported
 };
 
 
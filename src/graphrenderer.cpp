@@ -0,0 +1,305 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  graphrenderer.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+#include <cstring>
+
+#include <QImage>
+#include <QMutex>
+#include <QPainter>
+#include <QVector>
+
+
+#include "graphrenderer.h"
+
+#include "eyediagram.h"
+#include "glgenerator.h"
+#include "settings.h"
+
+
+/// \brief Append the reduced points of a column to a graph.
+/// \param points The points of the graph.
+/// \param column The first, lowest, highest and last point of the column.
+static void appendColumn(QVector<QPointF> *points, QPointF *column) {
+	// Keep the original order of the lowest and highest point
+	if(column[2].x() < column[1].x())
+		qSwap(column[1], column[2]);
+	
+	for(int index = 0; index < 4; index++) {
+		if(points->isEmpty() || points->last() != column[index])
+			points->append(column[index]);
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class GraphRenderer
+/// \brief Initializes the renderer.
+/// \param settings The settings that should be used.
+/// \param generator The generator whose graphs should be drawn.
+GraphRenderer::GraphRenderer(DsoSettings *settings, GlGenerator *generator) {
+	this->settings = settings;
+	this->generator = generator;
+}
+
+/// \brief Cleans up.
+GraphRenderer::~GraphRenderer() {
+}
+
+/// \brief Draw the current graphs.
+/// \param painter The painter that should be used, its matrix is ignored.
+/// \param screen The screen area in device coordinates.
+/// \param zoomed true draws the magnified area between the markers.
+/// \param colorValues The colors for the graphs.
+/// \param columnWidth The width of the columns TY graphs are reduced to in device units.
+/// \param phosphor The digital phosphor texture of the GlScope, if it accumulates one.
+void GraphRenderer::draw(QPainter *painter, const QRectF &screen, bool zoomed, const DsoSettingsColorValues *colorValues, double columnWidth, const QImage &phosphor) {
+	painter->save();
+	painter->setMatrix(QMatrix());
+	painter->setClipRect(screen);
+	painter->setRenderHint(QPainter::Antialiasing, this->settings->view.antialiasing);
+	painter->setBrush(Qt::NoBrush);
+	
+	this->generator->mutex()->lock();
+	
+	switch(this->settings->scope.horizontal.format) {
+		case Dso::GRAPHFORMAT_TY:
+		case Dso::GRAPHFORMAT_XY:
+			this->drawGraphs(painter, screen, zoomed, colorValues, columnWidth, phosphor);
+			break;
+		
+		case Dso::GRAPHFORMAT_EYE:
+			this->drawEyeDiagrams(painter, screen, zoomed, colorValues);
+			break;
+		
+		case Dso::GRAPHFORMAT_WATERFALL:
+			this->drawWaterfall(painter, screen, zoomed);
+			break;
+		
+		default:
+			break;
+	}
+	
+	this->generator->mutex()->unlock();
+	
+	painter->restore();
+}
+
+/// \brief Draw the graphs of all digital phosphor depths.
+/// If the scope accumulates the digital phosphor in a texture, the generator
+/// only keeps the newest graphs. These are drawn over the texture then.
+/// \param painter The painter that should be used.
+/// \param screen The screen area in device coordinates.
+/// \param zoomed true draws the magnified area between the markers.
+/// \param colorValues The colors for the graphs.
+/// \param columnWidth The width of the columns TY graphs are reduced to.
+/// \param phosphor The digital phosphor texture, a null image if there is none.
+void GraphRenderer::drawGraphs(QPainter *painter, const QRectF &screen, bool zoomed, const DsoSettingsColorValues *colorValues, double columnWidth, const QImage &phosphor) {
+	// The texture covers the screen like on the GlScope
+	if(!phosphor.isNull() && this->settings->view.digitalPhosphor) {
+		painter->save();
+		painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+		painter->drawImage(QRectF(this->toDevice(screen, zoomed, -DIVS_TIME / 2, DIVS_VOLTAGE / 2), this->toDevice(screen, zoomed, DIVS_TIME / 2, -DIVS_VOLTAGE / 2)), phosphor);
+		painter->restore();
+	}
+	
+	int channelStep = 1;
+	int modeCount = Dso::CHANNELMODE_COUNT;
+	if(this->settings->scope.horizontal.format == Dso::GRAPHFORMAT_XY) {
+		// Only voltage graphs for even channels
+		channelStep = 2;
+		modeCount = Dso::CHANNELMODE_SPECTRUM;
+	}
+	
+	// The older graphs are darkened like on the screen
+	int depth = this->generator->digitalPhosphorDepth;
+	double fadingRatio = pow(10.0, 2.0 / qMax(depth, 1));
+	
+	for(int index = depth - 1; index >= 0; index--) {
+		double fadingFactor = 100 * pow(fadingRatio, index);
+		
+		for(int mode = Dso::CHANNELMODE_VOLTAGE; mode < modeCount; mode++) {
+			for(int channel = 0; channel < this->generator->vaChannel[mode].count(); channel += channelStep) {
+				if(!((mode == Dso::CHANNELMODE_VOLTAGE) ? this->settings->scope.voltage[channel].used : this->settings->scope.spectrum[channel].used) || index >= this->generator->vaChannel[mode][channel].count())
+					continue;
+				
+				GlArray *graph = this->generator->vaChannel[mode][channel][index];
+				if(!graph->data)
+					continue;
+				
+				QColor color = (mode == Dso::CHANNELMODE_VOLTAGE) ? colorValues->voltage[channel] : colorValues->spectrum[channel];
+				painter->setPen(color.darker(fadingFactor));
+				this->drawGraph(painter, screen, zoomed, graph, mode, channel, columnWidth);
+			}
+		}
+	}
+}
+
+/// \brief Draw one graph.
+/// \param painter The painter that should be used.
+/// \param screen The screen area in device coordinates.
+/// \param zoomed true draws the magnified area between the markers.
+/// \param graph The array with the graph.
+/// \param mode The Dso::ChannelMode of the graph.
+/// \param channel The channel of the graph.
+/// \param columnWidth The width of the columns TY graphs are reduced to.
+void GraphRenderer::drawGraph(QPainter *painter, const QRectF &screen, bool zoomed, GlArray *graph, int mode, int channel, double columnWidth) {
+	bool ty = this->settings->scope.horizontal.format == Dso::GRAPHFORMAT_TY;
+	
+	// The zoomed scope only draws the samples between the markers
+	unsigned long int first = 0;
+	unsigned long int count = graph->getVertexCount();
+	if(zoomed && ty) {
+		double base = (mode == Dso::CHANNELMODE_VOLTAGE) ? this->settings->scope.horizontal.timebase : this->settings->scope.horizontal.frequencybase;
+		count = GlGenerator::zoomSpan(this->settings, base / graph->interval, graph->getVertexCount(), &first);
+	}
+	if(!count)
+		return;
+	
+	GLfloat scale[2], offset[2];
+	GlGenerator::graphTransform(this->settings, mode, channel, graph->interval, scale, offset);
+	
+	// Points have to be drawn all, lines are reduced to the columns
+	bool reduce = ty && this->settings->view.interpolation != Dso::INTERPOLATION_OFF;
+	QPointF column[4];
+	bool columnUsed = false;
+	int columnIndex = 0;
+	
+	QVector<QPointF> points;
+	for(unsigned long int vertex = first; vertex < first + count; vertex++) {
+		double position, value;
+		if(graph->getComponents() == 1) {
+			position = vertex;
+			value = graph->data[vertex];
+		}
+		else {
+			position = graph->data[vertex * 2];
+			value = graph->data[vertex * 2 + 1];
+		}
+		QPointF point = this->toDevice(screen, zoomed, position * scale[0] + offset[0], value * scale[1] + offset[1]);
+		
+		if(!reduce) {
+			points.append(point);
+			continue;
+		}
+		
+		int pointColumn = (int) floor(point.x() / columnWidth);
+		if(columnUsed && pointColumn == columnIndex) {
+			if(point.y() < column[1].y())
+				column[1] = point;
+			if(point.y() > column[2].y())
+				column[2] = point;
+			column[3] = point;
+			continue;
+		}
+		
+		if(columnUsed)
+			appendColumn(&points, column);
+		for(int index = 0; index < 4; index++)
+			column[index] = point;
+		columnIndex = pointColumn;
+		columnUsed = true;
+	}
+	if(columnUsed)
+		appendColumn(&points, column);
+	
+	if(this->settings->view.interpolation == Dso::INTERPOLATION_OFF)
+		painter->drawPoints(points.constData(), points.count());
+	else
+		painter->drawPolyline(points.constData(), points.count());
+}
+
+/// \brief Draw the eye diagrams with the intensity as alpha value.
+/// \param painter The painter that should be used.
+/// \param screen The screen area in device coordinates.
+/// \param zoomed true draws the magnified area between the markers.
+/// \param colorValues The colors for the graphs.
+void GraphRenderer::drawEyeDiagrams(QPainter *painter, const QRectF &screen, bool zoomed, const DsoSettingsColorValues *colorValues) {
+	for(int channel = 0; channel < this->generator->eyeChannel.count(); channel++) {
+		if(this->generator->eyeChannel[channel].isEmpty() || !this->settings->scope.voltage[channel].used)
+			continue;
+		
+		const unsigned char *intensity = (const unsigned char *) this->generator->eyeChannel[channel].constData();
+		QImage eyeImage(EYE_TIME_BINS, EYE_VOLTAGE_BINS, QImage::Format_ARGB32);
+		QColor color = colorValues->voltage[channel];
+		for(int row = 0; row < EYE_VOLTAGE_BINS; row++) {
+			// The first row of the histogram is at the bottom
+			QRgb *line = (QRgb *) eyeImage.scanLine(EYE_VOLTAGE_BINS - 1 - row);
+			for(int column = 0; column < EYE_TIME_BINS; column++)
+				line[column] = qRgba(color.red(), color.green(), color.blue(), intensity[row * EYE_TIME_BINS + column] * color.alpha() / 255);
+		}
+		
+		painter->drawImage(QRectF(this->toDevice(screen, zoomed, -DIVS_TIME / 2, DIVS_VOLTAGE / 2), this->toDevice(screen, zoomed, DIVS_TIME / 2, -DIVS_VOLTAGE / 2)), eyeImage);
+	}
+}
+
+/// \brief Draw the spectrum history of each channel, the newest row at the top.
+/// \param painter The painter that should be used.
+/// \param screen The screen area in device coordinates.
+/// \param zoomed true draws the magnified area between the markers.
+void GraphRenderer::drawWaterfall(QPainter *painter, const QRectF &screen, bool zoomed) {
+	// The channels share the screen height
+	int usedChannels = 0;
+	for(int channel = 0; channel < this->generator->waterfallChannel.count(); channel++) {
+		if(!this->generator->waterfallChannel[channel].isEmpty())
+			usedChannels++;
+	}
+	unsigned long int rows = this->generator->waterfallRows;
+	if(!usedChannels || !rows)
+		return;
+	
+	double bandHeight = DIVS_VOLTAGE / usedChannels;
+	int band = 0;
+	
+	QImage waterfallImage(WATERFALL_WIDTH, WATERFALL_HISTORY, QImage::Format_RGB888);
+	for(int channel = 0; channel < this->generator->waterfallChannel.count(); channel++) {
+		if(this->generator->waterfallChannel[channel].isEmpty())
+			continue;
+		
+		const char *ring = this->generator->waterfallChannel[channel].constData();
+		for(int line = 0; line < WATERFALL_HISTORY; line++) {
+			unsigned long int ringRow = (rows + WATERFALL_HISTORY - 1 - line) % WATERFALL_HISTORY;
+			memcpy(waterfallImage.scanLine(line), ring + ringRow * WATERFALL_WIDTH * 3, WATERFALL_WIDTH * 3);
+		}
+		
+		double bandTop = DIVS_VOLTAGE / 2 - band * bandHeight;
+		painter->drawImage(QRectF(this->toDevice(screen, zoomed, -DIVS_TIME / 2, bandTop), this->toDevice(screen, zoomed, DIVS_TIME / 2, bandTop - bandHeight)), waterfallImage);
+		band++;
+	}
+}
+
+/// \brief Convert screen coordinates into device coordinates.
+/// \param screen The screen area in device coordinates.
+/// \param zoomed true magnifies the area between the markers.
+/// \param x The horizontal position in divs.
+/// \param y The vertical position in divs.
+/// \return The position on the paint device.
+QPointF GraphRenderer::toDevice(const QRectF &screen, bool zoomed, double x, double y) const {
+	if(zoomed) {
+		double divs = fabs(this->settings->scope.horizontal.marker[1] - this->settings->scope.horizontal.marker[0]);
+		x = (x - (this->settings->scope.horizontal.marker[0] + this->settings->scope.horizontal.marker[1]) / 2) * DIVS_TIME / divs;
+	}
+	
+	return QPointF(screen.left() + (x / DIVS_TIME + 0.5) * screen.width(), screen.top() + (0.5 - y / DIVS_VOLTAGE) * screen.height());
+}
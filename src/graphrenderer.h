@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file graphrenderer.h
+/// \brief Declares the GraphRenderer class.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef GRAPHRENDERER_H
+#define GRAPHRENDERER_H
+
+
+#include <QImage>
+#include <QPointF>
+#include <QRectF>
+
+
+class DsoSettings;
+class GlArray;
+class GlGenerator;
+class QPainter;
+struct DsoSettingsColorValues;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class GraphRenderer                                         graphrenderer.h
+/// \brief Draws the graphs of the GlGenerator with a QPainter.
+/// Used for exports, it doesn't need OpenGL or a display. The graphs are drawn
+/// like on the GlScope, but TY graphs are reduced to the first, lowest, highest
+/// and last point of every column before they are drawn. The columns are one
+/// device pixel wide for images and wider for high resolution printers, so the
+/// number of points depends on the resolution and not on the sample count.
+class GraphRenderer {
+	public:
+		GraphRenderer(DsoSettings *settings, GlGenerator *generator);
+		~GraphRenderer();
+		
+		void draw(QPainter *painter, const QRectF &screen, bool zoomed, const DsoSettingsColorValues *colorValues, double columnWidth = 1, const QImage &phosphor = QImage());
+	
+	protected:
+		void drawGraphs(QPainter *painter, const QRectF &screen, bool zoomed, const DsoSettingsColorValues *colorValues, double columnWidth, const QImage &phosphor);
+		void drawGraph(QPainter *painter, const QRectF &screen, bool zoomed, GlArray *graph, int mode, int channel, double columnWidth);
+		void drawEyeDiagrams(QPainter *painter, const QRectF &screen, bool zoomed, const DsoSettingsColorValues *colorValues);
+		void drawWaterfall(QPainter *painter, const QRectF &screen, bool zoomed);
+		QPointF toDevice(const QRectF &screen, bool zoomed, double x, double y) const;
+		
+		DsoSettings *settings; ///< The settings provided by the parent class
+		GlGenerator *generator; ///< The generator whose graphs are drawn
+};
+
+
+#endif
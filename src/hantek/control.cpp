@@ -113,6 +113,12 @@ namespace Hantek {
 		return HANTEK_CHANNELS;
 	}
 	
+	/// \brief Gets the name of the connected oscilloscope model.
+	/// \returns The model name, an empty string if no device is connected.
+	QString Control::getModelName() {
+		return this->device->getModelName();
+	}
+	
 	/// \brief Handles all USB things until the device gets disconnected.
 	void Control::run() {
 		int errorCode, cycleCounter = 0, startCycle = 0;
@@ -63,6 +63,7 @@ namespace Hantek {
 			~Control();
 			
 			unsigned int getChannelCount();
+			QString getModelName();
 		
 		protected:
 			void run();
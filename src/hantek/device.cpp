@@ -484,4 +484,13 @@ namespace Hantek {
 	Model Device::getModel() {
 		return this->model;
 	}
+	
+	/// \brief Get the name of the oscilloscope model.
+	/// \return The name of the connected Hantek DSO, empty if it's unknown.
+	QString Device::getModelName() {
+		if(this->model <= MODEL_UNKNOWN || this->model >= MODEL_COUNT)
+			return QString();
+		
+		return this->modelStrings[this->model];
+	}
 }
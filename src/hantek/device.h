@@ -76,6 +76,7 @@ namespace Hantek {
 			
 			int getConnectionSpeed();
 			Model getModel();
+			QString getModelName();
 		
 		protected:
 			// Lists for enums
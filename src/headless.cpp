@@ -0,0 +1,505 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  headless.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <clocale>
+#include <cstdio>
+#include <cstring>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QMutex>
+#include <QStringList>
+#include <QTimer>
+
+
+#include "headless.h"
+
+#include "capturefile.h"
+#include "csvwriter.h"
+#include "dataanalyzer.h"
+#include "dso.h"
+#include "dsocontrol.h"
+#include "framepublisher.h"
+#include "scopeserver.h"
+#include "settings.h"
+#include "hantek/control.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class HeadlessScope
+/// \brief Initializes the acquisition, the device is connected by start().
+/// \param parent The parent object.
+HeadlessScope::HeadlessScope(QObject *parent) : QObject(parent) {
+	this->settings = 0;
+	this->dsoControl = 0;
+	this->dataAnalyzer = 0;
+	
+	this->format = HEADLESS_FORMAT_NONE;
+	this->frameLimit = 0;
+	this->durationLimit = 0;
+	this->serverEnabled = false;
+	this->ringEnabled = false;
+	
+	this->csvWriter = 0;
+	this->captureOutput = 0;
+	this->record = 0;
+	this->measurementsOutput = 0;
+	this->scopeServer = 0;
+	this->framePublisher = 0;
+	
+	this->frames = 0;
+	this->durationTimer = new QTimer(this);
+	this->durationTimer->setSingleShot(true);
+	this->complete = false;
+	this->finished = false;
+	
+	connect(this->durationTimer, SIGNAL(timeout()), this, SLOT(durationReached()));
+}
+
+/// \brief Closes the outputs and cleans up.
+HeadlessScope::~HeadlessScope() {
+	delete this->scopeServer;
+	delete this->framePublisher;
+	delete this->csvWriter;
+	delete this->captureOutput;
+	delete this->measurementsOutput;
+	delete this->record;
+	
+	delete this->dataAnalyzer;
+	delete this->dsoControl;
+	delete this->settings;
+}
+
+/// \brief Connects the oscilloscope and starts the acquisition.
+/// \param arguments The command line arguments of the application.
+/// \return The exit code if the program should end, -1 if the acquisition is running.
+int HeadlessScope::start(const QStringList &arguments) {
+	if(arguments.contains("--help")) {
+		this->printUsage();
+		return 0;
+	}
+	if(!this->parseArguments(arguments))
+		return 1;
+	
+	// Use the same settings as the main window by default
+	QCoreApplication::setOrganizationName("paranoiacs.net");
+	QCoreApplication::setOrganizationDomain("paranoiacs.net");
+	QCoreApplication::setApplicationName("OpenHantek");
+	
+	this->dsoControl = new Hantek::Control();
+	connect(this->dsoControl, SIGNAL(statusMessage(QString, int)), this, SLOT(printMessage(QString, int)));
+	
+	this->settings = new DsoSettings();
+	this->settings->setChannelCount(this->dsoControl->getChannelCount());
+	if(!this->settingsFile.isEmpty() && !QFile::exists(this->settingsFile)) {
+		this->printMessage(tr("The settings file %1 doesn't exist").arg(this->settingsFile), 0);
+		return 1;
+	}
+	if(this->settings->load(this->settingsFile) < 0) {
+		this->printMessage(tr("Can't read the settings"), 0);
+		return 1;
+	}
+	
+	this->dataAnalyzer = new DataAnalyzer(this->settings);
+	
+	// Open the outputs before the oscilloscope is connected
+	switch(this->format) {
+		case HEADLESS_FORMAT_CSV:
+			this->csvWriter = new CsvWriter(this->settings, this->dataAnalyzer);
+			if(!this->csvWriter->open(this->framesFile)) {
+				this->printMessage(tr("Can't create %1").arg(this->framesFile), 0);
+				return 1;
+			}
+			break;
+		case HEADLESS_FORMAT_CAPTURE:
+			this->captureOutput = HeadlessScope::openOutput(this->framesFile, QIODevice::WriteOnly);
+			if(!this->captureOutput) {
+				this->printMessage(tr("Can't create %1").arg(this->framesFile), 0);
+				return 1;
+			}
+			this->record = new CaptureRecord;
+			break;
+		default:
+			break;
+	}
+	
+	if(!this->measurementsFile.isEmpty()) {
+		this->measurementsOutput = HeadlessScope::openOutput(this->measurementsFile, QIODevice::WriteOnly | QIODevice::Text);
+		if(!this->measurementsOutput) {
+			this->printMessage(tr("Can't create %1").arg(this->measurementsFile), 0);
+			return 1;
+		}
+		
+		// The header names the columns of the used voltage channels
+		QByteArray header("frame\ttime / s");
+		for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
+			if(!this->settings->scope.voltage[channel].used)
+				continue;
+			
+			QByteArray name = this->settings->scope.voltage[channel].name.toUtf8();
+			header += '\t' + name + " amplitude / V\t" + name + " frequency / Hz";
+		}
+		header += '\n';
+		if(this->measurementsOutput->write(header) != header.size() || !this->measurementsOutput->flush()) {
+			this->printMessage(tr("Can't write %1").arg(this->measurementsFile), 0);
+			return 1;
+		}
+	}
+	
+	// Without the docks the clients can only query the settings
+	if(this->serverEnabled) {
+		this->scopeServer = new ScopeServer(this->settings, this->dataAnalyzer);
+		connect(this->scopeServer, SIGNAL(statusMessage(QString, int)), this, SLOT(printMessage(QString, int)));
+		if(this->settings->options.server.name.isEmpty() && !this->settings->options.server.port) {
+			this->printMessage(tr("Neither a socket name nor a TCP port is configured for the server"), 0);
+			return 1;
+		}
+		if(!this->scopeServer->listen(this->settings->options.server.name, this->settings->options.server.port))
+			return 1;
+	}
+	
+	if(this->ringEnabled) {
+		this->framePublisher = new FramePublisher(this->settings, this->dataAnalyzer);
+		connect(this->framePublisher, SIGNAL(statusMessage(QString, int)), this, SLOT(printMessage(QString, int)));
+		if(!this->framePublisher->open(this->settings->options.ring.name, this->settings->options.ring.slotCount, (quint64) this->settings->options.ring.slotSize << 20))
+			return 1;
+	}
+	
+	// The control thread is only started if a device was found
+	this->dsoControl->connectDevice();
+	if(!this->dsoControl->isRunning())
+		return 1;
+	this->settings->scope.model = this->dsoControl->getModelName();
+	this->setupDevice();
+	
+	connect(this->dsoControl, SIGNAL(samplesAvailable(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)), this->dataAnalyzer, SLOT(analyze(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)));
+	// Every frame has to be written before the analyzer overwrites it
+	connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this, SLOT(analyzed(unsigned int)), Qt::DirectConnection);
+	connect(this->dsoControl, SIGNAL(finished()), this, SLOT(deviceStopped()));
+	if(this->framePublisher)
+		connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this->framePublisher, SLOT(publish()), Qt::DirectConnection);
+	if(this->scopeServer) {
+		connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this->scopeServer, SLOT(analyzed(unsigned int)));
+		connect(this->dsoControl, SIGNAL(samplingStarted()), this->scopeServer, SLOT(samplingStarted()));
+		connect(this->dsoControl, SIGNAL(samplingStopped()), this->scopeServer, SLOT(samplingStopped()));
+		connect(this->scopeServer, SIGNAL(startRequested()), this->dsoControl, SLOT(startSampling()));
+		connect(this->scopeServer, SIGNAL(stopRequested()), this->dsoControl, SLOT(stopSampling()));
+	}
+	
+	this->elapsed.start();
+	if(this->durationLimit > 0)
+		this->durationTimer->start((int) qMin(this->durationLimit * 1000, 2147483647.0));
+	this->dsoControl->startSampling();
+	
+	return -1;
+}
+
+/// \brief Checks if the command line mode was requested.
+/// \param argc The number of command line arguments.
+/// \param argv The command line arguments.
+/// \return true if the application should run without the graphical interface.
+bool HeadlessScope::requested(int argc, char *argv[]) {
+	for(int argument = 1; argument < argc; argument++) {
+		if(!strcmp(argv[argument], "--cli"))
+			return true;
+	}
+	
+	return false;
+}
+
+/// \brief Reads the options from the command line.
+/// \param arguments The command line arguments of the application.
+/// \return false if the arguments are invalid.
+bool HeadlessScope::parseArguments(const QStringList &arguments) {
+	QStringList valueOptions;
+	valueOptions << "--settings" << "--frames" << "--duration" << "--output" << "--format" << "--measurements";
+	
+	bool measurementsSet = false;
+	for(int index = 1; index < arguments.count(); index++) {
+		QString option = arguments[index];
+		if(option == "--cli")
+			continue;
+		if(option == "--server") {
+			this->serverEnabled = true;
+			continue;
+		}
+		if(option == "--ring") {
+			this->ringEnabled = true;
+			continue;
+		}
+		
+		if(!valueOptions.contains(option)) {
+			this->printMessage(tr("Unknown option %1, see --help").arg(option), 0);
+			return false;
+		}
+		if(index + 1 >= arguments.count()) {
+			this->printMessage(tr("The option %1 needs a value").arg(option), 0);
+			return false;
+		}
+		QString value = arguments[++index];
+		
+		bool valid = true;
+		if(option == "--settings")
+			this->settingsFile = value;
+		else if(option == "--frames")
+			this->frameLimit = value.toULong(&valid);
+		else if(option == "--duration") {
+			this->durationLimit = value.toDouble(&valid);
+			valid = valid && this->durationLimit >= 0;
+		}
+		else if(option == "--output")
+			this->framesFile = value;
+		else if(option == "--format") {
+			if(value == "csv")
+				this->format = HEADLESS_FORMAT_CSV;
+			else if(value == "ohc")
+				this->format = HEADLESS_FORMAT_CAPTURE;
+			else
+				valid = false;
+		}
+		else {
+			this->measurementsFile = value;
+			measurementsSet = true;
+		}
+		
+		if(!valid) {
+			this->printMessage(tr("Invalid value %1 for the option %2").arg(value, option), 0);
+			return false;
+		}
+	}
+	
+	// Guess the format from the file name
+	if(this->framesFile.isEmpty())
+		this->format = HEADLESS_FORMAT_NONE;
+	else if(this->format == HEADLESS_FORMAT_NONE)
+		this->format = this->framesFile.endsWith(".ohc", Qt::CaseInsensitive) ? HEADLESS_FORMAT_CAPTURE : HEADLESS_FORMAT_CSV;
+	
+	// The measurements go to the standard output unless the frames use it
+	if(!measurementsSet && this->framesFile != "-")
+		this->measurementsFile = "-";
+	if(this->framesFile == "-" && this->measurementsFile == "-") {
+		this->printMessage(tr("The frames and the measurements can't both be written to the standard output"), 0);
+		return false;
+	}
+	
+	return true;
+}
+
+/// \brief Prints the command line options.
+void HeadlessScope::printUsage() {
+	QString usage = tr(
+			"Usage: openhantek --cli [options]\n"
+			"Acquires frames without the graphical user interface.\n"
+			"\n"
+			"  --settings FILE       Load the oscilloscope settings from FILE\n"
+			"  --frames N            Stop after N frames\n"
+			"  --duration SECONDS    Stop after the given time\n"
+			"  --output FILE         Write the frames to FILE, - for the standard output\n"
+			"  --format csv|ohc      Format of the frames, guessed from the file name\n"
+			"  --measurements FILE   Write the measurements to FILE, - for the standard\n"
+			"                        output, which is used if the frames don't use it\n"
+			"  --server              Accept clients on the socket and port of the settings\n"
+			"  --ring                Publish the frames in the shared memory ring of the\n"
+			"                        settings\n"
+			"  --help                Show this help\n");
+	
+	fputs(usage.toLocal8Bit().constData(), stdout);
+}
+
+/// \brief Configures the oscilloscope like the main window does.
+void HeadlessScope::setupDevice() {
+	bool mathUsed = this->settings->scope.voltage[this->settings->scope.physicalChannels].used | this->settings->scope.spectrum[this->settings->scope.physicalChannels].used;
+	
+	for(unsigned int channel = 0; channel < this->settings->scope.physicalChannels; channel++) {
+		this->dsoControl->setCoupling(channel, (Dso::Coupling) this->settings->scope.voltage[channel].misc);
+		this->dsoControl->setGain(channel, this->settings->scope.voltage[channel].gain * DIVS_VOLTAGE);
+		this->dsoControl->setOffset(channel, (this->settings->scope.voltage[channel].offset / DIVS_VOLTAGE) + 0.5);
+		this->dsoControl->setTriggerLevel(channel, this->settings->scope.voltage[channel].trigger);
+		this->dsoControl->setChannelUsed(channel, mathUsed | this->settings->scope.voltage[channel].used | this->settings->scope.spectrum[channel].used);
+	}
+	this->dsoControl->setBufferSize(this->settings->scope.horizontal.samples);
+	this->settings->scope.horizontal.samplerate = this->dsoControl->setSamplerate(1e3 / this->settings->scope.horizontal.timebase);
+	this->dsoControl->setTriggerMode(this->settings->scope.trigger.mode);
+	this->dsoControl->setTriggerPosition(this->settings->scope.trigger.position * this->settings->scope.horizontal.timebase * DIVS_TIME);
+	this->dsoControl->setTriggerSlope(this->settings->scope.trigger.slope);
+	this->dsoControl->setTriggerSource(this->settings->scope.trigger.special, this->settings->scope.trigger.source);
+}
+
+/// \brief Appends the analyzed frame to the capture output.
+/// \return false if writing failed.
+bool HeadlessScope::writeCapture() {
+	CaptureFile::collect(this->settings, this->dataAnalyzer, this->record, false);
+	if(this->settings->options.recorder.compress)
+		CaptureFile::pack(this->record);
+	
+	return CaptureFile::writeRecord(this->captureOutput, this->record) && this->captureOutput->flush();
+}
+
+/// \brief Appends the measurements of the analyzed frame.
+/// Writes one line with the frame number, the time since the start and the
+/// amplitude and frequency of each used voltage channel.
+/// \return false if writing failed.
+bool HeadlessScope::writeMeasurements() {
+	char number[CSV_NUMBER_LENGTH];
+	char decimalPoint = localeconv()->decimal_point[0];
+	
+	QByteArray line = QByteArray::number((qulonglong) this->frames);
+	CsvWriter::formatNumber(this->elapsed.elapsed() / 1000.0, number, decimalPoint);
+	line += '\t';
+	line += number;
+	
+	for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
+		if(!this->settings->scope.voltage[channel].used)
+			continue;
+		
+		// Keep the columns in place if a channel wasn't analyzed
+		const AnalyzedData *analyzedData = this->dataAnalyzer->data(channel);
+		if(!analyzedData) {
+			line += "\t\t";
+			continue;
+		}
+		
+		CsvWriter::formatNumber(analyzedData->amplitude, number, decimalPoint);
+		line += '\t';
+		line += number;
+		CsvWriter::formatNumber(analyzedData->frequency, number, decimalPoint);
+		line += '\t';
+		line += number;
+	}
+	line += '\n';
+	
+	return this->measurementsOutput->write(line) == line.size() && this->measurementsOutput->flush();
+}
+
+/// \brief Stops the oscilloscope, closes the outputs and quits the application.
+/// \param exitCode The exit code of the application.
+void HeadlessScope::finish(int exitCode) {
+	if(this->finished)
+		return;
+	this->finished = true;
+	this->durationTimer->stop();
+	
+	// Stop the threads before the outputs are closed
+	this->dsoControl->stopSampling();
+	this->dsoControl->disconnectDevice();
+	this->dsoControl->wait();
+	this->dataAnalyzer->wait();
+	
+	if(this->csvWriter && !this->csvWriter->close()) {
+		this->printMessage(tr("Can't write %1").arg(this->framesFile), 0);
+		exitCode = 1;
+	}
+	if(this->captureOutput)
+		this->captureOutput->close();
+	if(this->measurementsOutput)
+		this->measurementsOutput->close();
+	if(this->scopeServer)
+		this->scopeServer->close();
+	if(this->framePublisher)
+		this->framePublisher->close();
+	
+	QCoreApplication::exit(exitCode);
+}
+
+/// \brief Opens a file for writing.
+/// \param filename The name of the file, "-" for the standard output.
+/// \param mode The mode the file is opened with.
+/// \return The opened file, 0 if it couldn't be opened.
+QFile *HeadlessScope::openOutput(const QString &filename, QIODevice::OpenMode mode) {
+	QFile *file = new QFile(filename);
+	bool opened;
+	if(filename == "-")
+		opened = file->open(stdout, mode);
+	else
+		opened = file->open(mode);
+	
+	if(!opened) {
+		delete file;
+		return 0;
+	}
+	
+	return file;
+}
+
+/// \brief Writes the analyzed frame to the outputs.
+/// Has to be connected directly to DataAnalyzer::analyzed(), it's called from
+/// the analyzer thread while the analyzed data is locked. Slow outputs slow
+/// down the acquisition instead of losing frames.
+/// \param samples The number of analyzed samples.
+void HeadlessScope::analyzed(unsigned int samples) {
+	Q_UNUSED(samples);
+	
+	// Frames that arrive until the acquisition is stopped are ignored
+	if(this->complete || this->finished)
+		return;
+	
+	bool success = true;
+	if(this->csvWriter) {
+		success = this->csvWriter->writeFrame(false);
+		// Streams shouldn't wait until the buffer is full
+		if(success && this->framesFile == "-")
+			this->csvWriter->flush();
+	}
+	if(success && this->captureOutput)
+		success = this->writeCapture();
+	if(!success)
+		this->printMessage(tr("Can't write %1").arg(this->framesFile), 0);
+	else if(this->measurementsOutput && !this->writeMeasurements()) {
+		this->printMessage(tr("Can't write %1").arg(this->measurementsFile), 0);
+		success = false;
+	}
+	
+	if(success)
+		this->frames++;
+	
+	// The threads are stopped by the main thread, finish() waits for this one
+	if(!success || (this->frameLimit && this->frames >= this->frameLimit)) {
+		this->complete = true;
+		QMetaObject::invokeMethod(this, "finish", Qt::QueuedConnection, Q_ARG(int, success ? 0 : 1));
+	}
+}
+
+/// \brief Stops the acquisition after the requested time.
+void HeadlessScope::durationReached() {
+	this->finish(0);
+}
+
+/// \brief Stops the acquisition if the oscilloscope was disconnected.
+void HeadlessScope::deviceStopped() {
+	if(this->finished)
+		return;
+	
+	this->printMessage(tr("The oscilloscope was disconnected"), 0);
+	this->finish(1);
+}
+
+/// \brief Prints a status message to the standard error output.
+/// \param message The message that should be printed.
+/// \param timeout Unused, messages are always shown.
+void HeadlessScope::printMessage(const QString &message, int timeout) {
+	Q_UNUSED(timeout);
+	
+	if(!message.isEmpty())
+		fprintf(stderr, "%s\n", message.toLocal8Bit().constData());
+}
@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file headless.h
+/// \brief Declares the HeadlessScope class.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QObject>
+#include <QString>
+
+
+class QFile;
+class QStringList;
+class QTimer;
+
+struct CaptureRecord;
+class CsvWriter;
+class DataAnalyzer;
+class DsoControl;
+class DsoSettings;
+class FramePublisher;
+class ScopeServer;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \enum HeadlessFormat                                              headless.h
+/// \brief The formats the frames can be written in.
+enum HeadlessFormat {
+	HEADLESS_FORMAT_NONE,                   ///< The frames aren't written
+	HEADLESS_FORMAT_CSV,                    ///< CSV table in the configured layout
+	HEADLESS_FORMAT_CAPTURE                 ///< Records of an OpenHantek capture
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class HeadlessScope                                              headless.h
+/// \brief Acquires frames without the graphical user interface.
+/// The oscilloscope is configured from a settings file, the analyzed frames
+/// and their measurements are streamed to files or the standard output until
+/// the requested number of frames or the requested time is reached.
+class HeadlessScope : public QObject {
+	Q_OBJECT
+	
+	public:
+		HeadlessScope(QObject *parent = 0);
+		~HeadlessScope();
+		
+		int start(const QStringList &arguments);
+		
+		static bool requested(int argc, char *argv[]);
+	
+	protected:
+		bool parseArguments(const QStringList &arguments);
+		void printUsage();
+		void setupDevice();
+		bool writeCapture();
+		bool writeMeasurements();
+		
+		static QFile *openOutput(const QString &filename, QIODevice::OpenMode mode);
+		
+		DsoSettings *settings; ///< The settings loaded from the settings file
+		DsoControl *dsoControl; ///< The connected oscilloscope
+		DataAnalyzer *dataAnalyzer; ///< Analyzes the frames of the oscilloscope
+		
+		QString settingsFile; ///< The settings file, empty for the default settings
+		QString framesFile; ///< The file the frames are written to, "-" for stdout
+		HeadlessFormat format; ///< The format of the frames
+		QString measurementsFile; ///< The file the measurements are written to, "-" for stdout
+		unsigned long int frameLimit; ///< Stop after this number of frames, 0 for no limit
+		double durationLimit; ///< Stop after this time in seconds, 0 for no limit
+		bool serverEnabled; ///< true if the server accepts clients
+		bool ringEnabled; ///< true if the frames are published in shared memory
+		
+		CsvWriter *csvWriter; ///< Writes the frames in CSV format
+		QFile *captureOutput; ///< Receives the frames in capture format
+		CaptureRecord *record; ///< The frame that is written to the capture
+		QFile *measurementsOutput; ///< Receives the measurements
+		ScopeServer *scopeServer; ///< Streams the frames to other programs, 0 if disabled
+		FramePublisher *framePublisher; ///< Publishes the frames in shared memory, 0 if disabled
+		
+		unsigned long int frames; ///< The number of frames written so far
+		QElapsedTimer elapsed; ///< Time since the start of the acquisition
+		QTimer *durationTimer; ///< Stops the acquisition after the requested time
+		bool complete; ///< true after the last frame was written or writing failed
+		bool finished; ///< true after the acquisition was stopped
+	
+	protected slots:
+		void analyzed(unsigned int samples);
+		void finish(int exitCode);
+		void durationReached();
+		void deviceStopped();
+		void printMessage(const QString &message, int timeout);
+};
+
+
+#endif
@@ -23,27 +23,47 @@
 
 
 #include <QApplication>
+#include <QCoreApplication>
 #include <QLibraryInfo>
 #include <QLocale>
 #include <QTranslator>
 
 
+#include "headless.h"
 #include "openhantek.h"
 
 
+/// \brief Install the translations for the system locale.
+/// \param application The application that uses the translations.
+static void installTranslations(QCoreApplication *application) {
+	QTranslator *qtTranslator = new QTranslator(application);
+	qtTranslator->load("qt_" + QLocale::system().name(), QLibraryInfo::location(QLibraryInfo::TranslationsPath));
+	application->installTranslator(qtTranslator);
+
+	QTranslator *openHantekTranslator = new QTranslator(application);
+	openHantekTranslator->load("openhantek_" + QLocale::system().name(), QMAKE_TRANSLATIONS_PATH);
+	application->installTranslator(openHantekTranslator);
+}
+
 /// \brief Initialize resources and translations and show the main window.
+/// With --cli the oscilloscope is used without windows and OpenGL instead.
 int main(int argc, char *argv[]) {
 	Q_INIT_RESOURCE(application);
 
-	QApplication openHantekApplication(argc, argv);
+	if(HeadlessScope::requested(argc, argv)) {
+		QCoreApplication openHantekApplication(argc, argv);
+		installTranslations(&openHantekApplication);
+
+		HeadlessScope headlessScope;
+		int exitCode = headlessScope.start(openHantekApplication.arguments());
+		if(exitCode >= 0)
+			return exitCode;
 
-	QTranslator qtTranslator;
-	qtTranslator.load("qt_" + QLocale::system().name(), QLibraryInfo::location(QLibraryInfo::TranslationsPath));
-	openHantekApplication.installTranslator(&qtTranslator);
+		return openHantekApplication.exec();
+	}
 
-	QTranslator openHantekTranslator;
-	openHantekTranslator.load("openhantek_" + QLocale::system().name(), QMAKE_TRANSLATIONS_PATH);
-	openHantekApplication.installTranslator(&openHantekTranslator);
+	QApplication openHantekApplication(argc, argv);
+	installTranslations(&openHantekApplication);
 
 	OpenHantekMainWindow *openHantekMainWindow = new OpenHantekMainWindow();
 	openHantekMainWindow->show();
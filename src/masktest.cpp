@@ -0,0 +1,257 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  masktest.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cfloat>
+
+
+#include "masktest.h"
+
+#include "dataanalyzer.h"
+#include "dso.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class MaskTest
+/// \brief Initializes an empty mask that lets every frame pass.
+MaskTest::MaskTest() {
+	this->limitsValid = false;
+	this->limitCount = 0;
+	this->failedInterval = 0;
+	this->resetCounters();
+	this->rasterize();
+}
+
+/// \brief Cleans up everything.
+MaskTest::~MaskTest() {
+}
+
+/// \brief Sets a new mask.
+/// \param polygon The allowed area in divs, an empty polygon allows everything.
+void MaskTest::setMask(const QPolygonF &polygon) {
+	if(polygon == this->polygon)
+		return;
+	
+	this->polygon = polygon;
+	this->rasterize();
+}
+
+/// \brief Returns the current mask.
+/// \return The allowed area in divs.
+const QPolygonF &MaskTest::getMask() const {
+	return this->polygon;
+}
+
+/// \brief Tests a frame against the mask.
+/// \param samples The voltage graph of the tested channel.
+/// \param timebase The timebase in s/div.
+/// \param gain The gain of the channel in V/div.
+/// \param offset The offset of the channel in divs.
+/// \return true if the frame stays inside of the mask.
+bool MaskTest::test(const SampleValues *samples, double timebase, double gain, double offset) {
+	if(!samples || !samples->sample || !samples->count || timebase <= 0)
+		return true;
+	
+	this->updateLimits(samples, timebase, gain, offset);
+	
+	// Count the violations without branching, the compiler can vectorize this
+	const double *sample = samples->sample;
+	const double *lower = this->lowerLimit.constData();
+	const double *upper = this->upperLimit.constData();
+	unsigned int violations = 0;
+	for(unsigned int position = 0; position < this->limitCount; position++)
+		violations += (sample[position] < lower[position]) | (sample[position] > upper[position]);
+	
+	this->violations = violations;
+	this->tested++;
+	if(!violations)
+		return true;
+	
+	this->failed++;
+	this->failedFrame.resize(samples->count);
+	for(unsigned int position = 0; position < samples->count; position++)
+		this->failedFrame[position] = sample[position];
+	this->failedInterval = samples->interval;
+	
+	return false;
+}
+
+/// \brief Resets the frame counters.
+void MaskTest::resetCounters() {
+	this->tested = 0;
+	this->failed = 0;
+	this->violations = 0;
+}
+
+/// \brief Returns the number of tested frames.
+/// \return The number of frames since the last reset.
+unsigned long int MaskTest::getTested() const {
+	return this->tested;
+}
+
+/// \brief Returns the number of failed frames.
+/// \return The number of frames that violated the mask since the last reset.
+unsigned long int MaskTest::getFailed() const {
+	return this->failed;
+}
+
+/// \brief Returns the number of violating samples in the last frame.
+/// \return The number of samples that were outside of the mask.
+unsigned int MaskTest::getViolations() const {
+	return this->violations;
+}
+
+/// \brief Returns the last frame that failed.
+/// \return The voltage samples of the last failing frame.
+const QVector<double> &MaskTest::getFailedFrame() const {
+	return this->failedFrame;
+}
+
+/// \brief Returns the sample interval of the last frame that failed.
+/// \return The interval between two samples in s.
+double MaskTest::getFailedInterval() const {
+	return this->failedInterval;
+}
+
+/// \brief Creates a mask that encloses a trace.
+/// \param samples The voltage graph of the reference channel.
+/// \param timebase The timebase in s/div.
+/// \param gain The gain of the channel in V/div.
+/// \param offset The offset of the channel in divs.
+/// \param tolerance The distance between trace and mask in divs.
+/// \return The polygon in divs, empty if there are no samples on the screen.
+QPolygonF MaskTest::fromTrace(const SampleValues *samples, double timebase, double gain, double offset, double tolerance) {
+	QPolygonF polygon;
+	if(!samples || !samples->sample || !samples->count || timebase <= 0 || gain <= 0)
+		return polygon;
+	
+	// Get the envelope of the trace for each segment
+	double segmentMinimum[MASK_TRACE_SEGMENTS];
+	double segmentMaximum[MASK_TRACE_SEGMENTS];
+	int segmentCount = 0;
+	double horizontalFactor = samples->interval / timebase / DIVS_TIME * MASK_TRACE_SEGMENTS;
+	for(unsigned int position = 0; position < samples->count; position++) {
+		int segment = (int) (position * horizontalFactor);
+		if(segment >= MASK_TRACE_SEGMENTS)
+			break;
+		
+		double value = samples->sample[position] / gain + offset;
+		if(segment >= segmentCount) {
+			for(; segmentCount <= segment; segmentCount++)
+				segmentMinimum[segmentCount] = segmentMaximum[segmentCount] = value;
+		}
+		else if(value < segmentMinimum[segment])
+			segmentMinimum[segment] = value;
+		else if(value > segmentMaximum[segment])
+			segmentMaximum[segment] = value;
+	}
+	
+	// Neighbouring segments are joined, so that steep edges are covered
+	double segmentWidth = (double) DIVS_TIME / MASK_TRACE_SEGMENTS;
+	for(int segment = 0; segment < segmentCount; segment++) {
+		double top = segmentMaximum[segment];
+		if(segment + 1 < segmentCount && segmentMaximum[segment + 1] > top)
+			top = segmentMaximum[segment + 1];
+		polygon.append(QPointF(segment * segmentWidth - DIVS_TIME / 2, top + tolerance));
+		polygon.append(QPointF((segment + 1) * segmentWidth - DIVS_TIME / 2, top + tolerance));
+	}
+	for(int segment = segmentCount - 1; segment >= 0; segment--) {
+		double bottom = segmentMinimum[segment];
+		if(segment + 1 < segmentCount && segmentMinimum[segment + 1] < bottom)
+			bottom = segmentMinimum[segment + 1];
+		polygon.append(QPointF((segment + 1) * segmentWidth - DIVS_TIME / 2, bottom - tolerance));
+		polygon.append(QPointF(segment * segmentWidth - DIVS_TIME / 2, bottom - tolerance));
+	}
+	
+	return polygon;
+}
+
+/// \brief Rasterizes the polygon into the allowed band of each column.
+/// Every column is intersected with all edges of the polygon, the outermost
+/// intersections limit the band. Columns outside of the polygon aren't tested.
+void MaskTest::rasterize() {
+	for(int column = 0; column < MASK_COLUMNS; column++) {
+		double x = ((double) column + 0.5) * DIVS_TIME / MASK_COLUMNS - DIVS_TIME / 2;
+		this->columnUsed[column] = false;
+		
+		for(int point = 0; point < this->polygon.count(); point++) {
+			const QPointF &start = this->polygon[point];
+			const QPointF &end = this->polygon[(point + 1) % this->polygon.count()];
+			// Half-open interval, so shared vertices aren't counted twice
+			if((x < start.x()) == (x < end.x()))
+				continue;
+			
+			double y = start.y() + (x - start.x()) * (end.y() - start.y()) / (end.x() - start.x());
+			if(!this->columnUsed[column]) {
+				this->columnMinimum[column] = y;
+				this->columnMaximum[column] = y;
+				this->columnUsed[column] = true;
+			}
+			else if(y < this->columnMinimum[column])
+				this->columnMinimum[column] = y;
+			else if(y > this->columnMaximum[column])
+				this->columnMaximum[column] = y;
+		}
+	}
+	
+	this->limitsValid = false;
+}
+
+/// \brief Converts the allowed bands into voltage limits for each sample.
+/// \param samples The voltage graph of the tested channel.
+/// \param timebase The timebase in s/div.
+/// \param gain The gain of the channel in V/div.
+/// \param offset The offset of the channel in divs.
+void MaskTest::updateLimits(const SampleValues *samples, double timebase, double gain, double offset) {
+	if(this->limitsValid && samples->count == this->limitSamples && samples->interval == this->limitInterval && timebase == this->limitTimebase && gain == this->limitGain && offset == this->limitOffset)
+		return;
+	
+	this->limitSamples = samples->count;
+	this->limitInterval = samples->interval;
+	this->limitTimebase = timebase;
+	this->limitGain = gain;
+	this->limitOffset = offset;
+	this->limitsValid = true;
+	
+	this->lowerLimit.resize(samples->count);
+	this->upperLimit.resize(samples->count);
+	
+	// Only the samples that are shown on the screen are tested
+	double horizontalFactor = samples->interval / timebase / DIVS_TIME * MASK_COLUMNS;
+	this->limitCount = 0;
+	for(unsigned int position = 0; position < samples->count; position++) {
+		int column = (int) (position * horizontalFactor);
+		if(column >= MASK_COLUMNS)
+			break;
+		
+		if(this->columnUsed[column]) {
+			this->lowerLimit[position] = (this->columnMinimum[column] - offset) * gain;
+			this->upperLimit[position] = (this->columnMaximum[column] - offset) * gain;
+		}
+		else {
+			this->lowerLimit[position] = -DBL_MAX;
+			this->upperLimit[position] = DBL_MAX;
+		}
+		this->limitCount++;
+	}
+}
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file masktest.h
+/// \brief Declares the MaskTest class.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef MASKTEST_H
+#define MASKTEST_H
+
+
+#include <QPolygonF>
+#include <QVector>
+
+
+#define MASK_COLUMNS               1000 ///< Horizontal resolution of the rasterized mask
+#define MASK_TRACE_SEGMENTS         100 ///< Segments of a mask created from a trace
+
+
+struct SampleValues;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class MaskTest                                                   masktest.h
+/// \brief Tests the voltage graph of a channel against a polygon mask.
+/// The polygon is given in screen divisions and encloses the allowed area. It
+/// is rasterized once into an allowed band for each column of the screen, the
+/// band is converted into voltage limits for each sample whenever the timebase,
+/// the gain or the offset change. Testing a frame is a single branch free pass
+/// over the samples, so it can keep up with the acquisition rate.
+class MaskTest {
+	public:
+		MaskTest();
+		~MaskTest();
+		
+		void setMask(const QPolygonF &polygon);
+		const QPolygonF &getMask() const;
+		
+		bool test(const SampleValues *samples, double timebase, double gain, double offset);
+		void resetCounters();
+		unsigned long int getTested() const;
+		unsigned long int getFailed() const;
+		unsigned int getViolations() const;
+		const QVector<double> &getFailedFrame() const;
+		double getFailedInterval() const;
+		
+		static QPolygonF fromTrace(const SampleValues *samples, double timebase, double gain, double offset, double tolerance);
+	
+	protected:
+		void rasterize();
+		void updateLimits(const SampleValues *samples, double timebase, double gain, double offset);
+		
+		QPolygonF polygon; ///< The allowed area in divs
+		bool columnUsed[MASK_COLUMNS]; ///< false if the mask doesn't cover the column
+		double columnMinimum[MASK_COLUMNS]; ///< Lower bound of the allowed band in divs
+		double columnMaximum[MASK_COLUMNS]; ///< Upper bound of the allowed band in divs
+		
+		QVector<double> lowerLimit; ///< Minimum allowed voltage for each sample
+		QVector<double> upperLimit; ///< Maximum allowed voltage for each sample
+		unsigned int limitCount; ///< Number of samples that are on the screen
+		bool limitsValid; ///< false if the limits have to be recalculated
+		unsigned int limitSamples; ///< The sample count the limits were made for
+		double limitInterval; ///< The sample interval the limits were made for
+		double limitTimebase; ///< The timebase the limits were made for
+		double limitGain; ///< The gain the limits were made for
+		double limitOffset; ///< The offset the limits were made for
+		
+		unsigned long int tested; ///< Number of tested frames
+		unsigned long int failed; ///< Number of frames that violated the mask
+		unsigned int violations; ///< Samples outside of the mask in the last frame
+		QVector<double> failedFrame; ///< Copy of the last frame that failed
+		double failedInterval; ///< Sample interval of the failed frame
+};
+
+
+#endif
@@ -27,6 +27,7 @@
 #include <QApplication>
 #include <QDir>
 #include <QFileDialog>
+#include <QLabel>
 #include <QMainWindow>
 #include <QMenu>
 #include <QMenuBar>
@@ -37,11 +38,15 @@
 
 #include "openhantek.h"
 
+#include "captureplayer.h"
 #include "configdialog.h"
 #include "dataanalyzer.h"
 #include "dockwindows.h"
 #include "dsocontrol.h"
 #include "dsowidget.h"
+#include "framepublisher.h"
+#include "recorder.h"
+#include "scopeserver.h"
 #include "settings.h"
 #include "hantek/control.h"
 
@@ -74,6 +79,23 @@ OpenHantekMainWindow::OpenHantekMainWindow(QWidget *parent, Qt::WindowFlags flag
 	
 	// The data analyzer
 	this->dataAnalyzer = new DataAnalyzer(this->settings);
+	this->decoderDock->setDataAnalyzer(this->dataAnalyzer);
+	this->statisticsDock->setDataAnalyzer(this->dataAnalyzer);
+	this->maskDock->setDataAnalyzer(this->dataAnalyzer);
+	this->peakDock->setDataAnalyzer(this->dataAnalyzer);
+	
+	// The recorder writes the analyzed frames in the background
+	this->recorder = new Recorder(this->settings, this->dataAnalyzer, this);
+	
+	// The capture player replaces the oscilloscope when browsing recordings
+	this->capturePlayer = new CapturePlayer(this->settings, this->dataAnalyzer, this);
+	this->playbackDock->setPlayer(this->capturePlayer);
+	
+	// The server lets other programs control the oscilloscope
+	this->scopeServer = new ScopeServer(this->settings, this->dataAnalyzer, this);
+	
+	// Local programs can read the frames from shared memory without copying them
+	this->framePublisher = new FramePublisher(this->settings, this->dataAnalyzer, this);
 	
 	// Central oszilloscope widget
 	this->dsoWidget = new DsoWidget(this->settings, this->dataAnalyzer);
@@ -97,6 +119,12 @@ OpenHantekMainWindow::OpenHantekMainWindow(QWidget *parent, Qt::WindowFlags flag
 	//connect(this->dsoWidget, SIGNAL(stopped()), this, SLOT(stopped()));
 	connect(this->dsoControl, SIGNAL(statusMessage(QString, int)), this->statusBar(), SLOT(showMessage(QString, int)));
 	connect(this->dsoControl, SIGNAL(samplesAvailable(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)), this->dataAnalyzer, SLOT(analyze(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)));
+	// The recorder copies the frames in the analyzer thread while they are locked
+	connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this->recorder, SLOT(record()), Qt::DirectConnection);
+	connect(this->recorder, SIGNAL(statusMessage(QString, int)), this->statusBar(), SLOT(showMessage(QString, int)));
+	connect(this->recorder, SIGNAL(recordingStopped()), this, SLOT(recordingStopped()));
+	connect(this->recorder, SIGNAL(statusChanged(unsigned int, unsigned long int, unsigned long int)), this, SLOT(updateRecorderStatus(unsigned int, unsigned long int, unsigned long int)));
+	connect(this->capturePlayer, SIGNAL(samplesAvailable(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)), this->dataAnalyzer, SLOT(analyze(const QList<double *> *, const QList<unsigned int> *, double, QMutex *)));
 	
 	// Connect signals to DSO controller and widget
 	//connect(this->horizontalDock, SIGNAL(formatChanged(HorizontalFormat)), this->dsoWidget, SLOT(horizontalFormatChanged(HorizontalFormat)));
@@ -126,12 +154,39 @@ OpenHantekMainWindow::OpenHantekMainWindow(QWidget *parent, Qt::WindowFlags flag
 	connect(this->spectrumDock, SIGNAL(usedChanged(unsigned int, bool)), this->dsoWidget, SLOT(updateSpectrumUsed(unsigned int, bool)));
 	connect(this->spectrumDock, SIGNAL(magnitudeChanged(unsigned int, double)), this->dsoWidget, SLOT(updateSpectrumMagnitude(unsigned int)));
 	
+	connect(this->maskDock, SIGNAL(stopRequested()), this->dsoControl, SLOT(stopSampling()));
+	
 	// Started/stopped signals from oscilloscope	
 	connect(this->dsoControl, SIGNAL(samplingStarted()), this, SLOT(started()));
 	connect(this->dsoControl, SIGNAL(samplingStopped()), this, SLOT(stopped()));
+	// Recorded frames and the oscilloscope can't be shown at the same time
+	connect(this->capturePlayer, SIGNAL(opened(unsigned int)), this->dsoControl, SLOT(stopSampling()));
+	connect(this->dsoControl, SIGNAL(samplingStarted()), this->capturePlayer, SLOT(close()));
+	
+	// Remote control, the requests take the same way as changes in the docks
+	connect(this, SIGNAL(settingsChanged()), this->scopeServer, SLOT(applySettings()));
+	connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this->scopeServer, SLOT(analyzed(unsigned int)));
+	connect(this->scopeServer, SIGNAL(statusMessage(QString, int)), this->statusBar(), SLOT(showMessage(QString, int)));
+	connect(this->dsoControl, SIGNAL(samplingStarted()), this->scopeServer, SLOT(samplingStarted()));
+	connect(this->dsoControl, SIGNAL(samplingStopped()), this->scopeServer, SLOT(samplingStopped()));
+	connect(this->scopeServer, SIGNAL(startRequested()), this->dsoControl, SLOT(startSampling()));
+	connect(this->scopeServer, SIGNAL(stopRequested()), this->dsoControl, SLOT(stopSampling()));
+	connect(this->scopeServer, SIGNAL(timebaseRequested(double)), this->horizontalDock, SLOT(setTimebase(double)));
+	connect(this->scopeServer, SIGNAL(triggerModeRequested(Dso::TriggerMode)), this->triggerDock, SLOT(setMode(Dso::TriggerMode)));
+	connect(this->scopeServer, SIGNAL(triggerSlopeRequested(Dso::Slope)), this->triggerDock, SLOT(setSlope(Dso::Slope)));
+	connect(this->scopeServer, SIGNAL(triggerSourceRequested(bool, unsigned int)), this->triggerDock, SLOT(setSource(bool, unsigned int)));
+	connect(this->scopeServer, SIGNAL(usedRequested(int, bool)), this->voltageDock, SLOT(setUsed(int, bool)));
+	connect(this->scopeServer, SIGNAL(gainRequested(int, double)), this->voltageDock, SLOT(setGain(int, double)));
+	connect(this->scopeServer, SIGNAL(couplingRequested(int, Dso::Coupling)), this->voltageDock, SLOT(setCoupling(int, Dso::Coupling)));
+	connect(this->scopeServer, SIGNAL(mathModeRequested(Dso::MathMode)), this->voltageDock, SLOT(setMode(Dso::MathMode)));
+	
+	connect(this, SIGNAL(settingsChanged()), this->framePublisher, SLOT(applySettings()));
+	connect(this->dataAnalyzer, SIGNAL(analyzed(unsigned int)), this->framePublisher, SLOT(publish()), Qt::DirectConnection);
+	connect(this->framePublisher, SIGNAL(statusMessage(QString, int)), this->statusBar(), SLOT(showMessage(QString, int)));
 	
 	// Set up the oscilloscope
 	this->dsoControl->connectDevice();
+	this->settings->scope.model = this->dsoControl->getModelName();
 	
 	for(unsigned int channel = 0; channel < this->settings->scope.physicalChannels; channel++) {
 		this->dsoControl->setCoupling(channel, (Dso::Coupling) this->settings->scope.voltage[channel].misc);
@@ -147,6 +202,8 @@ OpenHantekMainWindow::OpenHantekMainWindow(QWidget *parent, Qt::WindowFlags flag
 	this->dsoControl->setTriggerSlope(this->settings->scope.trigger.slope);
 	this->dsoControl->setTriggerSource(this->settings->scope.trigger.special, this->settings->scope.trigger.source);
 	
+	this->scopeServer->applySettings();
+	this->framePublisher->applySettings();
 	this->dsoControl->startSampling();
 }
 
@@ -189,6 +246,12 @@ void OpenHantekMainWindow::createActions() {
 	this->exportAsAction->setStatusTip(tr("Export the oscilloscope data to a file"));
 	connect(this->exportAsAction, SIGNAL(triggered()), this->dsoWidget, SLOT(exportAs()));
 
+	this->recordAction = new QAction(tr("&Record"), this);
+	this->recordAction->setCheckable(true);
+	this->recordAction->setShortcut(tr("Ctrl+R"));
+	this->recordAction->setStatusTip(tr("Record the analyzed frames to disk"));
+	connect(this->recordAction, SIGNAL(toggled(bool)), this, SLOT(record(bool)));
+
 	this->exitAction = new QAction(tr("E&xit"), this);
 	this->exitAction->setShortcut(tr("Ctrl+Q"));
 	this->exitAction->setStatusTip(tr("Exit the application"));
@@ -254,6 +317,7 @@ void OpenHantekMainWindow::createMenus() {
 	this->fileMenu->addSeparator();
 	this->fileMenu->addAction(this->printAction);
 	this->fileMenu->addAction(this->exportAsAction);
+	this->fileMenu->addAction(this->recordAction);
 	this->fileMenu->addSeparator();
 	this->fileMenu->addAction(this->exitAction);
 	
@@ -266,6 +330,11 @@ void OpenHantekMainWindow::createMenus() {
 	this->dockMenu->addAction(this->spectrumDock->toggleViewAction());
 	this->dockMenu->addAction(this->triggerDock->toggleViewAction());
 	this->dockMenu->addAction(this->voltageDock->toggleViewAction());
+	this->dockMenu->addAction(this->decoderDock->toggleViewAction());
+	this->dockMenu->addAction(this->statisticsDock->toggleViewAction());
+	this->dockMenu->addAction(this->maskDock->toggleViewAction());
+	this->dockMenu->addAction(this->peakDock->toggleViewAction());
+	this->dockMenu->addAction(this->playbackDock->toggleViewAction());
 	this->toolbarMenu = this->viewMenu->addMenu(tr("&Toolbars"));
 	this->toolbarMenu->addAction(this->fileToolBar->toggleViewAction());
 	this->toolbarMenu->addAction(this->oscilloscopeToolBar->toggleViewAction());
@@ -300,6 +369,7 @@ void OpenHantekMainWindow::createToolBars() {
 	this->fileToolBar->addSeparator();
 	this->fileToolBar->addAction(this->printAction);
 	this->fileToolBar->addAction(this->exportAsAction);
+	this->fileToolBar->addAction(this->recordAction);
 	
 	this->oscilloscopeToolBar = new QToolBar(tr("Oscilloscope"));
 	this->oscilloscopeToolBar->addAction(this->startStopAction);
@@ -319,6 +389,11 @@ void OpenHantekMainWindow::createStatusBar() {
 	this->statusBar()->addPermanentWidget(this->commandEdit, 1);
 #endif
 	
+	// Counters of the recorder, shown after the first recording was started
+	this->recorderLabel = new QLabel();
+	this->recorderLabel->hide();
+	this->statusBar()->addPermanentWidget(this->recorderLabel);
+	
 	this->statusBar()->showMessage(tr("Ready"));
 	
 #ifdef DEBUG
@@ -335,6 +410,11 @@ void OpenHantekMainWindow::createDockWindows()
 	this->triggerDock = new TriggerDock(this->settings, this->dsoControl->getSpecialTriggerSources());
 	this->spectrumDock = new SpectrumDock(this->settings);
 	this->voltageDock = new VoltageDock(this->settings);
+	this->decoderDock = new DecoderDock(this->settings);
+	this->statisticsDock = new StatisticsDock(this->settings);
+	this->maskDock = new MaskDock(this->settings);
+	this->peakDock = new PeakDock(this->settings);
+	this->playbackDock = new PlaybackDock(this->settings);
 }
 
 /// \brief Read the settings from an ini file.
@@ -409,6 +489,30 @@ int OpenHantekMainWindow::saveAs() {
 	return status;
 }
 
+/// \brief Starts or stops the background recording.
+/// \param enabled true if the frames should be recorded.
+void OpenHantekMainWindow::record(bool enabled) {
+	if(enabled) {
+		if(this->recorder->startRecording())
+			this->recorderLabel->show();
+	}
+	else
+		this->recorder->stopRecording();
+}
+
+/// \brief Updates the record action when the recording stopped after an error.
+void OpenHantekMainWindow::recordingStopped() {
+	this->recordAction->setChecked(false);
+}
+
+/// \brief Shows the counters of the recorder.
+/// \param queueDepth The number of frames waiting to be written.
+/// \param written The number of frames written since the recording started.
+/// \param dropped The number of frames dropped because the queue was full.
+void OpenHantekMainWindow::updateRecorderStatus(unsigned int queueDepth, unsigned long int written, unsigned long int dropped) {
+	this->recorderLabel->setText(tr("Recorded %1 frames, %2 queued, %3 dropped").arg(written).arg(queueDepth).arg(dropped));
+}
+
 /// \brief The oscilloscope started sampling.
 void OpenHantekMainWindow::started() {
 	this->startStopAction->setText(tr("&Stop"));
@@ -480,12 +584,22 @@ void OpenHantekMainWindow::applySettings() {
 	docks.append(this->triggerDock);
 	docks.append(this->voltageDock);
 	docks.append(this->spectrumDock);
+	docks.append(this->decoderDock);
+	docks.append(this->statisticsDock);
+	docks.append(this->maskDock);
+	docks.append(this->peakDock);
+	docks.append(this->playbackDock);
 	
 	QList<DsoSettingsOptionsWindowPanel *> dockSettings;
 	dockSettings.append(&(this->settings->options.window.dock.horizontal));
 	dockSettings.append(&(this->settings->options.window.dock.trigger));
 	dockSettings.append(&(this->settings->options.window.dock.voltage));
 	dockSettings.append(&(this->settings->options.window.dock.spectrum));
+	dockSettings.append(&(this->settings->options.window.dock.decoder));
+	dockSettings.append(&(this->settings->options.window.dock.statistics));
+	dockSettings.append(&(this->settings->options.window.dock.mask));
+	dockSettings.append(&(this->settings->options.window.dock.peaks));
+	dockSettings.append(&(this->settings->options.window.dock.playback));
 	
 	QList<int> dockedWindows[2]; // Docks docked on the sides of the main window
 	
@@ -567,12 +681,22 @@ void OpenHantekMainWindow::updateSettings() {
 	docks.append(this->spectrumDock);
 	docks.append(this->triggerDock);
 	docks.append(this->voltageDock);
+	docks.append(this->decoderDock);
+	docks.append(this->statisticsDock);
+	docks.append(this->maskDock);
+	docks.append(this->peakDock);
+	docks.append(this->playbackDock);
 	
 	QList<DsoSettingsOptionsWindowPanel *> dockSettings;
 	dockSettings.append(&(this->settings->options.window.dock.horizontal));
 	dockSettings.append(&(this->settings->options.window.dock.spectrum));
 	dockSettings.append(&(this->settings->options.window.dock.trigger));
 	dockSettings.append(&(this->settings->options.window.dock.voltage));
+	dockSettings.append(&(this->settings->options.window.dock.decoder));
+	dockSettings.append(&(this->settings->options.window.dock.statistics));
+	dockSettings.append(&(this->settings->options.window.dock.mask));
+	dockSettings.append(&(this->settings->options.window.dock.peaks));
+	dockSettings.append(&(this->settings->options.window.dock.playback));
 	
 	for(int dockId = 0; dockId < docks.size(); dockId++) {
 		dockSettings[dockId]->floating = docks[dockId]->isFloating();
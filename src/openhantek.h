@@ -31,15 +31,25 @@
 
 
 class QActionGroup;
+class QLabel;
 class QLineEdit;
 
+class CapturePlayer;
 class DataAnalyzer;
+class DecoderDock;
 class DsoControl;
 class DsoSettings;
 class DsoWidget;
+class FramePublisher;
 class HorizontalDock;
-class TriggerDock;
+class MaskDock;
+class PeakDock;
+class PlaybackDock;
+class Recorder;
+class ScopeServer;
 class SpectrumDock;
+class StatisticsDock;
+class TriggerDock;
 class VoltageDock;
 
 
@@ -76,7 +86,7 @@ class OpenHantekMainWindow : public QMainWindow {
 
 		// Actions
 		QAction *newAction, *openAction, *saveAction, *saveAsAction;
-		QAction *printAction, *exportAsAction;
+		QAction *printAction, *exportAsAction, *recordAction;
 		QAction *exitAction;
 		
 		QAction *configAction;
@@ -105,6 +115,11 @@ class OpenHantekMainWindow : public QMainWindow {
 		TriggerDock *triggerDock;
 		SpectrumDock *spectrumDock;
 		VoltageDock *voltageDock;
+		DecoderDock *decoderDock;
+		StatisticsDock *statisticsDock;
+		MaskDock *maskDock;
+		PeakDock *peakDock;
+		PlaybackDock *playbackDock;
 		
 		// Central widgets
 		DsoWidget *dsoWidget;
@@ -113,10 +128,15 @@ class OpenHantekMainWindow : public QMainWindow {
 #ifdef DEBUG
 		QLineEdit *commandEdit;
 #endif
+		QLabel *recorderLabel;
 		
 		// Data handling classes
+		CapturePlayer *capturePlayer;
 		DataAnalyzer *dataAnalyzer;
 		DsoControl *dsoControl;
+		FramePublisher *framePublisher;
+		Recorder *recorder;
+		ScopeServer *scopeServer;
 		
 		// Other variables
 		QString currentFile;
@@ -129,6 +149,10 @@ class OpenHantekMainWindow : public QMainWindow {
 		int open();
 		int save();
 		int saveAs();
+		// Recording
+		void record(bool enabled);
+		void recordingStopped();
+		void updateRecorderStatus(unsigned int queueDepth, unsigned long int written, unsigned long int dropped);
 		// View
 		void digitalPhosphor(bool enabled);
 		void zoom(bool enabled);
@@ -0,0 +1,255 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  peakfinder.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <algorithm>
+#include <cmath>
+
+
+#include "peakfinder.h"
+
+#include "dataanalyzer.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class PeakLevelGreater
+/// \brief Orders spectrum positions by their level, highest first.
+class PeakLevelGreater {
+	public:
+		PeakLevelGreater(const double *levels) {
+			this->levels = levels;
+		}
+		
+		bool operator()(unsigned int first, unsigned int second) const {
+			return this->levels[first] > this->levels[second];
+		}
+	
+	protected:
+		const double *levels; ///< The spectrum values in dB
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class PeakFinder
+/// \brief Initializes an empty peak finder.
+PeakFinder::PeakFinder() {
+	this->clear();
+}
+
+/// \brief Finds the peaks and the harmonics of the spectrum.
+/// \param spectrum The spectrum in dB.
+/// \param count The number of peaks that should be listed.
+void PeakFinder::analyze(const SampleValues *spectrum, unsigned int count) {
+	this->clear();
+	if(!spectrum->sample || spectrum->count < 4)
+		return;
+	
+	const double *levels = spectrum->sample;
+	this->assigned.fill(false, spectrum->count);
+	
+	// The DC component is neither signal nor noise
+	unsigned int dcEnd = this->lobeEnd(spectrum, 0, 1);
+	for(unsigned int position = 0; position <= dcEnd; position++)
+		this->assigned[position] = true;
+	
+	// Collect the local maxima
+	for(unsigned int position = qMax(dcEnd, 1u); position < spectrum->count - 1; position++) {
+		if(levels[position] > levels[position - 1] && levels[position] >= levels[position + 1])
+			this->candidates.append(position);
+	}
+	if(this->candidates.isEmpty())
+		return;
+	
+	// Only the highest peaks have to be ordered, the second one is needed for the SFDR
+	int selected = qMin((int) qMax(count, 2u), this->candidates.count());
+	PeakLevelGreater greater(levels);
+	std::nth_element(this->candidates.begin(), this->candidates.begin() + selected - 1, this->candidates.end(), greater);
+	std::sort(this->candidates.begin(), this->candidates.begin() + selected, greater);
+	
+	// The strongest peak is the fundamental, search the harmonics around its multiples
+	SpectrumPeak fundamental = this->interpolate(spectrum, this->candidates[0]);
+	// The harmonics have the width of the fundamental, that depends on window and zero-padding
+	unsigned int searchRadius = 1;
+	while(this->candidates[0] + searchRadius < spectrum->count - 1 && levels[this->candidates[0] + searchRadius] > fundamental.level - PEAK_LOBE_DROP)
+		searchRadius++;
+	
+	unsigned int harmonicPositions[PEAK_HARMONICS];
+	double fundamentalPower = 0, harmonicPower = 0;
+	for(unsigned int order = 1; order <= PEAK_HARMONICS; order++) {
+		double target = fundamental.frequency * order / spectrum->interval;
+		if(target + searchRadius >= spectrum->count - 1)
+			break;
+		
+		unsigned int position = this->candidates[0];
+		if(order > 1) {
+			// Wide lobes of low fundamentals would reach into the DC component
+			int center = (int) (target + 0.5);
+			int first = qMax((int) dcEnd + 1, center - (int) searchRadius);
+			int last = qMin((int) spectrum->count - 1, center + (int) searchRadius);
+			if(first > last)
+				break;
+			
+			position = first;
+			for(int searchPosition = first + 1; searchPosition <= last; searchPosition++) {
+				if(levels[searchPosition] > levels[position])
+					position = searchPosition;
+			}
+		}
+		harmonicPositions[order - 1] = position;
+		
+		SpectrumPeak harmonic = this->interpolate(spectrum, position);
+		harmonic.harmonic = order;
+		this->harmonics.append(harmonic);
+		
+		if(order == 1)
+			fundamentalPower = this->lobePower(spectrum, position);
+		else
+			harmonicPower += this->lobePower(spectrum, position);
+	}
+	if(this->harmonics.isEmpty())
+		return;
+	
+	// Everything except DC and the fundamental is noise and distortion
+	double totalPower = 0;
+	for(unsigned int position = dcEnd + 1; position < spectrum->count; position++)
+		totalPower += pow(10.0, levels[position] / 10);
+	
+	if(harmonicPower > 0)
+		this->thd = 10 * log10(harmonicPower / fundamentalPower);
+	if(totalPower > fundamentalPower)
+		this->sinad = 10 * log10(fundamentalPower / (totalPower - fundamentalPower));
+	if(selected > 1)
+		this->sfdr = fundamental.level - this->interpolate(spectrum, this->candidates[1]).level;
+	
+	// List the highest peaks and mark the harmonics among them
+	for(int peak = 0; peak < qMin((int) count, selected); peak++) {
+		SpectrumPeak spectrumPeak = this->interpolate(spectrum, this->candidates[peak]);
+		for(int order = 0; order < this->harmonics.count(); order++) {
+			if(harmonicPositions[order] == this->candidates[peak]) {
+				spectrumPeak.harmonic = order + 1;
+				break;
+			}
+		}
+		this->peaks.append(spectrumPeak);
+	}
+}
+
+/// \brief Removes the results of the last analysis.
+void PeakFinder::clear() {
+	this->candidates.clear();
+	this->peaks.clear();
+	this->harmonics.clear();
+	this->thd = 0;
+	this->sinad = 0;
+	this->sfdr = 0;
+}
+
+/// \brief Get the highest peaks of the last spectrum.
+/// \return The peaks ordered by level, highest first.
+const QList<SpectrumPeak> &PeakFinder::getPeaks() const {
+	return this->peaks;
+}
+
+/// \brief Get the fundamental and its harmonics.
+/// \return The peaks ordered by harmonic order, empty if there was no peak.
+const QList<SpectrumPeak> &PeakFinder::getHarmonics() const {
+	return this->harmonics;
+}
+
+/// \brief Get the total harmonic distortion.
+/// \return Power of the harmonics relative to the fundamental in dB.
+double PeakFinder::getThd() const {
+	return this->thd;
+}
+
+/// \brief Get the signal to noise and distortion ratio.
+/// \return Power of the fundamental relative to everything else except DC in dB.
+double PeakFinder::getSinad() const {
+	return this->sinad;
+}
+
+/// \brief Get the spurious free dynamic range.
+/// \return Level of the fundamental relative to the second highest peak in dB.
+double PeakFinder::getSfdr() const {
+	return this->sfdr;
+}
+
+/// \brief Interpolates the peak with a parabola through the neighbouring values.
+/// \param spectrum The spectrum in dB.
+/// \param position The position of the local maximum.
+/// \return The peak with fractional frequency and level.
+SpectrumPeak PeakFinder::interpolate(const SampleValues *spectrum, unsigned int position) const {
+	SpectrumPeak peak;
+	peak.frequency = position * spectrum->interval;
+	peak.level = spectrum->sample[position];
+	peak.harmonic = 0;
+	
+	if(position == 0 || position >= spectrum->count - 1)
+		return peak;
+	
+	double previous = spectrum->sample[position - 1];
+	double next = spectrum->sample[position + 1];
+	double curvature = previous - 2 * peak.level + next;
+	if(curvature >= 0)
+		return peak;
+	
+	double offset = 0.5 * (previous - next) / curvature;
+	peak.frequency = (position + offset) * spectrum->interval;
+	peak.level -= 0.25 * (previous - next) * offset;
+	
+	return peak;
+}
+
+/// \brief Follows the falling slope of a peak.
+/// \param spectrum The spectrum in dB.
+/// \param position The position of the peak.
+/// \param direction 1 to search upwards, -1 to search downwards.
+/// \return The last position of the main lobe in the given direction.
+unsigned int PeakFinder::lobeEnd(const SampleValues *spectrum, unsigned int position, int direction) const {
+	while((direction > 0) ? (position + 1 < spectrum->count) : (position > 0)) {
+		if(spectrum->sample[position + direction] >= spectrum->sample[position])
+			break;
+		position += direction;
+	}
+	
+	return position;
+}
+
+/// \brief Sums the power of the main lobe around a peak.
+/// Values that already belong to another lobe aren't counted twice.
+/// \param spectrum The spectrum in dB.
+/// \param position The position of the peak.
+/// \return The power of the lobe relative to the reference level.
+double PeakFinder::lobePower(const SampleValues *spectrum, unsigned int position) {
+	unsigned int last = this->lobeEnd(spectrum, position, 1);
+	double power = 0;
+	for(unsigned int lobePosition = this->lobeEnd(spectrum, position, -1); lobePosition <= last; lobePosition++) {
+		if(this->assigned[lobePosition])
+			continue;
+		
+		power += pow(10.0, spectrum->sample[lobePosition] / 10);
+		this->assigned[lobePosition] = true;
+	}
+	
+	return power;
+}
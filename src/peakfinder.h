@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file peakfinder.h
+/// \brief Declares the PeakFinder class.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef PEAKFINDER_H
+#define PEAKFINDER_H
+
+
+#include <QList>
+#include <QVector>
+
+
+#define PEAK_HARMONICS               10 ///< Highest harmonic order used for the THD
+#define PEAK_LOBE_DROP             20.0 ///< Level drop in dB that limits the harmonic search
+
+
+struct SampleValues;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct SpectrumPeak                                            peakfinder.h
+/// \brief A local maximum of the spectrum.
+struct SpectrumPeak {
+	double frequency; ///< Interpolated frequency of the peak in Hz
+	double level; ///< Interpolated level of the peak in dB
+	unsigned int harmonic; ///< Harmonic order relative to the fundamental, 0 if none
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class PeakFinder                                               peakfinder.h
+/// \brief Finds the highest peaks of a spectrum and analyzes the distortion.
+/// The local maxima are only partially ordered, so finding the K highest peaks
+/// of a spectrum with N values is O(N + K log K). The strongest peak is used as
+/// fundamental, THD, SINAD and SFDR are calculated from the power within the
+/// main lobes of the fundamental and its harmonics.
+class PeakFinder {
+	public:
+		PeakFinder();
+		
+		void analyze(const SampleValues *spectrum, unsigned int count);
+		void clear();
+		
+		const QList<SpectrumPeak> &getPeaks() const;
+		const QList<SpectrumPeak> &getHarmonics() const;
+		double getThd() const;
+		double getSinad() const;
+		double getSfdr() const;
+	
+	protected:
+		SpectrumPeak interpolate(const SampleValues *spectrum, unsigned int position) const;
+		unsigned int lobeEnd(const SampleValues *spectrum, unsigned int position, int direction) const;
+		double lobePower(const SampleValues *spectrum, unsigned int position);
+		
+		QVector<unsigned int> candidates; ///< Positions of the local maxima
+		QVector<bool> assigned; ///< Values already counted for a lobe
+		QList<SpectrumPeak> peaks; ///< The highest peaks, strongest first
+		QList<SpectrumPeak> harmonics; ///< Fundamental and harmonics in order
+		double thd; ///< Total harmonic distortion in dB
+		double sinad; ///< Signal to noise and distortion ratio in dB
+		double sfdr; ///< Spurious free dynamic range in dB
+};
+
+
+#endif
@@ -0,0 +1,282 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  recorder.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QTimer>
+#include <QWaitCondition>
+
+
+#include "recorder.h"
+
+#include "capturefile.h"
+#include "dataanalyzer.h"
+#include "settings.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class Recorder
+/// \brief Initializes the recorder.
+/// \param settings The settings with the recording options.
+/// \param dataAnalyzer The data analyzer whose frames are recorded.
+/// \param parent The parent widget.
+Recorder::Recorder(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QObject *parent) : QThread(parent) {
+	this->settings = settings;
+	this->dataAnalyzer = dataAnalyzer;
+	
+	this->queueMutex = new QMutex();
+	this->queueCondition = new QWaitCondition();
+	this->recording = false;
+	
+	this->frameCounter = 0;
+	this->framesWritten = 0;
+	this->framesDropped = 0;
+	
+	this->file = 0;
+	this->fileIndex = 0;
+	
+	this->statusTimer = new QTimer(this);
+	this->statusTimer->setInterval(1000);
+	connect(this->statusTimer, SIGNAL(timeout()), this, SLOT(reportStatus()));
+	connect(this, SIGNAL(finished()), this, SLOT(reportStatus()));
+}
+
+/// \brief Stops the recording and cleans up.
+Recorder::~Recorder() {
+	this->stopRecording();
+	this->wait();
+	
+	qDeleteAll(this->queue);
+	qDeleteAll(this->unusedRecords);
+	delete this->queueCondition;
+	delete this->queueMutex;
+}
+
+/// \brief Checks if new frames are recorded.
+/// \return true while the recording is running.
+bool Recorder::isRecording() const {
+	this->queueMutex->lock();
+	bool recording = this->recording;
+	this->queueMutex->unlock();
+	
+	return recording;
+}
+
+/// \brief Get the number of frames waiting to be written.
+/// \return The number of queued frames.
+unsigned int Recorder::getQueueDepth() const {
+	this->queueMutex->lock();
+	unsigned int queueDepth = this->queue.count();
+	this->queueMutex->unlock();
+	
+	return queueDepth;
+}
+
+/// \brief Get the number of written frames.
+/// \return The number of frames written since the recording was started.
+unsigned long int Recorder::getFramesWritten() const {
+	this->queueMutex->lock();
+	unsigned long int framesWritten = this->framesWritten;
+	this->queueMutex->unlock();
+	
+	return framesWritten;
+}
+
+/// \brief Get the number of dropped frames.
+/// \return The number of frames that were dropped because the queue was full.
+unsigned long int Recorder::getFramesDropped() const {
+	this->queueMutex->lock();
+	unsigned long int framesDropped = this->framesDropped;
+	this->queueMutex->unlock();
+	
+	return framesDropped;
+}
+
+/// \brief Writes the queued frames until the recording is stopped.
+/// The queue is drained before the thread ends, so no accepted frame is lost.
+void Recorder::run() {
+	this->queueMutex->lock();
+	while(true) {
+		while(this->queue.isEmpty() && this->recording)
+			this->queueCondition->wait(this->queueMutex);
+		if(this->queue.isEmpty())
+			break;
+		
+		// Only the queue is locked, the disk access happens without the lock
+		CaptureRecord *record = this->queue.takeFirst();
+		this->queueMutex->unlock();
+		if(this->settings->options.recorder.compress)
+			CaptureFile::pack(record);
+		bool written = this->writeRecord(record);
+		this->queueMutex->lock();
+		
+		this->unusedRecords.append(record);
+		if(written)
+			this->framesWritten++;
+		else {
+			// Stop after write errors, the waiting frames are dropped
+			this->recording = false;
+			this->framesDropped += this->queue.count();
+			while(!this->queue.isEmpty())
+				this->unusedRecords.append(this->queue.takeFirst());
+			emit recordingStopped();
+		}
+	}
+	this->queueMutex->unlock();
+	
+	this->closeFile();
+}
+
+/// \brief Appends a frame to the current file.
+/// A new file is started when the current one reached the configured size or
+/// age. Called by the writer thread only.
+/// \param record The frame that should be written.
+/// \return true if the frame was written.
+bool Recorder::writeRecord(const CaptureRecord *record) {
+	QDateTime now = QDateTime::currentDateTime();
+	
+	if(this->file && this->file->size() > 0) {
+		qint64 rotateSize = (qint64) this->settings->options.recorder.rotateSize * 1048576;
+		qint64 rotateTime = (qint64) this->settings->options.recorder.rotateTime * 60;
+		if((rotateSize && this->file->size() + (qint64) record->header.recordSize > rotateSize)
+				|| (rotateTime && this->fileStarted.secsTo(now) >= rotateTime))
+			this->closeFile();
+	}
+	
+	if(!this->file) {
+		this->fileIndex++;
+		QString filename = QDir(this->settings->options.recorder.path).filePath(QString("%1-%2.ohc").arg(this->recordingStarted.toString("yyyyMMdd-hhmmss")).arg(this->fileIndex, 3, 10, QChar('0')));
+		this->file = new QFile(filename);
+		if(!this->file->open(QIODevice::WriteOnly)) {
+			emit statusMessage(tr("Recording stopped, could not create %1").arg(filename), 0);
+			this->closeFile();
+			return false;
+		}
+		this->fileStarted = now;
+	}
+	
+	if(!CaptureFile::writeRecord(this->file, record)) {
+		emit statusMessage(tr("Recording stopped, could not write %1").arg(this->file->fileName()), 0);
+		return false;
+	}
+	
+	return true;
+}
+
+/// \brief Closes the current output file.
+void Recorder::closeFile() {
+	if(!this->file)
+		return;
+	
+	this->file->close();
+	delete this->file;
+	this->file = 0;
+}
+
+/// \brief Starts a new recording.
+/// \return true if the recording was started.
+bool Recorder::startRecording() {
+	if(this->isRecording())
+		return true;
+	
+	if(!QDir(this->settings->options.recorder.path).exists()) {
+		emit statusMessage(tr("The recording folder %1 doesn't exist").arg(this->settings->options.recorder.path), 0);
+		emit recordingStopped();
+		return false;
+	}
+	
+	// The writer of the previous recording may still be draining its queue
+	this->wait();
+	
+	this->queueMutex->lock();
+	this->recording = true;
+	this->frameCounter = 0;
+	this->framesWritten = 0;
+	this->framesDropped = 0;
+	this->queueMutex->unlock();
+	
+	this->recordingStarted = QDateTime::currentDateTime();
+	this->fileIndex = 0;
+	
+	this->start(QThread::LowPriority);
+	this->statusTimer->start();
+	this->reportStatus();
+	
+	return true;
+}
+
+/// \brief Stops accepting new frames, the queued frames are still written.
+void Recorder::stopRecording() {
+	this->queueMutex->lock();
+	this->recording = false;
+	this->queueCondition->wakeAll();
+	this->queueMutex->unlock();
+	
+	this->statusTimer->stop();
+}
+
+/// \brief Queues a copy of the analyzed frame.
+/// Has to be connected directly to DataAnalyzer::analyzed(), it's called from
+/// the analyzer thread while the analyzed data is locked. The queue is only
+/// locked to get and append the record, the writer thread and the status
+/// requests don't have to wait for the copy.
+void Recorder::record() {
+	this->queueMutex->lock();
+	
+	CaptureRecord *record = 0;
+	if(this->recording) {
+		unsigned int decimation = qMax(this->settings->options.recorder.decimation, (unsigned int) 1);
+		if(this->frameCounter++ % decimation == 0) {
+			if(this->queue.count() >= (int) this->settings->options.recorder.queueLength)
+				this->framesDropped++;
+			else
+				record = this->unusedRecords.isEmpty() ? new CaptureRecord : this->unusedRecords.takeLast();
+		}
+	}
+	
+	this->queueMutex->unlock();
+	
+	if(!record)
+		return;
+	
+	CaptureFile::collect(this->settings, this->dataAnalyzer, record, true);
+	
+	this->queueMutex->lock();
+	// The writer thread may have finished while the frame was copied
+	if(this->recording) {
+		this->queue.append(record);
+		this->queueCondition->wakeOne();
+	}
+	else {
+		this->framesDropped++;
+		this->unusedRecords.append(record);
+	}
+	this->queueMutex->unlock();
+}
+
+/// \brief Sends the current queue depth and frame counters.
+void Recorder::reportStatus() {
+	emit statusChanged(this->getQueueDepth(), this->getFramesWritten(), this->getFramesDropped());
+}
@@ -0,0 +1,103 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file recorder.h
+/// \brief Declares the Recorder class.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+
+#include <QDateTime>
+#include <QList>
+#include <QThread>
+
+
+class QFile;
+class QMutex;
+class QTimer;
+class QWaitCondition;
+
+class DataAnalyzer;
+class DsoSettings;
+struct CaptureRecord;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class Recorder                                                   recorder.h
+/// \brief Appends the analyzed frames to capture files in the background.
+/// The frames are copied right after the analysis and passed to the writer
+/// thread through a bounded queue. If the disk can't keep up, new frames are
+/// dropped instead of stalling the data analyzer.
+class Recorder : public QThread {
+	Q_OBJECT
+	
+	public:
+		Recorder(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QObject *parent = 0);
+		~Recorder();
+		
+		bool isRecording() const;
+		unsigned int getQueueDepth() const;
+		unsigned long int getFramesWritten() const;
+		unsigned long int getFramesDropped() const;
+	
+	protected:
+		void run();
+		bool writeRecord(const CaptureRecord *record);
+		void closeFile();
+		
+		DsoSettings *settings; ///< The settings provided by the parent class
+		DataAnalyzer *dataAnalyzer; ///< The source of the recorded frames
+		
+		QMutex *queueMutex; ///< Protects the queue and the counters
+		QWaitCondition *queueCondition; ///< Wakes the writer thread when frames are queued
+		QList<CaptureRecord *> queue; ///< Frames waiting to be written
+		QList<CaptureRecord *> unusedRecords; ///< Written frames that can be reused
+		bool recording; ///< true while new frames are accepted
+		
+		unsigned long int frameCounter; ///< Analyzed frames since the recording started
+		unsigned long int framesWritten; ///< Frames written since the recording started
+		unsigned long int framesDropped; ///< Frames dropped because the queue was full
+		
+		QFile *file; ///< The current output file, only used by the writer thread
+		QDateTime recordingStarted; ///< The time the recording was started
+		QDateTime fileStarted; ///< The time the current file was created
+		unsigned int fileIndex; ///< Number of the current file of the recording
+		
+		QTimer *statusTimer; ///< Reports the counters every second
+	
+	public slots:
+		bool startRecording();
+		void stopRecording();
+		void record();
+	
+	protected slots:
+		void reportStatus();
+	
+	signals:
+		void recordingStopped(); ///< The recording was stopped, also after write errors
+		void statusChanged(unsigned int queueDepth, unsigned long int written, unsigned long int dropped); ///< The queue depth and the frame counters
+		void statusMessage(const QString &message, int timeout); ///< Status message about the recording
+};
+
+
+#endif
@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  renderscheduler.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <QTimer>
+
+
+#include "renderscheduler.h"
+
+#include "glgenerator.h"
+#include "glscope.h"
+#include "settings.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class RenderScheduler
+/// \brief Initializes the timers.
+/// \param settings The settings that should be used.
+/// \param parent The parent object.
+RenderScheduler::RenderScheduler(DsoSettings *settings, QObject *parent) : QObject(parent) {
+	this->settings = settings;
+	
+	this->generator = 0;
+	this->frameRequested = false;
+	this->redrawRequested = false;
+	this->framesShown = 0;
+	this->framesSkipped = 0;
+	this->reportedShown = 0;
+	this->reportedSkipped = 0;
+	
+	this->renderTimer = new QTimer(this);
+	this->renderTimer->setSingleShot(true);
+	connect(this->renderTimer, SIGNAL(timeout()), this, SLOT(render()));
+	
+	this->statisticsTimer = new QTimer(this);
+	this->statisticsTimer->setInterval(1000);
+	connect(this->statisticsTimer, SIGNAL(timeout()), this, SLOT(reportFrames()));
+	this->statisticsTimer->start();
+}
+
+/// \brief Cleans up.
+RenderScheduler::~RenderScheduler() {
+}
+
+/// \brief Set the generator that gets the rendering requests for new data.
+/// \param generator Pointer to the GlGenerator class.
+void RenderScheduler::setGenerator(GlGenerator *generator) {
+	if(this->generator)
+		disconnect(this->generator, SIGNAL(graphsGenerated()), this, SLOT(graphsGenerated()));
+	this->generator = generator;
+	connect(this->generator, SIGNAL(graphsGenerated()), this, SLOT(graphsGenerated()));
+}
+
+/// \brief Add a scope that should be redrawn.
+/// \param scope Pointer to the GlScope.
+void RenderScheduler::addScope(GlScope *scope) {
+	this->scopes.append(scope);
+}
+
+/// \brief Get the number of frames the graphs were generated for.
+/// \return The total number of shown frames.
+unsigned long int RenderScheduler::getFramesShown() const {
+	return this->framesShown;
+}
+
+/// \brief Get the number of analyzed frames that were never shown.
+/// \return The total number of skipped frames.
+unsigned long int RenderScheduler::getFramesSkipped() const {
+	return this->framesSkipped;
+}
+
+/// \brief Render now or start the timer for the next frame.
+void RenderScheduler::schedule() {
+	// The waiting requests are handled together
+	if(this->renderTimer->isActive())
+		return;
+	
+	int interval = (this->settings->view.frameRate > 0) ? 1000 / this->settings->view.frameRate : 0;
+	int elapsed = this->lastFrame.isNull() ? interval : this->lastFrame.elapsed();
+	if(elapsed < interval)
+		this->renderTimer->start(interval - elapsed);
+	else
+		this->render();
+}
+
+/// \brief Request the graphs for newly analyzed data.
+/// Connected to the finished signal of the data analyzer.
+void RenderScheduler::requestFrame() {
+	// The waiting frame will never be shown, the generator uses the newest data
+	if(this->frameRequested)
+		this->framesSkipped++;
+	this->frameRequested = true;
+	
+	this->schedule();
+}
+
+/// \brief Request a redraw of the scopes without new data.
+/// Used if only the view settings or the markers were changed.
+void RenderScheduler::requestRedraw() {
+	this->redrawRequested = true;
+	
+	this->schedule();
+}
+
+/// \brief Generate the graphs or redraw the scopes for the waiting requests.
+void RenderScheduler::render() {
+	this->lastFrame.start();
+	
+	if(this->frameRequested && this->generator) {
+		// The scopes are redrawn when the graphs were generated, a request the generator didn't start yet is replaced
+		if(!this->generator->generateGraphs())
+			this->framesSkipped++;
+	}
+	else if(this->redrawRequested) {
+		for(int scope = 0; scope < this->scopes.count(); scope++) {
+			if(this->scopes[scope]->isVisible())
+				this->scopes[scope]->updateGL();
+		}
+	}
+	
+	this->frameRequested = false;
+	this->redrawRequested = false;
+}
+
+/// \brief Count the frame whose graphs were generated.
+void RenderScheduler::graphsGenerated() {
+	this->framesShown++;
+}
+
+/// \brief Emit the frame counters of the last second.
+void RenderScheduler::reportFrames() {
+	emit framesCounted(this->framesShown - this->reportedShown, this->framesSkipped - this->reportedSkipped);
+	
+	this->reportedShown = this->framesShown;
+	this->reportedSkipped = this->framesSkipped;
+}
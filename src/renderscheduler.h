@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file renderscheduler.h
+/// \brief Declares the RenderScheduler class.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef RENDERSCHEDULER_H
+#define RENDERSCHEDULER_H
+
+
+#include <QList>
+#include <QObject>
+#include <QTime>
+
+
+class DsoSettings;
+class GlGenerator;
+class GlScope;
+class QTimer;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class RenderScheduler                                     renderscheduler.h
+/// \brief Limits the generated and drawn frames to the configured frame rate.
+/// New data and redraw requests that arrive faster than the frame rate are
+/// combined, the graphs are only generated for the newest analyzed data.
+class RenderScheduler : public QObject {
+	Q_OBJECT
+	
+	public:
+		RenderScheduler(DsoSettings *settings, QObject *parent = 0);
+		~RenderScheduler();
+		
+		void setGenerator(GlGenerator *generator);
+		void addScope(GlScope *scope);
+		
+		unsigned long int getFramesShown() const;
+		unsigned long int getFramesSkipped() const;
+	
+	protected:
+		void schedule();
+		
+		DsoSettings *settings; ///< The settings provided by the parent class
+		GlGenerator *generator; ///< The generator for the graphs
+		QList<GlScope *> scopes; ///< The scopes that are redrawn
+		
+		QTimer *renderTimer; ///< Delays requests until the next frame is due
+		QTimer *statisticsTimer; ///< Reports the frame counters every second
+		QTime lastFrame; ///< The time the last frame was rendered
+		bool frameRequested; ///< true if new data is waiting for the generator
+		bool redrawRequested; ///< true if the scopes have to be redrawn
+		
+		unsigned long int framesShown; ///< Number of frames the graphs were generated for
+		unsigned long int framesSkipped; ///< Number of analyzed frames that were replaced by newer ones
+		unsigned long int reportedShown; ///< Value of #framesShown at the last report
+		unsigned long int reportedSkipped; ///< Value of #framesSkipped at the last report
+	
+	public slots:
+		void requestFrame();
+		void requestRedraw();
+	
+	protected slots:
+		void render();
+		void graphsGenerated();
+		void reportFrames();
+	
+	signals:
+		void framesCounted(unsigned int shown, unsigned int skipped); ///< The frames shown and skipped during the last second
+};
+
+
+#endif
@@ -0,0 +1,375 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  samplecodec.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <algorithm>
+#include <cstring>
+
+#include <QByteArray>
+#include <QFuture>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrentRun>
+
+
+#include "samplecodec.h"
+
+
+#define CODEC_HASH_SIZE (1 << CODEC_HASH_BITS) ///< Number of slots in the level hash table
+#define CODEC_SIGN_BIT Q_UINT64_C(0x8000000000000000) ///< Sign bit of a double
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct CodecPackSlice                                       samplecodec.cpp
+/// \brief A range of blocks that is packed by one thread.
+struct CodecPackSlice {
+	unsigned int firstBlock; ///< The first block of the slice
+	unsigned int blockCount; ///< Number of blocks in the slice
+	unsigned int valueCount; ///< Number of values in the whole array
+	quint16 *codes; ///< The hash slots of all values, replaced by the level indices
+	const int *levelIndex; ///< The level index of each hash slot
+	uchar *output; ///< Each block is packed into its own #CODEC_BLOCK_BYTES
+	quint32 *sizes; ///< The packed size of each block
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct CodecUnpackSlice                                     samplecodec.cpp
+/// \brief A range of blocks that is unpacked by one thread.
+struct CodecUnpackSlice {
+	unsigned int firstBlock; ///< The first block of the slice
+	unsigned int blockCount; ///< Number of blocks in the slice
+	unsigned int valueCount; ///< Number of values in the whole array
+	const uchar *blocks; ///< The packed blocks
+	const quint32 *offsets; ///< The position of each block and the end of the last one
+	const double *levels; ///< The level table
+	unsigned int levelCount; ///< Number of entries in the level table
+	double *values; ///< The unpacked values of the whole array
+	bool success; ///< false if a block was malformed
+};
+
+/// \brief Maps a difference to an unsigned value, small magnitudes stay small.
+/// \param delta The difference of two level indices.
+/// \return 0, 1, 2, 3, 4 ... for 0, -1, 1, -2, 2 ...
+static inline unsigned int zigzag(int delta) {
+	return (delta < 0) ? ((unsigned int) -delta << 1) - 1 : (unsigned int) delta << 1;
+}
+
+/// \brief Reverts zigzag().
+/// \param value The unsigned value.
+/// \return The difference of two level indices.
+static inline int unzigzag(unsigned int value) {
+	return (value & 1) ? -(int) ((value + 1) >> 1) : (int) (value >> 1);
+}
+
+/// \brief Maps the bits of a double to an integer with the same order.
+/// \param bits The bits of the double.
+/// \return Integer that sorts like the double value.
+static inline quint64 orderKey(quint64 bits) {
+	return (bits & CODEC_SIGN_BIT) ? ~bits : bits | CODEC_SIGN_BIT;
+}
+
+/// \brief Reverts orderKey().
+/// \param key Integer that sorts like the double value.
+/// \return The bits of the double.
+static inline quint64 orderBits(quint64 key) {
+	return (key & CODEC_SIGN_BIT) ? key & ~CODEC_SIGN_BIT : ~key;
+}
+
+/// \brief Finds the hash slot of a value.
+/// \param keys The bits of the value in each used slot.
+/// \param used true for each used slot.
+/// \param key The bits of the value.
+/// \return The slot that contains the value or the free slot for it.
+static inline unsigned int findSlot(const quint64 *keys, const bool *used, quint64 key) {
+	unsigned int slot = (unsigned int) ((key * Q_UINT64_C(0x9e3779b97f4a7c15)) >> (64 - CODEC_HASH_BITS));
+	while(used[slot] && keys[slot] != key)
+		slot = (slot + 1) & (CODEC_HASH_SIZE - 1);
+	
+	return slot;
+}
+
+/// \brief Get the number of threads for an array.
+/// \param blockCount The number of blocks in the array.
+/// \return The number of threads, at least 1.
+static unsigned int threadCount(unsigned int blockCount) {
+	unsigned int threads = blockCount / CODEC_PARALLEL_BLOCKS;
+	if(threads > (unsigned int) QThread::idealThreadCount())
+		threads = QThread::idealThreadCount();
+	if(threads < 1)
+		threads = 1;
+	
+	return threads;
+}
+
+/// \brief Packs the blocks of a slice.
+/// Each block starts with the bit width of its differences and the level index
+/// of its first value, followed by the differences, least significant bit
+/// first.
+/// \param slice The blocks that should be packed.
+static void packSlice(CodecPackSlice *slice) {
+	for(unsigned int block = slice->firstBlock; block < slice->firstBlock + slice->blockCount; block++) {
+		unsigned int start = block * CODEC_BLOCK_SIZE;
+		unsigned int end = qMin(start + CODEC_BLOCK_SIZE, slice->valueCount);
+		quint16 *codes = slice->codes;
+		
+		// Get the level indices and the width of the largest difference
+		unsigned int combined = 0;
+		codes[start] = slice->levelIndex[codes[start]];
+		for(unsigned int position = start + 1; position < end; position++) {
+			codes[position] = slice->levelIndex[codes[position]];
+			combined |= zigzag((int) codes[position] - codes[position - 1]);
+		}
+		unsigned int width = 0;
+		while(combined >> width)
+			width++;
+		
+		uchar *output = slice->output + block * CODEC_BLOCK_BYTES;
+		output[0] = width;
+		output[1] = codes[start] & 0xff;
+		output[2] = codes[start] >> 8;
+		
+		uchar *target = output + 3;
+		quint64 buffer = 0;
+		unsigned int bits = 0;
+		for(unsigned int position = start + 1; position < end; position++) {
+			buffer |= (quint64) zigzag((int) codes[position] - codes[position - 1]) << bits;
+			bits += width;
+			while(bits >= 8) {
+				*(target++) = buffer;
+				buffer >>= 8;
+				bits -= 8;
+			}
+		}
+		if(bits)
+			*(target++) = buffer;
+		
+		slice->sizes[block] = target - output;
+	}
+}
+
+/// \brief Unpacks the blocks of a slice.
+/// The blocks are checked, so malformed data can't write outside the values.
+/// \param slice The blocks that should be unpacked.
+static void unpackSlice(CodecUnpackSlice *slice) {
+	slice->success = false;
+	
+	for(unsigned int block = slice->firstBlock; block < slice->firstBlock + slice->blockCount; block++) {
+		unsigned int start = block * CODEC_BLOCK_SIZE;
+		unsigned int end = qMin(start + CODEC_BLOCK_SIZE, slice->valueCount);
+		const uchar *input = slice->blocks + slice->offsets[block];
+		quint32 size = slice->offsets[block + 1] - slice->offsets[block];
+		
+		if(size < 3)
+			return;
+		unsigned int width = input[0];
+		if(width > 16 || size != 3 + ((end - start - 1) * width + 7) / 8)
+			return;
+		unsigned int code = input[1] | (input[2] << 8);
+		if(code >= slice->levelCount)
+			return;
+		slice->values[start] = slice->levels[code];
+		
+		input += 3;
+		quint64 buffer = 0;
+		unsigned int bits = 0;
+		unsigned int mask = (1 << width) - 1;
+		for(unsigned int position = start + 1; position < end; position++) {
+			while(bits < width) {
+				buffer |= (quint64) *(input++) << bits;
+				bits += 8;
+			}
+			code += unzigzag(buffer & mask);
+			buffer >>= width;
+			bits -= width;
+			
+			if(code >= slice->levelCount)
+				return;
+			slice->values[position] = slice->levels[code];
+		}
+	}
+	
+	slice->success = true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class SampleCodec
+/// \brief Packs an array of values.
+/// \param values The values that should be packed.
+/// \param count The number of values.
+/// \param packed The packed values are written into this array.
+/// \return false if there are too many distinct values or packing doesn't save space.
+bool SampleCodec::encode(const double *values, unsigned int count, QByteArray *packed) {
+	if(!count)
+		return false;
+	
+	// Collect the distinct values, the codes are the hash slots for now
+	QVector<quint64> keys(CODEC_HASH_SIZE);
+	QVector<bool> used(CODEC_HASH_SIZE, false);
+	QVector<quint64> levels;
+	levels.reserve(CODEC_MAX_LEVELS);
+	QVector<quint16> codes(count);
+	for(unsigned int position = 0; position < count; position++) {
+		quint64 key;
+		memcpy(&key, values + position, sizeof(key));
+		unsigned int slot = findSlot(keys.constData(), used.constData(), key);
+		if(!used[slot]) {
+			if(levels.count() == CODEC_MAX_LEVELS)
+				return false;
+			keys[slot] = key;
+			used[slot] = true;
+			levels.append(orderKey(key));
+		}
+		codes[position] = slot;
+	}
+	
+	// Sort the levels by value, so neighboring levels get neighboring indices
+	std::sort(levels.begin(), levels.end());
+	QVector<int> levelIndex(CODEC_HASH_SIZE);
+	for(int level = 0; level < levels.count(); level++) {
+		levels[level] = orderBits(levels[level]);
+		levelIndex[findSlot(keys.constData(), used.constData(), levels[level])] = level;
+	}
+	
+	// Pack the blocks, large arrays are split between multiple threads
+	unsigned int blockCount = (count + CODEC_BLOCK_SIZE - 1) / CODEC_BLOCK_SIZE;
+	QVector<uchar> output(blockCount * CODEC_BLOCK_BYTES);
+	QVector<quint32> sizes(blockCount);
+	
+	unsigned int threads = threadCount(blockCount);
+	QVector<CodecPackSlice> slices(threads);
+	unsigned int sliceBlocks = blockCount / threads;
+	for(unsigned int thread = 0; thread < threads; thread++) {
+		slices[thread].firstBlock = thread * sliceBlocks;
+		slices[thread].blockCount = (thread == threads - 1) ? blockCount - slices[thread].firstBlock : sliceBlocks;
+		slices[thread].valueCount = count;
+		slices[thread].codes = codes.data();
+		slices[thread].levelIndex = levelIndex.constData();
+		slices[thread].output = output.data();
+		slices[thread].sizes = sizes.data();
+	}
+	
+	QList<QFuture<void> > futures;
+	for(unsigned int thread = 1; thread < threads; thread++)
+		futures.append(QtConcurrent::run(packSlice, &slices[thread]));
+	packSlice(&slices[0]);
+	for(int index = 0; index < futures.count(); index++)
+		futures[index].waitForFinished();
+	
+	// Assemble the header, the tables and the blocks
+	quint64 tableSize = sizeof(SampleCodecHeader) + levels.count() * sizeof(double) + (blockCount + 1) * sizeof(quint32);
+	quint64 packedSize = tableSize;
+	for(unsigned int block = 0; block < blockCount; block++)
+		packedSize += sizes[block];
+	if(packedSize >= (quint64) count * sizeof(double))
+		return false;
+	
+	packed->resize(packedSize);
+	uchar *data = (uchar *) packed->data();
+	SampleCodecHeader header;
+	header.levelCount = levels.count();
+	header.blockCount = blockCount;
+	memcpy(data, &header, sizeof(header));
+	data += sizeof(header);
+	memcpy(data, levels.constData(), levels.count() * sizeof(double));
+	data += levels.count() * sizeof(double);
+	
+	quint32 offset = 0;
+	for(unsigned int block = 0; block < blockCount; block++) {
+		memcpy(data, &offset, sizeof(offset));
+		data += sizeof(offset);
+		offset += sizes[block];
+	}
+	memcpy(data, &offset, sizeof(offset));
+	data += sizeof(offset);
+	
+	for(unsigned int block = 0; block < blockCount; block++) {
+		memcpy(data, output.constData() + block * CODEC_BLOCK_BYTES, sizes[block]);
+		data += sizes[block];
+	}
+	
+	return true;
+}
+
+/// \brief Unpacks an array of values.
+/// \param packed The packed values.
+/// \param size The size of the packed values in bytes.
+/// \param values The unpacked values are written into this array.
+/// \param count The number of values.
+/// \return false if the packed values are malformed.
+bool SampleCodec::decode(const uchar *packed, quint64 size, double *values, unsigned int count) {
+	if(!count || size < sizeof(SampleCodecHeader))
+		return false;
+	
+	SampleCodecHeader header;
+	memcpy(&header, packed, sizeof(header));
+	unsigned int blockCount = (count + CODEC_BLOCK_SIZE - 1) / CODEC_BLOCK_SIZE;
+	if(header.blockCount != blockCount || !header.levelCount || header.levelCount > CODEC_MAX_LEVELS)
+		return false;
+	
+	quint64 tableSize = sizeof(SampleCodecHeader) + header.levelCount * sizeof(double) + (blockCount + 1) * sizeof(quint32);
+	if(size < tableSize)
+		return false;
+	
+	// Copy the tables, the packed data doesn't have to be aligned
+	QVector<double> levels(header.levelCount);
+	memcpy(levels.data(), packed + sizeof(SampleCodecHeader), header.levelCount * sizeof(double));
+	QVector<quint32> offsets(blockCount + 1);
+	memcpy(offsets.data(), packed + sizeof(SampleCodecHeader) + header.levelCount * sizeof(double), (blockCount + 1) * sizeof(quint32));
+	for(unsigned int block = 0; block < blockCount; block++) {
+		if(offsets[block] > offsets[block + 1])
+			return false;
+	}
+	if(offsets[0] != 0 || offsets[blockCount] > size - tableSize)
+		return false;
+	
+	// Unpack the blocks, large arrays are split between multiple threads
+	unsigned int threads = threadCount(blockCount);
+	QVector<CodecUnpackSlice> slices(threads);
+	unsigned int sliceBlocks = blockCount / threads;
+	for(unsigned int thread = 0; thread < threads; thread++) {
+		slices[thread].firstBlock = thread * sliceBlocks;
+		slices[thread].blockCount = (thread == threads - 1) ? blockCount - slices[thread].firstBlock : sliceBlocks;
+		slices[thread].valueCount = count;
+		slices[thread].blocks = packed + tableSize;
+		slices[thread].offsets = offsets.constData();
+		slices[thread].levels = levels.constData();
+		slices[thread].levelCount = header.levelCount;
+		slices[thread].values = values;
+		slices[thread].success = false;
+	}
+	
+	QList<QFuture<void> > futures;
+	for(unsigned int thread = 1; thread < threads; thread++)
+		futures.append(QtConcurrent::run(unpackSlice, &slices[thread]));
+	unpackSlice(&slices[0]);
+	for(int index = 0; index < futures.count(); index++)
+		futures[index].waitForFinished();
+	
+	for(unsigned int thread = 0; thread < threads; thread++) {
+		if(!slices[thread].success)
+			return false;
+	}
+	
+	return true;
+}
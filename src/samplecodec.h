@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file samplecodec.h
+/// \brief Declares the SampleCodec class.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef SAMPLECODEC_H
+#define SAMPLECODEC_H
+
+
+#include <QtGlobal>
+
+
+#define CODEC_BLOCK_SIZE           4096 ///< Values per independently packed block
+#define CODEC_BLOCK_BYTES (3 + 2 * CODEC_BLOCK_SIZE) ///< Maximum packed size of a block
+#define CODEC_MAX_LEVELS           4096 ///< Maximum number of distinct values per array
+#define CODEC_HASH_BITS              13 ///< Size of the level hash table as power of two
+#define CODEC_PARALLEL_BLOCKS         4 ///< Minimum blocks per worker thread
+
+
+class QByteArray;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct SampleCodecHeader                                      samplecodec.h
+/// \brief The start of a packed value array.
+/// It's followed by the level table with the distinct values in ascending
+/// order, the offsets of the blocks relative to the end of the offset table and
+/// the blocks themselves.
+struct SampleCodecHeader {
+	quint32 levelCount; ///< Number of entries in the level table
+	quint32 blockCount; ///< Number of packed blocks
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class SampleCodec                                             samplecodec.h
+/// \brief Lossless compression for arrays with few distinct values.
+/// The samples of the oscilloscope are converted from 8 or 10 bit ADC codes,
+/// so a frame only contains a few hundred distinct values. These levels are
+/// stored once, the samples are replaced by their index in the level table.
+/// The differences of consecutive indices are bit-packed in blocks of
+/// #CODEC_BLOCK_SIZE values with the width needed by the largest difference of
+/// the block. The blocks don't depend on each other, so large arrays are
+/// packed and unpacked by multiple threads.
+class SampleCodec {
+	public:
+		static bool encode(const double *values, unsigned int count, QByteArray *packed);
+		static bool decode(const uchar *packed, quint64 size, double *values, unsigned int count);
+};
+
+
+#endif
@@ -0,0 +1,568 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  scopeserver.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cstring>
+
+#include <QBuffer>
+#include <QHostAddress>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QMutex>
+#include <QStringList>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+
+#include "scopeserver.h"
+
+#include "capturefile.h"
+#include "dataanalyzer.h"
+#include "settings.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class ScopeServer
+/// \brief Initializes the server, it doesn't listen until listen() is called.
+/// \param settings The settings that are queried and changed by the clients.
+/// \param dataAnalyzer The analyzer whose frames are sent to the clients.
+/// \param parent The parent object.
+ScopeServer::ScopeServer(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QObject *parent) : QObject(parent) {
+	this->settings = settings;
+	this->dataAnalyzer = dataAnalyzer;
+	
+	this->localServer = 0;
+	this->tcpServer = 0;
+	this->tcpPort = 0;
+	
+	this->record = new CaptureRecord();
+	this->frames = 0;
+	this->sampling = false;
+}
+
+/// \brief Disconnects all clients and stops listening.
+ScopeServer::~ScopeServer() {
+	this->close();
+	
+	delete this->record;
+}
+
+/// \brief Starts listening for clients, stops the previous servers first.
+/// \param name The name of the local socket, empty to disable it.
+/// \param port The TCP port on the loopback interface, 0 to disable it.
+/// \return false if one of the servers couldn't be started.
+bool ScopeServer::listen(const QString &name, unsigned int port) {
+	this->close();
+	
+	bool success = true;
+	
+	if(!name.isEmpty()) {
+		this->localServer = new QLocalServer(this);
+		connect(this->localServer, SIGNAL(newConnection()), this, SLOT(newLocalConnection()));
+		
+		bool listening = this->localServer->listen(name);
+		// The socket file of a crashed instance is still there
+		if(!listening && this->localServer->serverError() == QAbstractSocket::AddressInUseError) {
+			QLocalServer::removeServer(name);
+			listening = this->localServer->listen(name);
+		}
+		if(!listening) {
+			emit statusMessage(tr("Can't listen on %1: %2").arg(name, this->localServer->errorString()), 0);
+			delete this->localServer;
+			this->localServer = 0;
+			success = false;
+		}
+	}
+	
+	if(port) {
+		this->tcpServer = new QTcpServer(this);
+		connect(this->tcpServer, SIGNAL(newConnection()), this, SLOT(newTcpConnection()));
+		
+		// Only local clients are accepted, the protocol has no authentication
+		if(!this->tcpServer->listen(QHostAddress::LocalHost, port)) {
+			emit statusMessage(tr("Can't listen on port %1: %2").arg(port).arg(this->tcpServer->errorString()), 0);
+			delete this->tcpServer;
+			this->tcpServer = 0;
+			success = false;
+		}
+	}
+	
+	this->localName = name;
+	this->tcpPort = port;
+	
+	return success;
+}
+
+/// \brief Disconnects all clients and stops listening.
+void ScopeServer::close() {
+	while(!this->clients.isEmpty()) {
+		ServerClient *client = this->clients.takeLast();
+		disconnect(client->socket, 0, this, 0);
+		client->socket->close();
+		client->socket->deleteLater();
+		delete client;
+	}
+	
+	delete this->localServer;
+	this->localServer = 0;
+	delete this->tcpServer;
+	this->tcpServer = 0;
+	
+	this->localName.clear();
+	this->tcpPort = 0;
+}
+
+/// \brief Get the number of connected clients.
+/// \return The number of clients.
+unsigned int ScopeServer::getClientCount() const {
+	return this->clients.count();
+}
+
+/// \brief Finds the client a socket belongs to.
+/// \param socket The socket of the client.
+/// \return The client, 0 if the socket is unknown.
+ServerClient *ScopeServer::findClient(QObject *socket) const {
+	for(int index = 0; index < this->clients.count(); index++)
+		if(this->clients[index]->socket == socket)
+			return this->clients[index];
+	
+	return 0;
+}
+
+/// \brief Adds a newly connected client.
+/// \param socket The socket of the client, the server takes ownership of it.
+void ScopeServer::addClient(QIODevice *socket) {
+	ServerClient *client = new ServerClient;
+	client->socket = socket;
+	client->frameDecimation = 0;
+	client->packed = false;
+	client->measurementDecimation = 0;
+	client->dropped = 0;
+	this->clients.append(client);
+	
+	socket->setParent(this);
+	connect(socket, SIGNAL(readyRead()), this, SLOT(readCommands()));
+	connect(socket, SIGNAL(disconnected()), this, SLOT(clientDisconnected()));
+}
+
+/// \brief Executes a command line and sends the reply to the client.
+/// \param client The client that sent the command.
+/// \param line The command line without line break.
+void ScopeServer::execute(ServerClient *client, const QByteArray &line) {
+	QStringList words = QString::fromUtf8(line.constData(), line.size()).simplified().split(' ', QString::SkipEmptyParts);
+	if(words.isEmpty())
+		return;
+	
+	QString command = words.takeFirst().toLower();
+	QString reply;
+	bool ok = true;
+	
+	if(command == "get") {
+		// Without key all values are listed
+		if(words.isEmpty())
+			words = this->getKeys();
+		
+		reply = "OK";
+		for(int index = 0; index < words.count(); index++) {
+			QString value = this->getValue(words[index]);
+			if(value.isNull()) {
+				reply = QString("ERR Unknown key %1").arg(words[index]);
+				break;
+			}
+			reply += QString("\n%1=%2").arg(words[index], value);
+		}
+	}
+	else if(command == "set") {
+		if(words.count() != 2)
+			reply = "ERR Usage: set KEY VALUE";
+		else
+			reply = this->setValue(words[0], words[1]);
+	}
+	else if(command == "frames" || command == "measurements") {
+		unsigned int decimation = 1;
+		bool packed = false;
+		if(!words.isEmpty())
+			decimation = words.takeFirst().toUInt(&ok);
+		if(ok && command == "frames" && !words.isEmpty())
+			packed = ok = (words.takeFirst() == "packed");
+		
+		if(!ok || !words.isEmpty())
+			reply = QString("ERR Usage: %1").arg(command == "frames" ? "frames [DECIMATION] [packed]" : "measurements [DECIMATION]");
+		else {
+			if(command == "frames") {
+				client->frameDecimation = decimation;
+				client->packed = packed;
+			}
+			else
+				client->measurementDecimation = decimation;
+			reply = "OK";
+		}
+	}
+	else if(command == "start") {
+		emit startRequested();
+		reply = "OK";
+	}
+	else if(command == "stop") {
+		emit stopRequested();
+		reply = "OK";
+	}
+	else if(command == "help") {
+		reply = "OK\n"
+				"get [KEY]...                  Show the values of the keys or all values\n"
+				"set KEY VALUE                 Change a setting, enumerations are numbers\n"
+				"frames [DECIMATION] [packed]  Send every nth frame, 0 stops the frames\n"
+				"measurements [DECIMATION]     Send every nth measurement, 0 stops them\n"
+				"start                         Start the sampling\n"
+				"stop                          Stop the sampling";
+	}
+	else
+		reply = QString("ERR Unknown command %1").arg(command);
+	
+	this->sendMessage(client, SERVER_MESSAGE_REPLY, reply.toUtf8());
+}
+
+/// \brief Lists the keys of all values that can be queried.
+/// \return The keys in the order they are listed.
+QStringList ScopeServer::getKeys() const {
+	QStringList keys;
+	keys << "model" << "channels" << "samplerate" << "samples" << "sampling" << "timebase" << "trigger.mode" << "trigger.slope" << "trigger.special" << "trigger.source" << "trigger.position" << "math.mode";
+	
+	for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
+		QString prefix = QString("channel.%1.").arg(channel);
+		keys << prefix + "name" << prefix + "used" << prefix + "gain" << prefix + "offset" << prefix + "level";
+		if(channel < (int) this->settings->scope.physicalChannels)
+			keys << prefix + "coupling";
+	}
+	
+	return keys;
+}
+
+/// \brief Formats a value for a client.
+/// \param key The key of the value, see getKeys().
+/// \return The value as text, a null string if the key is unknown.
+QString ScopeServer::getValue(const QString &key) const {
+	const DsoSettingsScope &scope = this->settings->scope;
+	
+	if(key == "model")
+		return scope.model.isNull() ? QString("") : scope.model;
+	else if(key == "channels")
+		return QString::number(scope.physicalChannels);
+	else if(key == "samplerate")
+		return QString::number((qulonglong) scope.horizontal.samplerate);
+	else if(key == "samples")
+		return QString::number((qulonglong) scope.horizontal.samples);
+	else if(key == "sampling")
+		return QString::number(this->sampling);
+	else if(key == "timebase")
+		return QString::number(scope.horizontal.timebase, 'g', 17);
+	else if(key == "trigger.mode")
+		return QString::number(scope.trigger.mode);
+	else if(key == "trigger.slope")
+		return QString::number(scope.trigger.slope);
+	else if(key == "trigger.special")
+		return QString::number(scope.trigger.special);
+	else if(key == "trigger.source")
+		return QString::number(scope.trigger.source);
+	else if(key == "trigger.position")
+		return QString::number(scope.trigger.position, 'g', 17);
+	else if(key == "math.mode")
+		return QString::number(scope.voltage[scope.physicalChannels].misc);
+	
+	// Channel values are named channel.N.field
+	QStringList parts = key.split('.');
+	if(parts.count() != 3 || parts[0] != "channel")
+		return QString();
+	bool ok;
+	int channel = parts[1].toInt(&ok);
+	if(!ok || channel < 0 || channel >= scope.voltage.count())
+		return QString();
+	const DsoSettingsScopeVoltage &voltage = scope.voltage[channel];
+	
+	if(parts[2] == "name")
+		return voltage.name;
+	else if(parts[2] == "used")
+		return QString::number(voltage.used);
+	else if(parts[2] == "gain")
+		return QString::number(voltage.gain, 'g', 17);
+	else if(parts[2] == "offset")
+		return QString::number(voltage.offset, 'g', 17);
+	else if(parts[2] == "level")
+		return QString::number(voltage.trigger, 'g', 17);
+	else if(parts[2] == "coupling" && channel < (int) scope.physicalChannels)
+		return QString::number(voltage.misc);
+	
+	return QString();
+}
+
+/// \brief Requests a new value for a setting.
+/// The request signals are handled synchronously, the setting is unchanged
+/// afterwards if nobody accepted the value.
+/// \param key The key of the value, see getKeys().
+/// \param value The new value as text.
+/// \return The reply for the client.
+QString ScopeServer::setValue(const QString &key, const QString &value) {
+	DsoSettingsScope &scope = this->settings->scope;
+	
+	QString current = this->getValue(key);
+	if(current.isNull())
+		return QString("ERR Unknown key %1").arg(key);
+	
+	bool ok;
+	double number = value.toDouble(&ok);
+	if(!ok)
+		return QString("ERR Invalid value %1").arg(value);
+	unsigned int index = (unsigned int) number;
+	bool valid = number >= 0 && number == index;
+	bool applied = false;
+	
+	if(key == "timebase") {
+		emit timebaseRequested(number);
+		applied = scope.horizontal.timebase == number;
+	}
+	else if(key == "trigger.mode") {
+		if(valid && index < Dso::TRIGGERMODE_COUNT)
+			emit triggerModeRequested((Dso::TriggerMode) index);
+		applied = valid && scope.trigger.mode == (Dso::TriggerMode) index;
+	}
+	else if(key == "trigger.slope") {
+		if(valid && index < Dso::SLOPE_COUNT)
+			emit triggerSlopeRequested((Dso::Slope) index);
+		applied = valid && scope.trigger.slope == (Dso::Slope) index;
+	}
+	else if(key == "trigger.source") {
+		if(valid && index < scope.physicalChannels)
+			emit triggerSourceRequested(false, index);
+		applied = valid && !scope.trigger.special && scope.trigger.source == index;
+	}
+	else if(key == "math.mode") {
+		if(valid && index < Dso::MATHMODE_COUNT)
+			emit mathModeRequested((Dso::MathMode) index);
+		applied = valid && scope.voltage[scope.physicalChannels].misc == (int) index;
+	}
+	else {
+		QStringList parts = key.split('.');
+		if(parts.count() != 3)
+			return QString("ERR Key %1 is read-only").arg(key);
+		int channel = parts[1].toInt();
+		
+		if(parts[2] == "used") {
+			if(valid && index <= 1)
+				emit usedRequested(channel, index == 1);
+			applied = valid && scope.voltage[channel].used == (index == 1);
+		}
+		else if(parts[2] == "gain") {
+			emit gainRequested(channel, number);
+			applied = scope.voltage[channel].gain == number;
+		}
+		else if(parts[2] == "coupling") {
+			if(valid && index < Dso::COUPLING_COUNT)
+				emit couplingRequested(channel, (Dso::Coupling) index);
+			applied = valid && scope.voltage[channel].misc == (int) index;
+		}
+		else
+			return QString("ERR Key %1 is read-only").arg(key);
+	}
+	
+	if(!applied)
+		return QString("ERR Value %1 not applied, %2=%3").arg(value, key, this->getValue(key));
+	
+	return QString("OK\n%1=%2").arg(key, this->getValue(key));
+}
+
+/// \brief Sends a message to a client.
+/// \param client The receiving client.
+/// \param type The type of the payload.
+/// \param payload The contents of the message.
+void ScopeServer::sendMessage(ServerClient *client, ServerMessageType type, const QByteArray &payload) {
+	ServerMessage message;
+	memcpy(message.magic, SERVER_MAGIC, sizeof(message.magic));
+	message.type = type;
+	message.size = payload.size();
+	message.frame = this->frames;
+	message.dropped = client->dropped;
+	message.reserved = 0;
+	client->dropped = 0;
+	
+	client->socket->write((const char *) &message, sizeof(message));
+	client->socket->write(payload);
+}
+
+/// \brief Writes a record into memory.
+/// \param record The prepared record.
+/// \return The record in the capture file layout.
+QByteArray ScopeServer::serialize(const CaptureRecord *record) {
+	QByteArray data;
+	data.reserve(record->header.recordSize);
+	
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::WriteOnly);
+	CaptureFile::writeRecord(&buffer, record);
+	buffer.close();
+	
+	return data;
+}
+
+/// \brief Starts or stops listening after the server options have changed.
+void ScopeServer::applySettings() {
+	QString name;
+	unsigned int port = 0;
+	if(this->settings->options.server.enabled) {
+		name = this->settings->options.server.name;
+		port = this->settings->options.server.port;
+	}
+	
+	// Keep the clients connected if nothing changed
+	if(name == this->localName && port == this->tcpPort)
+		return;
+	
+	if(name.isEmpty() && !port)
+		this->close();
+	else
+		this->listen(name, port);
+}
+
+/// \brief Sends the analyzed frame to the subscribed clients.
+/// The frame is serialized only once for all clients that want it.
+/// \param samples The number of analyzed samples.
+void ScopeServer::analyzed(unsigned int samples) {
+	Q_UNUSED(samples);
+	
+	this->frames++;
+	
+	QList<ServerClient *> frameClients, packedClients, measurementClients;
+	for(int index = 0; index < this->clients.count(); index++) {
+		ServerClient *client = this->clients[index];
+		bool frameDue = client->frameDecimation && this->frames % client->frameDecimation == 0;
+		bool measurementDue = client->measurementDecimation && this->frames % client->measurementDecimation == 0;
+		if(!frameDue && !measurementDue)
+			continue;
+		
+		// Slow clients lose messages instead of filling up the memory
+		if(client->socket->bytesToWrite() > SERVER_BACKLOG) {
+			client->dropped += frameDue + measurementDue;
+			continue;
+		}
+		
+		if(frameDue) {
+			if(client->packed)
+				packedClients.append(client);
+			else
+				frameClients.append(client);
+		}
+		if(measurementDue)
+			measurementClients.append(client);
+	}
+	if(frameClients.isEmpty() && packedClients.isEmpty() && measurementClients.isEmpty())
+		return;
+	
+	QByteArray frame, packedFrame, measurements;
+	
+	this->dataAnalyzer->mutex()->lock();
+	if(!frameClients.isEmpty() || !packedClients.isEmpty()) {
+		CaptureFile::collect(this->settings, this->dataAnalyzer, this->record, false);
+		if(!frameClients.isEmpty())
+			frame = serialize(this->record);
+		// Packing replaces the values of the record
+		if(!packedClients.isEmpty()) {
+			CaptureFile::pack(this->record);
+			packedFrame = serialize(this->record);
+		}
+	}
+	if(!measurementClients.isEmpty()) {
+		for(int channel = 0; channel < this->settings->scope.voltage.count(); channel++) {
+			const AnalyzedData *analyzedData = this->dataAnalyzer->data(channel);
+			if(!this->settings->scope.voltage[channel].used || !analyzedData)
+				continue;
+			
+			ServerMeasurement measurement;
+			measurement.channel = channel;
+			measurement.reserved = 0;
+			measurement.amplitude = analyzedData->amplitude;
+			measurement.frequency = analyzedData->frequency;
+			measurements.append((const char *) &measurement, sizeof(measurement));
+		}
+	}
+	this->dataAnalyzer->mutex()->unlock();
+	
+	for(int index = 0; index < frameClients.count(); index++)
+		this->sendMessage(frameClients[index], SERVER_MESSAGE_FRAME, frame);
+	for(int index = 0; index < packedClients.count(); index++)
+		this->sendMessage(packedClients[index], SERVER_MESSAGE_FRAME, packedFrame);
+	for(int index = 0; index < measurementClients.count(); index++)
+		this->sendMessage(measurementClients[index], SERVER_MESSAGE_MEASUREMENTS, measurements);
+}
+
+/// \brief The oscilloscope has started sampling.
+void ScopeServer::samplingStarted() {
+	this->sampling = true;
+}
+
+/// \brief The oscilloscope has stopped sampling.
+void ScopeServer::samplingStopped() {
+	this->sampling = false;
+}
+
+/// \brief Accepts the pending local socket connections.
+void ScopeServer::newLocalConnection() {
+	while(this->localServer->hasPendingConnections())
+		this->addClient(this->localServer->nextPendingConnection());
+}
+
+/// \brief Accepts the pending TCP connections.
+void ScopeServer::newTcpConnection() {
+	while(this->tcpServer->hasPendingConnections())
+		this->addClient(this->tcpServer->nextPendingConnection());
+}
+
+/// \brief Executes the complete command lines a client has sent.
+void ScopeServer::readCommands() {
+	ServerClient *client = this->findClient(this->sender());
+	if(!client)
+		return;
+	
+	client->input.append(client->socket->readAll());
+	
+	int end;
+	while((end = client->input.indexOf('\n')) != -1) {
+		QByteArray line = client->input.left(end);
+		client->input.remove(0, end + 1);
+		this->execute(client, line);
+	}
+	
+	// Don't buffer endless garbage
+	if(client->input.size() > SERVER_LINE_LENGTH) {
+		client->input.clear();
+		this->sendMessage(client, SERVER_MESSAGE_REPLY, "ERR Line too long");
+	}
+}
+
+/// \brief Removes a client that has closed the connection.
+void ScopeServer::clientDisconnected() {
+	ServerClient *client = this->findClient(this->sender());
+	if(!client)
+		return;
+	
+	this->clients.removeAll(client);
+	client->socket->deleteLater();
+	delete client;
+}
@@ -0,0 +1,170 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file scopeserver.h
+/// \brief Declares the ScopeServer class.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef SCOPESERVER_H
+#define SCOPESERVER_H
+
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QtGlobal>
+
+
+#include "dso.h"
+
+
+#define SERVER_MAGIC             "OHSV" ///< Identifies server messages, without the terminating null
+#define SERVER_BACKLOG         16777216 ///< Unsent bytes of a client that cause messages to be dropped
+#define SERVER_LINE_LENGTH         4096 ///< Maximum length of a command line in bytes
+
+
+class QIODevice;
+class QLocalServer;
+class QStringList;
+class QTcpServer;
+
+struct CaptureRecord;
+class DataAnalyzer;
+class DsoSettings;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \enum ServerMessageType                                        scopeserver.h
+/// \brief The contents of the messages sent to the clients.
+enum ServerMessageType {
+	SERVER_MESSAGE_REPLY,                   ///< UTF-8 text answering a command
+	SERVER_MESSAGE_FRAME,                   ///< One record in the capture file layout
+	SERVER_MESSAGE_MEASUREMENTS,            ///< A #ServerMeasurement for each used voltage channel
+	SERVER_MESSAGE_COUNT                    ///< Total number of message types
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct ServerMessage                                          scopeserver.h
+/// \brief The header in front of every message sent to a client.
+/// The clients run on the same machine, so all fields are in the byte order of
+/// the host. The payload follows directly after the header.
+struct ServerMessage {
+	char magic[4]; ///< Always #SERVER_MAGIC
+	quint32 type; ///< The #ServerMessageType of the payload
+	quint64 size; ///< Size of the payload in bytes
+	quint64 frame; ///< Number of frames analyzed since the server was started
+	quint32 dropped; ///< Messages dropped for this client since the previous message
+	quint32 reserved; ///< Always 0
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct ServerMeasurement                                      scopeserver.h
+/// \brief The measured values of one voltage channel.
+struct ServerMeasurement {
+	quint32 channel; ///< Number of the voltage channel, the math channel follows the physical ones
+	quint32 reserved; ///< Always 0
+	double amplitude; ///< The amplitude of the signal in V
+	double frequency; ///< The frequency of the signal in Hz
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct ServerClient                                           scopeserver.h
+/// \brief The state of a connected client.
+struct ServerClient {
+	QIODevice *socket; ///< The local or TCP socket of the client
+	QByteArray input; ///< Received bytes that don't form a complete line yet
+	unsigned int frameDecimation; ///< Only every nth frame is sent, 0 if frames aren't subscribed
+	bool packed; ///< true if the voltage samples of the frames are packed
+	unsigned int measurementDecimation; ///< Only every nth measurement is sent, 0 if not subscribed
+	quint32 dropped; ///< Messages dropped since the previous message
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class ScopeServer                                             scopeserver.h
+/// \brief Lets other programs on this machine control the oscilloscope.
+/// Clients connect to a local socket or to a TCP port on the loopback
+/// interface and send commands as text lines. Every reply, frame and
+/// measurement is sent back as #ServerMessage followed by its payload. Clients
+/// that don't read fast enough lose frames instead of stalling the program.
+class ScopeServer : public QObject {
+	Q_OBJECT
+	
+	public:
+		ScopeServer(DsoSettings *settings, DataAnalyzer *dataAnalyzer, QObject *parent = 0);
+		~ScopeServer();
+		
+		bool listen(const QString &name, unsigned int port);
+		void close();
+		unsigned int getClientCount() const;
+	
+	protected:
+		ServerClient *findClient(QObject *socket) const;
+		void addClient(QIODevice *socket);
+		void execute(ServerClient *client, const QByteArray &line);
+		QStringList getKeys() const;
+		QString getValue(const QString &key) const;
+		QString setValue(const QString &key, const QString &value);
+		void sendMessage(ServerClient *client, ServerMessageType type, const QByteArray &payload);
+		
+		static QByteArray serialize(const CaptureRecord *record);
+		
+		DsoSettings *settings; ///< The settings that are queried and changed
+		DataAnalyzer *dataAnalyzer; ///< The analyzer providing the frames
+		
+		QLocalServer *localServer; ///< Accepts local socket connections, 0 if disabled
+		QTcpServer *tcpServer; ///< Accepts loopback TCP connections, 0 if disabled
+		QString localName; ///< The name the local server was started with
+		unsigned int tcpPort; ///< The port the TCP server was started with
+		QList<ServerClient *> clients; ///< The connected clients
+		
+		CaptureRecord *record; ///< The frame that is sent to the clients
+		quint64 frames; ///< Number of frames analyzed since the server was started
+		bool sampling; ///< true while the oscilloscope is sampling
+	
+	public slots:
+		void applySettings();
+		void analyzed(unsigned int samples);
+		void samplingStarted();
+		void samplingStopped();
+	
+	protected slots:
+		void newLocalConnection();
+		void newTcpConnection();
+		void readCommands();
+		void clientDisconnected();
+	
+	signals:
+		void statusMessage(const QString &message, int timeout); ///< Reports listening errors
+		void startRequested(); ///< A client wants to start the sampling
+		void stopRequested(); ///< A client wants to stop the sampling
+		void timebaseRequested(double timebase); ///< A client wants a new timebase
+		void triggerModeRequested(Dso::TriggerMode mode); ///< A client wants a new trigger mode
+		void triggerSlopeRequested(Dso::Slope slope); ///< A client wants a new trigger slope
+		void triggerSourceRequested(bool special, unsigned int id); ///< A client wants a new trigger source
+		void usedRequested(int channel, bool used); ///< A client wants to enable/disable a channel
+		void gainRequested(int channel, double gain); ///< A client wants a new gain
+		void couplingRequested(int channel, Dso::Coupling coupling); ///< A client wants a new coupling
+		void mathModeRequested(Dso::MathMode mode); ///< A client wants a new mode for the math channel
+};
+
+
+#endif
@@ -23,6 +23,7 @@
 
 
 #include <QColor>
+#include <QDir>
 #include <QSettings>
 
 
@@ -30,6 +31,7 @@
 
 #include "dso.h"
 #include "dsowidget.h"
+#include "framering.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -39,13 +41,35 @@ DsoSettings::DsoSettings(QWidget *parent) : QObject(parent) {
 	// Options
 	this->options.alwaysSave = true;
 	this->options.imageSize = QSize(640, 480);
+	this->options.csvLayout = Dso::CSV_ROWS;
+	// Recorder
+	this->options.recorder.path = QDir::homePath();
+	this->options.recorder.decimation = 1;
+	this->options.recorder.queueLength = 64;
+	this->options.recorder.rotateSize = 1024;
+	this->options.recorder.rotateTime = 0;
+	this->options.recorder.compress = true;
+	// Shared memory frame ring
+	this->options.ring.enabled = false;
+	this->options.ring.name = FRAMERING_NAME;
+	this->options.ring.slotCount = 8;
+	this->options.ring.slotSize = 4;
+	// Server
+	this->options.server.enabled = false;
+	this->options.server.name = "openhantek";
+	this->options.server.port = 0;
 	// Main window
 	this->options.window.position = QPoint();
 	this->options.window.size = QSize(800, 600);
 	// Docking windows and toolbars
 	QList<DsoSettingsOptionsWindowPanel *> panels;
+	panels.append(&(this->options.window.dock.decoder));
 	panels.append(&(this->options.window.dock.horizontal));
+	panels.append(&(this->options.window.dock.mask));
+	panels.append(&(this->options.window.dock.peaks));
+	panels.append(&(this->options.window.dock.playback));
 	panels.append(&(this->options.window.dock.spectrum));
+	panels.append(&(this->options.window.dock.statistics));
 	panels.append(&(this->options.window.dock.trigger));
 	panels.append(&(this->options.window.dock.voltage));
 	panels.append(&(this->options.window.toolbar.file));
@@ -56,6 +80,7 @@ DsoSettings::DsoSettings(QWidget *parent) : QObject(parent) {
 		panels[panelId]->position = QPoint();
 		panels[panelId]->visible = true;
 	}
+	this->options.window.dock.playback.visible = false;
 	
 	// Oscilloscope settings
 	// Horizontal axis
@@ -73,11 +98,32 @@ DsoSettings::DsoSettings(QWidget *parent) : QObject(parent) {
 	this->scope.trigger.slope = Dso::SLOPE_POSITIVE;
 	this->scope.trigger.source = 0;
 	this->scope.trigger.special = false;
+	// Decoder
+	this->scope.decoder.enabled = false;
+	this->scope.decoder.protocol = Dso::DECODER_UART;
+	this->scope.decoder.line[0] = 0;
+	this->scope.decoder.line[1] = 1;
+	this->scope.decoder.threshold = 1.5;
+	this->scope.decoder.hysteresis = 0.2;
+	this->scope.decoder.baudrate = 9600;
+	this->scope.decoder.clockSlope = Dso::SLOPE_POSITIVE;
+	// Mask test
+	this->scope.mask.enabled = false;
+	this->scope.mask.channel = 0;
+	this->scope.mask.tolerance = 0.2;
+	this->scope.mask.stopOnFail = false;
+	this->scope.mask.saveFailures = false;
+	this->scope.mask.failurePath = QString();
 	// General
 	this->scope.physicalChannels = 0;
 	this->scope.spectrumLimit = -20.0;
+	this->scope.spectrumMarkers = false;
+	this->scope.spectrumPadding = 1;
+	this->scope.spectrumPeaks = 10;
 	this->scope.spectrumReference = 0.0;
 	this->scope.spectrumWindow = Dso::WINDOW_HANN;
+	this->scope.eyePeriod = 0.0;
+	this->scope.model = QString();
 	
 	
 	// View
@@ -100,9 +146,11 @@ DsoSettings::DsoSettings(QWidget *parent) : QObject(parent) {
 	this->view.antialiasing = true;
 	this->view.digitalPhosphor = false;
 	this->view.digitalPhosphorDepth = 8;
+	this->view.frameRate = 30;
 	this->view.interpolation = Dso::INTERPOLATION_LINEAR;
 	this->view.screenColorImages = false;
 	this->view.zoom = false;
+	this->view.vsync = false;
 }
 
 /// \brief Cleans up.
@@ -212,12 +260,17 @@ int DsoSettings::load(const QString &fileName) {
 	// Docking windows and toolbars
 	settingsLoader->beginGroup("docks");
 	QList<DsoSettingsOptionsWindowPanel *> docks;
+	docks.append(&(this->options.window.dock.decoder));
 	docks.append(&(this->options.window.dock.horizontal));
+	docks.append(&(this->options.window.dock.mask));
+	docks.append(&(this->options.window.dock.peaks));
+	docks.append(&(this->options.window.dock.playback));
 	docks.append(&(this->options.window.dock.spectrum));
+	docks.append(&(this->options.window.dock.statistics));
 	docks.append(&(this->options.window.dock.trigger));
 	docks.append(&(this->options.window.dock.voltage));
 	QStringList dockNames;
-	dockNames << "horizontal" << "spectrum" << "trigger" << "voltage";
+	dockNames << "decoder" << "horizontal" << "mask" << "peaks" << "playback" << "spectrum" << "statistics" << "trigger" << "voltage";
 	for(int dockId = 0; dockId < docks.size(); dockId++) {
 		settingsLoader->beginGroup(dockNames[dockId]);
 		if(settingsLoader->contains("floating"))
@@ -258,6 +311,43 @@ int DsoSettings::load(const QString &fileName) {
 		this->options.alwaysSave = settingsLoader->value("alwaysSave").toBool();
 	if(settingsLoader->contains("imageSize"))
 		this->options.imageSize = settingsLoader->value("imageSize").toSize();
+	if(settingsLoader->contains("csvLayout"))
+		this->options.csvLayout = (Dso::CsvLayout) settingsLoader->value("csvLayout").toInt();
+	// Recorder
+	settingsLoader->beginGroup("recorder");
+	if(settingsLoader->contains("path"))
+		this->options.recorder.path = settingsLoader->value("path").toString();
+	if(settingsLoader->contains("decimation"))
+		this->options.recorder.decimation = settingsLoader->value("decimation").toUInt();
+	if(settingsLoader->contains("queueLength"))
+		this->options.recorder.queueLength = settingsLoader->value("queueLength").toUInt();
+	if(settingsLoader->contains("rotateSize"))
+		this->options.recorder.rotateSize = settingsLoader->value("rotateSize").toUInt();
+	if(settingsLoader->contains("rotateTime"))
+		this->options.recorder.rotateTime = settingsLoader->value("rotateTime").toUInt();
+	if(settingsLoader->contains("compress"))
+		this->options.recorder.compress = settingsLoader->value("compress").toBool();
+	settingsLoader->endGroup();
+	// Shared memory frame ring
+	settingsLoader->beginGroup("ring");
+	if(settingsLoader->contains("enabled"))
+		this->options.ring.enabled = settingsLoader->value("enabled").toBool();
+	if(settingsLoader->contains("name"))
+		this->options.ring.name = settingsLoader->value("name").toString();
+	if(settingsLoader->contains("slotCount"))
+		this->options.ring.slotCount = settingsLoader->value("slotCount").toUInt();
+	if(settingsLoader->contains("slotSize"))
+		this->options.ring.slotSize = settingsLoader->value("slotSize").toUInt();
+	settingsLoader->endGroup();
+	// Server
+	settingsLoader->beginGroup("server");
+	if(settingsLoader->contains("enabled"))
+		this->options.server.enabled = settingsLoader->value("enabled").toBool();
+	if(settingsLoader->contains("name"))
+		this->options.server.name = settingsLoader->value("name").toString();
+	if(settingsLoader->contains("port"))
+		this->options.server.port = settingsLoader->value("port").toUInt();
+	settingsLoader->endGroup();
 	settingsLoader->endGroup();
 	
 	// Oszilloskope settings
@@ -292,6 +382,47 @@ int DsoSettings::load(const QString &fileName) {
 	if(settingsLoader->contains("special"))
 		this->scope.trigger.special = settingsLoader->value("special").toInt();
 	settingsLoader->endGroup();
+	// Decoder
+	settingsLoader->beginGroup("decoder");
+	if(settingsLoader->contains("enabled"))
+		this->scope.decoder.enabled = settingsLoader->value("enabled").toBool();
+	if(settingsLoader->contains("protocol"))
+		this->scope.decoder.protocol = (Dso::DecoderProtocol) settingsLoader->value("protocol").toInt();
+	for(int line = 0; line < DECODER_LINES; line++) {
+		QString name = QString("line%1").arg(line);
+		if(settingsLoader->contains(name))
+			this->scope.decoder.line[line] = settingsLoader->value(name).toUInt();
+	}
+	if(settingsLoader->contains("threshold"))
+		this->scope.decoder.threshold = settingsLoader->value("threshold").toDouble();
+	if(settingsLoader->contains("hysteresis"))
+		this->scope.decoder.hysteresis = settingsLoader->value("hysteresis").toDouble();
+	if(settingsLoader->contains("baudrate"))
+		this->scope.decoder.baudrate = settingsLoader->value("baudrate").toDouble();
+	if(settingsLoader->contains("clockSlope"))
+		this->scope.decoder.clockSlope = (Dso::Slope) settingsLoader->value("clockSlope").toInt();
+	settingsLoader->endGroup();
+	// Mask test
+	settingsLoader->beginGroup("mask");
+	if(settingsLoader->contains("enabled"))
+		this->scope.mask.enabled = settingsLoader->value("enabled").toBool();
+	if(settingsLoader->contains("channel"))
+		this->scope.mask.channel = settingsLoader->value("channel").toUInt();
+	if(settingsLoader->contains("polygon")) {
+		QList<QVariant> points = settingsLoader->value("polygon").toList();
+		this->scope.mask.polygon.clear();
+		for(int point = 0; point < points.count(); point++)
+			this->scope.mask.polygon.append(points[point].toPointF());
+	}
+	if(settingsLoader->contains("tolerance"))
+		this->scope.mask.tolerance = settingsLoader->value("tolerance").toDouble();
+	if(settingsLoader->contains("stopOnFail"))
+		this->scope.mask.stopOnFail = settingsLoader->value("stopOnFail").toBool();
+	if(settingsLoader->contains("saveFailures"))
+		this->scope.mask.saveFailures = settingsLoader->value("saveFailures").toBool();
+	if(settingsLoader->contains("failurePath"))
+		this->scope.mask.failurePath = settingsLoader->value("failurePath").toString();
+	settingsLoader->endGroup();
 	// Spectrum
 	for(int channel = 0; channel < this->scope.spectrum.count(); channel++) {
 		settingsLoader->beginGroup(QString("spectrum%1").arg(channel));
@@ -320,10 +451,18 @@ int DsoSettings::load(const QString &fileName) {
 	}
 	if(settingsLoader->contains("spectrumLimit"))
 		this->scope.spectrumLimit = settingsLoader->value("spectrumLimit").toDouble();
+	if(settingsLoader->contains("spectrumMarkers"))
+		this->scope.spectrumMarkers = settingsLoader->value("spectrumMarkers").toBool();
+	if(settingsLoader->contains("spectrumPadding"))
+		this->scope.spectrumPadding = settingsLoader->value("spectrumPadding").toUInt();
+	if(settingsLoader->contains("spectrumPeaks"))
+		this->scope.spectrumPeaks = settingsLoader->value("spectrumPeaks").toUInt();
 	if(settingsLoader->contains("spectrumReference"))
 		this->scope.spectrumReference = settingsLoader->value("spectrumReference").toDouble();
 	if(settingsLoader->contains("spectrumWindow"))
 		this->scope.spectrumWindow = (Dso::WindowFunction) settingsLoader->value("spectrumWindow").toInt();
+	if(settingsLoader->contains("eyePeriod"))
+		this->scope.eyePeriod = settingsLoader->value("eyePeriod").toDouble();
 	settingsLoader->endGroup();
 	
 	// View
@@ -369,12 +508,16 @@ int DsoSettings::load(const QString &fileName) {
 	// Other view settings
 	if(settingsLoader->contains("digitalPhosphor"))
 		this->view.digitalPhosphor = settingsLoader->value("digitalPhosphor").toBool();
+	if(settingsLoader->contains("frameRate"))
+		this->view.frameRate = settingsLoader->value("frameRate").toInt();
 	if(settingsLoader->contains("interpolation"))
 		this->view.interpolation = (Dso::InterpolationMode) settingsLoader->value("interpolation").toInt();
 	if(settingsLoader->contains("screenColorImages"))
 		this->view.screenColorImages = (Dso::InterpolationMode) settingsLoader->value("screenColorImages").toBool();
 	if(settingsLoader->contains("zoom"))
 		this->view.zoom = (Dso::InterpolationMode) settingsLoader->value("zoom").toBool();
+	if(settingsLoader->contains("vsync"))
+		this->view.vsync = settingsLoader->value("vsync").toBool();
 	settingsLoader->endGroup();
 	
 	delete settingsLoader;
@@ -403,12 +546,17 @@ int DsoSettings::save(const QString &fileName) {
 		// Docking windows and toolbars
 		settingsSaver->beginGroup("docks");
 		QList<DsoSettingsOptionsWindowPanel *> docks;
+		docks.append(&(this->options.window.dock.decoder));
 		docks.append(&(this->options.window.dock.horizontal));
+		docks.append(&(this->options.window.dock.mask));
+		docks.append(&(this->options.window.dock.peaks));
+		docks.append(&(this->options.window.dock.playback));
 		docks.append(&(this->options.window.dock.spectrum));
+		docks.append(&(this->options.window.dock.statistics));
 		docks.append(&(this->options.window.dock.trigger));
 		docks.append(&(this->options.window.dock.voltage));
 		QStringList dockNames;
-		dockNames << "horizontal" << "spectrum" << "trigger" << "voltage";
+		dockNames << "decoder" << "horizontal" << "mask" << "peaks" << "playback" << "spectrum" << "statistics" << "trigger" << "voltage";
 		for(int dockId = 0; dockId < docks.size(); dockId++) {
 			settingsSaver->beginGroup(dockNames[dockId]);
 			settingsSaver->setValue("floating", docks[dockId]->floating);
@@ -438,6 +586,29 @@ int DsoSettings::save(const QString &fileName) {
 		settingsSaver->endGroup();
 		settingsSaver->setValue("alwaysSave", this->options.alwaysSave);
 		settingsSaver->setValue("imageSize", this->options.imageSize);
+		settingsSaver->setValue("csvLayout", this->options.csvLayout);
+		// Recorder
+		settingsSaver->beginGroup("recorder");
+		settingsSaver->setValue("path", this->options.recorder.path);
+		settingsSaver->setValue("decimation", this->options.recorder.decimation);
+		settingsSaver->setValue("queueLength", this->options.recorder.queueLength);
+		settingsSaver->setValue("rotateSize", this->options.recorder.rotateSize);
+		settingsSaver->setValue("rotateTime", this->options.recorder.rotateTime);
+		settingsSaver->setValue("compress", this->options.recorder.compress);
+		settingsSaver->endGroup();
+		// Shared memory frame ring
+		settingsSaver->beginGroup("ring");
+		settingsSaver->setValue("enabled", this->options.ring.enabled);
+		settingsSaver->setValue("name", this->options.ring.name);
+		settingsSaver->setValue("slotCount", this->options.ring.slotCount);
+		settingsSaver->setValue("slotSize", this->options.ring.slotSize);
+		settingsSaver->endGroup();
+		// Server
+		settingsSaver->beginGroup("server");
+		settingsSaver->setValue("enabled", this->options.server.enabled);
+		settingsSaver->setValue("name", this->options.server.name);
+		settingsSaver->setValue("port", this->options.server.port);
+		settingsSaver->endGroup();
 		settingsSaver->endGroup();
 	}
 	// Oszilloskope settings
@@ -458,6 +629,30 @@ int DsoSettings::save(const QString &fileName) {
 	settingsSaver->setValue("slope", this->scope.trigger.slope);
 	settingsSaver->setValue("source", this->scope.trigger.source);
 	settingsSaver->endGroup();
+	// Decoder
+	settingsSaver->beginGroup("decoder");
+	settingsSaver->setValue("enabled", this->scope.decoder.enabled);
+	settingsSaver->setValue("protocol", this->scope.decoder.protocol);
+	for(int line = 0; line < DECODER_LINES; line++)
+		settingsSaver->setValue(QString("line%1").arg(line), this->scope.decoder.line[line]);
+	settingsSaver->setValue("threshold", this->scope.decoder.threshold);
+	settingsSaver->setValue("hysteresis", this->scope.decoder.hysteresis);
+	settingsSaver->setValue("baudrate", this->scope.decoder.baudrate);
+	settingsSaver->setValue("clockSlope", this->scope.decoder.clockSlope);
+	settingsSaver->endGroup();
+	// Mask test
+	settingsSaver->beginGroup("mask");
+	settingsSaver->setValue("enabled", this->scope.mask.enabled);
+	settingsSaver->setValue("channel", this->scope.mask.channel);
+	QList<QVariant> points;
+	for(int point = 0; point < this->scope.mask.polygon.count(); point++)
+		points.append(this->scope.mask.polygon[point]);
+	settingsSaver->setValue("polygon", points);
+	settingsSaver->setValue("tolerance", this->scope.mask.tolerance);
+	settingsSaver->setValue("stopOnFail", this->scope.mask.stopOnFail);
+	settingsSaver->setValue("saveFailures", this->scope.mask.saveFailures);
+	settingsSaver->setValue("failurePath", this->scope.mask.failurePath);
+	settingsSaver->endGroup();
 	// Spectrum
 	for(int channel = 0; channel < this->scope.spectrum.count(); channel++) {
 		settingsSaver->beginGroup(QString("spectrum%1").arg(channel));
@@ -477,8 +672,12 @@ int DsoSettings::save(const QString &fileName) {
 		settingsSaver->endGroup();
 	}
 	settingsSaver->setValue("spectrumLimit", this->scope.spectrumLimit);
+	settingsSaver->setValue("spectrumMarkers", this->scope.spectrumMarkers);
+	settingsSaver->setValue("spectrumPadding", this->scope.spectrumPadding);
+	settingsSaver->setValue("spectrumPeaks", this->scope.spectrumPeaks);
 	settingsSaver->setValue("spectrumReference", this->scope.spectrumReference);
 	settingsSaver->setValue("spectrumWindow", this->scope.spectrumWindow);
+	settingsSaver->setValue("eyePeriod", this->scope.eyePeriod);
 	settingsSaver->endGroup();
 	
 	// View
@@ -514,8 +713,10 @@ int DsoSettings::save(const QString &fileName) {
 	// Other view settings
 	settingsSaver->setValue("digitalPhosphor", this->view.digitalPhosphor);
 	if(complete) {
+		settingsSaver->setValue("frameRate", this->view.frameRate);
 		settingsSaver->setValue("interpolation", this->view.interpolation);
 		settingsSaver->setValue("screenColorImages", this->view.screenColorImages);
+		settingsSaver->setValue("vsync", this->view.vsync);
 	}
 	settingsSaver->setValue("zoom", this->view.zoom);
 	settingsSaver->endGroup();
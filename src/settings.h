@@ -31,6 +31,7 @@
 #include <QList>
 #include <QObject>
 #include <QPoint>
+#include <QPolygonF>
 #include <QSize>
 #include <QString>
 
@@ -51,8 +52,13 @@ struct DsoSettingsOptionsWindowPanel {
 /// \struct DsoSettingsOptionsWindowDock                              settings.h
 /// \brief Holds the layout of the docking windows.
 struct DsoSettingsOptionsWindowDock {
+	DsoSettingsOptionsWindowPanel decoder; ///< "Decoder" docking window
 	DsoSettingsOptionsWindowPanel horizontal; ///< "Horizontal" docking window
+	DsoSettingsOptionsWindowPanel mask; ///< "Mask test" docking window
+	DsoSettingsOptionsWindowPanel peaks; ///< "Peaks" docking window
+	DsoSettingsOptionsWindowPanel playback; ///< "Playback" docking window
 	DsoSettingsOptionsWindowPanel spectrum; ///< "Spectrum" docking window
+	DsoSettingsOptionsWindowPanel statistics; ///< "Statistics" docking window
 	DsoSettingsOptionsWindowPanel trigger; ///< "Trigger" docking window
 	DsoSettingsOptionsWindowPanel voltage; ///< "Voltage" docking window
 };
@@ -76,12 +82,47 @@ struct DsoSettingsOptionsWindow {
 	DsoSettingsOptionsWindowToolbar toolbar; ///< Toolbars
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// \struct DsoSettingsOptionsRecorder                                settings.h
+/// \brief Holds the settings for the background recording.
+struct DsoSettingsOptionsRecorder {
+	QString path; ///< The folder the recordings are written to
+	unsigned int decimation; ///< Only every nth frame is recorded
+	unsigned int queueLength; ///< Maximum number of frames waiting to be written
+	unsigned int rotateSize; ///< Maximum file size in MiB, 0 disables it
+	unsigned int rotateTime; ///< Maximum file age in minutes, 0 disables it
+	bool compress; ///< true if the voltage samples are packed losslessly
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct DsoSettingsOptionsRing                                    settings.h
+/// \brief Holds the settings for the shared memory frame ring.
+struct DsoSettingsOptionsRing {
+	bool enabled; ///< true if the frames are published
+	QString name; ///< The name of the shared memory object
+	unsigned int slotCount; ///< Number of frames kept in the ring
+	unsigned int slotSize; ///< Size of each slot in MiB
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct DsoSettingsOptionsServer                                  settings.h
+/// \brief Holds the settings for the remote control server.
+struct DsoSettingsOptionsServer {
+	bool enabled; ///< true if clients can connect
+	QString name; ///< The name of the local socket, empty disables it
+	unsigned int port; ///< The TCP port on the loopback interface, 0 disables it
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \struct DsoSettingsOptions                                        settings.h
 /// \brief Holds the general options of the program.
 struct DsoSettingsOptions {
 	bool alwaysSave; ///< Always save the settings on exit
 	QSize imageSize; ///< Size of exported images in pixels
+	Dso::CsvLayout csvLayout; ///< Table layout of exported CSV files
+	DsoSettingsOptionsRecorder recorder; ///< Background recording
+	DsoSettingsOptionsRing ring; ///< Shared memory frame ring
+	DsoSettingsOptionsServer server; ///< Remote control server
 	DsoSettingsOptionsWindow window; ///< Window layout
 };
 
@@ -131,12 +172,40 @@ struct DsoSettingsScopeVoltage {
 	bool used; ///< true if this channel is enabled
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// \struct DsoSettingsScopeDecoder                                   settings.h
+/// \brief Holds the settings for the serial protocol decoder.
+struct DsoSettingsScopeDecoder {
+	bool enabled; ///< true if the decoder is running
+	Dso::DecoderProtocol protocol; ///< The decoded protocol
+	unsigned int line[DECODER_LINES]; ///< Channels for RX (UART), clock/data (SPI), SCL/SDA (I2C)
+	double threshold; ///< Logic threshold in V
+	double hysteresis; ///< Width of the hysteresis band around the threshold in V
+	double baudrate; ///< The bitrate for UART in bit/s
+	Dso::Slope clockSlope; ///< The clock edge that samples the SPI data line
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \struct DsoSettingsScopeMask                                      settings.h
+/// \brief Holds the settings for the mask test.
+struct DsoSettingsScopeMask {
+	bool enabled; ///< true if the frames are tested
+	unsigned int channel; ///< The tested channel
+	QPolygonF polygon; ///< The allowed area in divs
+	double tolerance; ///< Distance between trace and mask created from a trace in divs
+	bool stopOnFail; ///< true if the sampling should be stopped on a failure
+	bool saveFailures; ///< true if failing frames are saved
+	QString failurePath; ///< The directory the failing frames are saved to
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \struct DsoSettingsScope                                          settings.h
 /// \brief Holds the settings for the oscilloscope.
 struct DsoSettingsScope {
 	DsoSettingsScopeHorizontal horizontal; ///< Settings for the horizontal axis
 	DsoSettingsScopeTrigger trigger; ///< Settings for the trigger
+	DsoSettingsScopeDecoder decoder; ///< Settings for the protocol decoder
+	DsoSettingsScopeMask mask; ///< Settings for the mask test
 	QList<DsoSettingsScopeSpectrum> spectrum; ///< Spectrum analysis settings
 	QList<DsoSettingsScopeVoltage> voltage; ///< Settings for the normal graphs
 	
@@ -144,6 +213,11 @@ struct DsoSettingsScope {
 	Dso::WindowFunction spectrumWindow; ///< Window function for DFT
 	double spectrumReference; ///< Reference level for spectrum in dBm
 	double spectrumLimit; ///< Minimum magnitude of the spectrum (Avoids peaks)
+	bool spectrumMarkers; ///< true if spectrum and measurements only use the samples between the markers
+	unsigned int spectrumPadding; ///< Zero-padding factor for the spectrum, 1 disables it
+	unsigned int spectrumPeaks; ///< Number of peaks listed for each spectrum
+	double eyePeriod; ///< Symbol period for the eye diagram in s, 0 recovers it
+	QString model; ///< Name of the connected oscilloscope model, not saved
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -176,9 +250,11 @@ struct DsoSettingsView {
 	bool antialiasing; ///< Antialiasing for the graphs
 	bool digitalPhosphor; ///< true slowly fades out the previous graphs
 	int digitalPhosphorDepth; ///< Number of channels shown at one time
+	int frameRate; ///< Maximum number of drawn frames per second, 0 for no limit
 	Dso::InterpolationMode interpolation; ///< Interpolation mode for the graph
 	bool screenColorImages; ///< true exports images with screen colors
 	bool zoom; ///< true if the magnified scope is enabled
+	bool vsync; ///< true synchronizes the buffer swaps to the vertical retrace
 };
 
 ////////////////////////////////////////////////////////////////////////////////
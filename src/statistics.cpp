@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+//  statistics.cpp
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+#include <cstring>
+
+#include <qnumeric.h>
+
+
+#include "statistics.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// class RunningStatistics
+/// \brief Initializes empty statistics.
+RunningStatistics::RunningStatistics() {
+	this->reset();
+}
+
+/// \brief Adds a value to the statistics.
+/// \param value The new measurement value.
+void RunningStatistics::add(double value) {
+	// Infinite values can't be binned, failed measurements are ignored
+	if(!qIsFinite(value))
+		return;
+	
+	// Welford's algorithm for mean and variance
+	this->count++;
+	double delta = value - this->mean;
+	this->mean += delta / this->count;
+	this->squaredDeviations += delta * (value - this->mean);
+	
+	if(this->count == 1) {
+		this->minimum = this->maximum = value;
+		this->histogramStart = value;
+		this->histogram[0] = 1;
+		return;
+	}
+	if(value < this->minimum)
+		this->minimum = value;
+	else if(value > this->maximum)
+		this->maximum = value;
+	
+	// All previous values were equal, get a range from the first different one
+	if(this->binWidth == 0) {
+		if(value == this->histogramStart) {
+			this->histogram[0]++;
+			return;
+		}
+		
+		double range = fabs(value - this->histogramStart);
+		unsigned long int equalCount = this->histogram[0];
+		this->histogram[0] = 0;
+		this->binWidth = range * 2 / STATISTICS_BINS;
+		double previous = this->histogramStart;
+		this->histogramStart = ((value < previous) ? value : previous) - range / 2;
+		this->histogram[(int) ((previous - this->histogramStart) / this->binWidth)] = equalCount;
+	}
+	
+	// Double the bin width until the value is inside of the histogram
+	while(value < this->histogramStart || value >= this->histogramStart + this->binWidth * STATISTICS_BINS) {
+		bool below = value < this->histogramStart;
+		unsigned long int merged[STATISTICS_BINS / 2];
+		for(int bin = 0; bin < STATISTICS_BINS / 2; bin++)
+			merged[bin] = this->histogram[bin * 2] + this->histogram[bin * 2 + 1];
+		
+		// The previous range is moved into the upper half when extending downwards
+		memset(this->histogram, 0, sizeof(this->histogram));
+		memcpy(this->histogram + (below ? STATISTICS_BINS / 2 : 0), merged, sizeof(merged));
+		if(below)
+			this->histogramStart -= this->binWidth * STATISTICS_BINS;
+		this->binWidth *= 2;
+	}
+	
+	int bin = (int) ((value - this->histogramStart) / this->binWidth);
+	if(bin < 0)
+		bin = 0;
+	else if(bin >= STATISTICS_BINS)
+		bin = STATISTICS_BINS - 1;
+	this->histogram[bin]++;
+}
+
+/// \brief Removes all values.
+void RunningStatistics::reset() {
+	this->count = 0;
+	this->mean = 0;
+	this->squaredDeviations = 0;
+	this->minimum = 0;
+	this->maximum = 0;
+	
+	memset(this->histogram, 0, sizeof(this->histogram));
+	this->histogramStart = 0;
+	this->binWidth = 0;
+}
+
+/// \brief Returns the number of values.
+/// \return Values added since the last reset.
+unsigned long int RunningStatistics::getCount() const {
+	return this->count;
+}
+
+/// \brief Returns the mean of the values.
+/// \return The arithmetic mean, 0 if there are no values.
+double RunningStatistics::getMean() const {
+	return this->mean;
+}
+
+/// \brief Returns the standard deviation of the values.
+/// \return The sample standard deviation, 0 if there are less than two values.
+double RunningStatistics::getStandardDeviation() const {
+	if(this->count < 2)
+		return 0;
+	
+	return sqrt(this->squaredDeviations / (this->count - 1));
+}
+
+/// \brief Returns the smallest value.
+/// \return The minimum, 0 if there are no values.
+double RunningStatistics::getMinimum() const {
+	return this->minimum;
+}
+
+/// \brief Returns the largest value.
+/// \return The maximum, 0 if there are no values.
+double RunningStatistics::getMaximum() const {
+	return this->maximum;
+}
+
+/// \brief Returns the histogram.
+/// \return Array with the number of values for all #STATISTICS_BINS bins.
+const unsigned long int *RunningStatistics::getHistogram() const {
+	return this->histogram;
+}
+
+/// \brief Returns the lower limit of the histogram.
+/// \return The lower limit of the first bin.
+double RunningStatistics::getHistogramStart() const {
+	return this->histogramStart;
+}
+
+/// \brief Returns the width of the histogram bins.
+/// \return The width of each bin, 0 if all values are in the first bin.
+double RunningStatistics::getBinWidth() const {
+	return this->binWidth;
+}
@@ -0,0 +1,70 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  OpenHantek
+/// \file statistics.h
+/// \brief Declares the RunningStatistics class.
+//
+//  Copyright (C) 2011  Oliver Haag
+//  oliver.haag@gmail.com
+//
+//  This program is free software: you can redistribute it and/or modify it
+//  under the terms of the GNU General Public License as published by the Free
+//  Software Foundation, either version 3 of the License, or (at your option)
+//  any later version.
+//
+//  This program is distributed in the hope that it will be useful, but WITHOUT
+//  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//  more details.
+//
+//  You should have received a copy of the GNU General Public License along with
+//  this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+
+#define STATISTICS_BINS              64 ///< Number of histogram bins, has to be even
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class RunningStatistics                                         statistics.h
+/// \brief Accumulates a measurement over many acquisitions.
+/// Mean and variance are updated with Welford's algorithm, the histogram has a
+/// fixed number of bins whose width is doubled by merging neighbouring bins
+/// when a value is outside of the range. So adding a value is O(1) and the
+/// memory usage doesn't grow with the number of acquisitions.
+class RunningStatistics {
+	public:
+		RunningStatistics();
+		
+		void add(double value);
+		void reset();
+		
+		unsigned long int getCount() const;
+		double getMean() const;
+		double getStandardDeviation() const;
+		double getMinimum() const;
+		double getMaximum() const;
+		
+		const unsigned long int *getHistogram() const;
+		double getHistogramStart() const;
+		double getBinWidth() const;
+	
+	protected:
+		unsigned long int count; ///< Number of values
+		double mean; ///< The running mean
+		double squaredDeviations; ///< Sum of the squared deviations from the mean
+		double minimum; ///< The smallest value
+		double maximum; ///< The largest value
+		
+		unsigned long int histogram[STATISTICS_BINS]; ///< Number of values in each bin
+		double histogramStart; ///< Lower limit of the first bin
+		double binWidth; ///< Width of each bin, 0 as long as all values were equal
+};
+
+
+#endif